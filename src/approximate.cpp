@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include "approximate.h"
+#include "distance.h"
+
+
+static float edgeSlope(unsigned char from, unsigned char to, float pixelDistance, float pixelHeight) {
+	return std::abs(static_cast<float>(to) - static_cast<float>(from)) * pixelHeight / pixelDistance;
+}
+
+
+/*********
+Steepest slope of the 4 edges of every voxel of the original height map.
+**********/
+static std::vector<float> findVoxelSlopes(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight) {
+	int voxelWidth = imageWidth - 1;
+	int voxelHeight = imageHeight - 1;
+	std::vector<float> slopes(voxelWidth * voxelHeight);
+	for (int y = 0; y < voxelHeight; ++y) {
+		for (int x = 0; x < voxelWidth; ++x) {
+			unsigned char h00 = heightdata[y * imageWidth + x];
+			unsigned char h10 = heightdata[y * imageWidth + x + 1];
+			unsigned char h01 = heightdata[(y + 1) * imageWidth + x];
+			unsigned char h11 = heightdata[(y + 1) * imageWidth + x + 1];
+			slopes[y * voxelWidth + x] = std::max(
+				std::max(edgeSlope(h00, h10, pixelDistance, pixelHeight), edgeSlope(h01, h11, pixelDistance, pixelHeight)),
+				std::max(edgeSlope(h00, h01, pixelDistance, pixelHeight), edgeSlope(h10, h11, pixelDistance, pixelHeight)));
+		}
+	}
+
+	return slopes;
+}
+
+
+/*********
+Merge the voxel slopes of a level into the voxels of the next level. Coarse voxel x covers fine voxels 2x and 2x + 1,
+and the last coarse voxel also covers the fine voxels left over by the decimation.
+**********/
+static std::vector<float> mergeVoxelSlopes(const std::vector<float>& fine, int fineWidth, int fineHeight, int coarseWidth, int coarseHeight) {
+	std::vector<float> coarse(coarseWidth * coarseHeight, 0.0f);
+	for (int y = 0; y < coarseHeight; ++y) {
+		int lastChildY = y == coarseHeight - 1 ? fineHeight - 1 : 2 * y + 1;
+		for (int x = 0; x < coarseWidth; ++x) {
+			int lastChildX = x == coarseWidth - 1 ? fineWidth - 1 : 2 * x + 1;
+			float& slope = coarse[y * coarseWidth + x];
+			for (int childY = 2 * y; childY <= lastChildY; ++childY) {
+				for (int childX = 2 * x; childX <= lastChildX; ++childX) {
+					slope = std::max(slope, fine[childY * fineWidth + childX]);
+				}
+			}
+		}
+	}
+
+	return coarse;
+}
+
+
+static std::vector<float> dilateVoxelSlopes(const std::vector<float>& slopes, int voxelWidth, int voxelHeight) {
+	std::vector<float> dilated(slopes.size(), 0.0f);
+	for (int y = 0; y < voxelHeight; ++y) {
+		for (int x = 0; x < voxelWidth; ++x) {
+			float& slope = dilated[y * voxelWidth + x];
+			for (int neighbourY = std::max(y - 1, 0); neighbourY <= std::min(y + 1, voxelHeight - 1); ++neighbourY) {
+				for (int neighbourX = std::max(x - 1, 0); neighbourX <= std::min(x + 1, voxelWidth - 1); ++neighbourX) {
+					slope = std::max(slope, slopes[neighbourY * voxelWidth + neighbourX]);
+				}
+			}
+		}
+	}
+
+	return dilated;
+}
+
+
+static glm::ivec2 snapToLevel(glm::ivec2 pixel, int level, const PyramidLevel& pyramidLevel) {
+	glm::ivec2 snapped = (pixel + (1 << level >> 1)) >> level;
+	return glm::clamp(snapped, glm::ivec2(0), glm::ivec2(pyramidLevel.imageWidth - 1, pyramidLevel.imageHeight - 1));
+}
+
+
+/*********
+calcSurfaceDistance gives 0 for lines on the last row or column, which no bound can account for.
+**********/
+static bool isOnLastRowOrColumn(glm::ivec2 begin, glm::ivec2 end, int imageWidth, int imageHeight) {
+	return (begin.y == end.y && begin.y == imageHeight - 1) || (begin.x == end.x && begin.x == imageWidth - 1);
+}
+
+
+HeightPyramid::HeightPyramid(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight)
+	: _pixelHeight{pixelHeight}
+{
+	_levels.push_back(PyramidLevel{ imageWidth, imageHeight, pixelDistance, heightdata, std::vector<float>() });
+
+	std::vector<float> voxelSlopes = findVoxelSlopes(heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+	while (true) {
+		const PyramidLevel& fine = _levels.back();
+		int coarseWidth = (fine.imageWidth - 1) / 2 + 1;
+		int coarseHeight = (fine.imageHeight - 1) / 2 + 1;
+		if (coarseWidth < 2 || coarseHeight < 2) {
+			break;
+		}
+
+		PyramidLevel coarse{ coarseWidth, coarseHeight, fine.pixelDistance * 2.0f, std::vector<unsigned char>(coarseWidth * coarseHeight), std::vector<float>() };
+		for (int y = 0; y < coarseHeight; ++y) {
+			for (int x = 0; x < coarseWidth; ++x) {
+				coarse.heightdata[y * coarseWidth + x] = fine.heightdata[2 * y * fine.imageWidth + 2 * x];
+			}
+		}
+
+		voxelSlopes = mergeVoxelSlopes(voxelSlopes, fine.imageWidth - 1, fine.imageHeight - 1, coarseWidth - 1, coarseHeight - 1);
+		coarse.slopeBounds = dilateVoxelSlopes(voxelSlopes, coarseWidth - 1, coarseHeight - 1);
+		_levels.push_back(std::move(coarse));
+	}
+}
+
+
+int HeightPyramid::getLevelCount() const {
+	return static_cast<int>(_levels.size());
+}
+
+
+const PyramidLevel& HeightPyramid::getLevel(int level) const {
+	return _levels[level];
+}
+
+
+float HeightPyramid::getPixelHeight() const {
+	return _pixelHeight;
+}
+
+
+ApproximateDistance calcApproximateSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const HeightPyramid& pyramid, float tolerance) {
+	const PyramidLevel& original = pyramid.getLevel(0);
+	float pixelHeight = pyramid.getPixelHeight();
+	if (begin != end && !isOnLastRowOrColumn(begin, end, original.imageWidth, original.imageHeight)) {
+		float planarLength = glm::length(static_cast<glm::vec2>(end - begin)) * original.pixelDistance;
+		for (int level = pyramid.getLevelCount() - 1; level > 0; --level) {
+			const PyramidLevel& coarse = pyramid.getLevel(level);
+			glm::ivec2 coarseBegin = snapToLevel(begin, level, coarse);
+			glm::ivec2 coarseEnd = snapToLevel(end, level, coarse);
+			if (coarseBegin == coarseEnd || isOnLastRowOrColumn(coarseBegin, coarseEnd, coarse.imageWidth, coarse.imageHeight)) {
+				continue;
+			}
+
+			float maxSlope = 0.0f;
+			VoxelTraversal traversal(coarseBegin, coarseEnd, coarse.imageWidth - 1, coarse.imageHeight - 1);
+			glm::ivec2 voxel;
+			while (traversal.next(voxel)) {
+				maxSlope = std::max(maxSlope, coarse.slopeBounds[voxel.y * (coarse.imageWidth - 1) + voxel.x]);
+			}
+
+			float stretch = std::sqrt(1.0f + 2.0f * maxSlope * maxSlope);
+			float coarsePlanarLength = glm::length(static_cast<glm::vec2>(coarseEnd - coarseBegin)) * coarse.pixelDistance;
+			float errorBound = std::max(planarLength * stretch - coarsePlanarLength, coarsePlanarLength * stretch - planarLength);
+			if (errorBound <= tolerance) {
+				float distance = calcSurfaceDistance(coarseBegin, coarseEnd, coarse.heightdata, coarse.imageWidth, coarse.imageHeight, coarse.pixelDistance, pixelHeight);
+				return ApproximateDistance{ distance, errorBound, level };
+			}
+		}
+	}
+
+	float distance = calcSurfaceDistance(begin, end, original.heightdata, original.imageWidth, original.imageHeight, original.pixelDistance, pixelHeight);
+	return ApproximateDistance{ distance, 0.0f, 0 };
+}
@@ -0,0 +1,63 @@
+#ifndef APPROXIMATE_H
+#define APPROXIMATE_H
+
+#include <vector>
+#include "glm/glm.hpp"
+
+
+/*********
+One level of a HeightPyramid. Level k keeps every 2^k-th sample of the original height map, so its pixelDistance is 2^k times larger.
+slopeBounds holds, for every voxel of the level, the steepest slope (rise over run) of any original pixel edge
+in the voxel and its 8 neighbours. The last voxel of a row or column also covers the pixels decimation dropped.
+**********/
+struct PyramidLevel {
+	int imageWidth;
+	int imageHeight;
+	float pixelDistance;
+	std::vector<unsigned char> heightdata;
+	std::vector<float> slopeBounds;
+};
+
+
+/*********
+Height map at 2x decimated resolutions, with per-voxel slope bounds that limit how far distances at a coarse level can be off.
+Level 0 is a copy of the original height map. Levels are added while both sides still have at least 2 samples.
+**********/
+class HeightPyramid {
+public:
+	HeightPyramid(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+	int getLevelCount() const;
+
+	const PyramidLevel& getLevel(int level) const;
+
+	float getPixelHeight() const;
+
+private:
+	std::vector<PyramidLevel> _levels;
+	float _pixelHeight;
+};
+
+
+/*********
+Result of an approximate query: the distance found at the given pyramid level and a bound on how far it is from calcSurfaceDistance at level 0.
+**********/
+struct ApproximateDistance {
+	float distance;
+	float errorBound;
+	int level;
+};
+
+
+/*********
+Find the surface distance at the coarsest pyramid level whose error bound is within tolerance (meter). begin and end are level 0 pixels.
+At level k the endpoints snap to the nearest kept sample and calcSurfaceDistance runs on the level's samples.
+With P and P' the planar length of the original and snapped line, and G the steepest pixel edge slope around the snapped line,
+every line over the triangulated surface has a length between P and P * sqrt(1 + 2G^2), since a triangle's slope is at most sqrt(2) times its edge slopes
+and the coarse edge slopes are averages of the original ones. The reported bound is max(P * s - P', P' * s - P) with s = sqrt(1 + 2G^2).
+If no coarse level fits, level 0 is used and the bound is 0.
+**********/
+ApproximateDistance calcApproximateSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const HeightPyramid& pyramid, float tolerance);
+
+
+#endif // !APPROXIMATE_H
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include "axis_tables.h"
+#include "distance.h"
+
+
+static const int COLUMN_BLOCK_SIZE = 64;
+
+// the offsets along a block stay small enough that a float keeps them to far below the rounding of calcSurfaceDistance
+static const std::size_t PREFIX_BLOCK_SIZE = 64;
+
+
+struct PixelPositions {
+	const std::vector<unsigned char>& heightdata;
+	int imageWidth;
+	float pixelDistance;
+	float pixelHeight;
+
+	glm::vec3 operator()(int x, int y) const {
+		return glm::vec3(pixelDistance * x, pixelDistance * y, heightdata[y * imageWidth + x] * pixelHeight);
+	}
+
+	float edgeLength(glm::ivec2 from, glm::ivec2 to) const {
+		return glm::distance((*this)(from.x, from.y), (*this)(to.x, to.y));
+	}
+
+	/*********
+	Length of the line from corner (x, y) to corner (x + 1, y + 1) of a voxel. It bends where it crosses the voxel diagonal.
+	**********/
+	float crossVoxelLength(int x, int y) const {
+		glm::vec3 diagonalFrom = (*this)(x + 1, y);
+		glm::vec3 middle = diagonalFrom + 0.5f * ((*this)(x, y + 1) - diagonalFrom);
+		return glm::distance((*this)(x, y), middle) + glm::distance(middle, (*this)(x + 1, y + 1));
+	}
+};
+
+
+AxisDistanceTables::AxisDistanceTables(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight, ThreadPool& pool,
+	unsigned lines)
+	: _imageWidth{imageWidth}, _imageHeight{imageHeight}
+{
+	PixelPositions positions{ heightdata, imageWidth, pixelDistance, pixelHeight };
+	std::size_t pixelCount = static_cast<std::size_t>(imageWidth) * imageHeight;
+	std::size_t diagonalCount = imageWidth + imageHeight - 1;
+
+	if (lines & ROWS) {
+		_rows.allocate(pixelCount, imageHeight, imageWidth);
+		pool.parallelFor(imageHeight, [&](std::size_t row) {
+			int y = static_cast<int>(row);
+			double sum = 0.0;
+			_rows.set(pixelIndex(glm::ivec2(0, y)), row, 0, sum);
+			for (int x = 1; x < imageWidth; ++x) {
+				sum += positions.edgeLength(glm::ivec2(x - 1, y), glm::ivec2(x, y));
+				_rows.set(pixelIndex(glm::ivec2(x, y)), row, x, sum);
+			}
+		});
+	}
+
+	// the columns are walked a block of them at a time so the walk goes along the rows in memory
+	if (lines & COLUMNS) {
+		_columns.allocate(pixelCount, imageWidth, imageHeight);
+		std::size_t columnBlockCount = (imageWidth + COLUMN_BLOCK_SIZE - 1) / COLUMN_BLOCK_SIZE;
+		pool.parallelFor(columnBlockCount, [&](std::size_t block) {
+			int firstX = static_cast<int>(block) * COLUMN_BLOCK_SIZE;
+			int lastX = std::min(firstX + COLUMN_BLOCK_SIZE, imageWidth);
+			double sums[COLUMN_BLOCK_SIZE] = {};
+			for (int y = 0; y < imageHeight; ++y) {
+				for (int x = firstX; x < lastX; ++x) {
+					if (y > 0) {
+						sums[x - firstX] += positions.edgeLength(glm::ivec2(x, y - 1), glm::ivec2(x, y));
+					}
+
+					_columns.set(pixelIndex(glm::ivec2(x, y)), x, y, sums[x - firstX]);
+				}
+			}
+		});
+	}
+
+	// diagonal d starts at (d, 0) for d < imageWidth and at (0, d - imageWidth + 1) otherwise
+	if (lines & DIAGONALS) {
+		_diagonals.allocate(pixelCount, diagonalCount, std::min(imageWidth, imageHeight));
+		pool.parallelFor(diagonalCount, [&](std::size_t diagonal) {
+			int d = static_cast<int>(diagonal);
+			glm::ivec2 pixel = d < imageWidth ? glm::ivec2(d, 0) : glm::ivec2(0, d - imageWidth + 1);
+			double sum = 0.0;
+			for (std::size_t position = 0; pixel.x < imageWidth && pixel.y < imageHeight; ++pixel, ++position) {
+				if (position > 0) {
+					sum += positions.crossVoxelLength(pixel.x - 1, pixel.y - 1);
+				}
+
+				_diagonals.set(pixelIndex(pixel), diagonal, position, sum);
+			}
+		});
+	}
+
+	// anti-diagonal d starts at (0, d) for d < imageHeight and at (d - imageHeight + 1, imageHeight - 1) otherwise
+	if (lines & ANTI_DIAGONALS) {
+		_antiDiagonals.allocate(pixelCount, diagonalCount, std::min(imageWidth, imageHeight));
+		pool.parallelFor(diagonalCount, [&](std::size_t diagonal) {
+			int d = static_cast<int>(diagonal);
+			glm::ivec2 pixel = d < imageHeight ? glm::ivec2(0, d) : glm::ivec2(d - imageHeight + 1, imageHeight - 1);
+			double sum = 0.0;
+			for (std::size_t position = 0; pixel.x < imageWidth && pixel.y >= 0; pixel += glm::ivec2(1, -1), ++position) {
+				if (position > 0) {
+					sum += positions.edgeLength(pixel + glm::ivec2(-1, 1), pixel);
+				}
+
+				_antiDiagonals.set(pixelIndex(pixel), diagonal, position, sum);
+			}
+		});
+	}
+}
+
+
+bool AxisDistanceTables::lookupSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, float& distance) const {
+	glm::ivec2 delta = end - begin;
+	if ((delta.x == 0 && delta.y == 0) || !isInside(begin) || !isInside(end)) {
+		return false;
+	}
+
+	// calcSurfaceDistance finds no voxel for lines on the last row or column, so they are left to it
+	double sum;
+	if (delta.y == 0) {
+		if (begin.y >= _imageHeight - 1 || _rows.empty()) {
+			return false;
+		}
+
+		sum = _rows.get(pixelIndex(end), end.y, end.x) - _rows.get(pixelIndex(begin), begin.y, begin.x);
+	}
+	else if (delta.x == 0) {
+		if (begin.x >= _imageWidth - 1 || _columns.empty()) {
+			return false;
+		}
+
+		sum = _columns.get(pixelIndex(end), end.x, end.y) - _columns.get(pixelIndex(begin), begin.x, begin.y);
+	}
+	else if (delta.x == delta.y) {
+		if (_diagonals.empty()) {
+			return false;
+		}
+
+		// the diagonal through the pixel has x - y constant, and the position along it is how far it is from its start
+		std::size_t diagonal = begin.x >= begin.y ? begin.x - begin.y : _imageWidth - 1 + begin.y - begin.x;
+		sum = _diagonals.get(pixelIndex(end), diagonal, std::min(end.x, end.y)) - _diagonals.get(pixelIndex(begin), diagonal, std::min(begin.x, begin.y));
+	}
+	else if (delta.x == -delta.y) {
+		if (_antiDiagonals.empty()) {
+			return false;
+		}
+
+		std::size_t diagonal = begin.x + begin.y;
+		sum = _antiDiagonals.get(pixelIndex(end), diagonal, std::min(end.x, _imageHeight - 1 - end.y))
+			- _antiDiagonals.get(pixelIndex(begin), diagonal, std::min(begin.x, _imageHeight - 1 - begin.y));
+	}
+	else {
+		return false;
+	}
+
+	distance = static_cast<float>(glm::abs(sum));
+	return true;
+}
+
+
+int AxisDistanceTables::getImageWidth() const {
+	return _imageWidth;
+}
+
+
+int AxisDistanceTables::getImageHeight() const {
+	return _imageHeight;
+}
+
+
+void AxisDistanceTables::PrefixTable::allocate(std::size_t pixelCount, std::size_t lineCount, std::size_t maxLineLength) {
+	blocksPerLine = (maxLineLength + PREFIX_BLOCK_SIZE - 1) / PREFIX_BLOCK_SIZE;
+	blockSums.assign(lineCount * blocksPerLine, 0.0);
+	offsets.assign(pixelCount, 0.0f);
+}
+
+
+void AxisDistanceTables::PrefixTable::set(std::size_t pixel, std::size_t line, std::size_t position, double sum) {
+	double& blockSum = blockSums[line * blocksPerLine + position / PREFIX_BLOCK_SIZE];
+	if (position % PREFIX_BLOCK_SIZE == 0) {
+		blockSum = sum;
+	}
+
+	offsets[pixel] = static_cast<float>(sum - blockSum);
+}
+
+
+double AxisDistanceTables::PrefixTable::get(std::size_t pixel, std::size_t line, std::size_t position) const {
+	return blockSums[line * blocksPerLine + position / PREFIX_BLOCK_SIZE] + offsets[pixel];
+}
+
+
+bool AxisDistanceTables::PrefixTable::empty() const {
+	return offsets.empty();
+}
+
+
+bool AxisDistanceTables::isInside(glm::ivec2 pixel) const {
+	return pixel.x >= 0 && pixel.y >= 0 && pixel.x < _imageWidth && pixel.y < _imageHeight;
+}
+
+
+std::size_t AxisDistanceTables::pixelIndex(glm::ivec2 pixel) const {
+	return static_cast<std::size_t>(pixel.y) * _imageWidth + pixel.x;
+}
+
+
+float calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const AxisDistanceTables& tables)
+{
+	float distance;
+	if (tables.lookupSurfaceDistance(begin, end, distance)) {
+		return distance;
+	}
+
+	return calcSurfaceDistance(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+}
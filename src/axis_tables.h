@@ -0,0 +1,79 @@
+#ifndef AXIS_TABLES_H
+#define AXIS_TABLES_H
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+#include "thread_pool.h"
+
+
+/*********
+Prefix sums of the surface length along every row, column, diagonal (direction (1, 1)) and anti-diagonal (direction (1, -1)) of a height map.
+Lines in these directions run on voxel edges, or through voxel corners and the middle of the voxel diagonal,
+so their surface distance is the difference of two table entries no matter how long they are.
+A table keeps the sum in double at the start of every block of 64 pixels along a line and a float offset from it per pixel,
+so it takes a little over 4 bytes per pixel, and all four about 16.5 bytes per pixel. Only the directions in lines are built;
+lines in the other directions are not covered. The tables are built in parallel over the pool.
+**********/
+class AxisDistanceTables {
+public:
+	static const unsigned ROWS = 1;
+	static const unsigned COLUMNS = 2;
+	static const unsigned DIAGONALS = 4;
+	static const unsigned ANTI_DIAGONALS = 8;
+	static const unsigned ALL_LINES = ROWS | COLUMNS | DIAGONALS | ANTI_DIAGONALS;
+
+	AxisDistanceTables(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight, ThreadPool& pool,
+		unsigned lines = ALL_LINES);
+
+	/*********
+	Look the line up in the tables. Returns false if the line is not covered, in which case distance is not touched.
+	Lines that have no length, run in a direction that was not built, run on the last row or column, or leave the image are not covered.
+	The result equals calcSurfaceDistance up to the rounding of its float summation.
+	**********/
+	bool lookupSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, float& distance) const;
+
+	int getImageWidth() const;
+
+	int getImageHeight() const;
+
+private:
+	/*********
+	Prefix sums of the lines of one direction. The sum at a pixel is the block sum of its line plus its offset.
+	**********/
+	struct PrefixTable {
+		std::vector<double> blockSums;
+		std::vector<float> offsets;
+		std::size_t blocksPerLine = 0;
+
+		void allocate(std::size_t pixelCount, std::size_t lineCount, std::size_t maxLineLength);
+
+		void set(std::size_t pixel, std::size_t line, std::size_t position, double sum);
+
+		double get(std::size_t pixel, std::size_t line, std::size_t position) const;
+
+		bool empty() const;
+	};
+
+	bool isInside(glm::ivec2 pixel) const;
+
+	std::size_t pixelIndex(glm::ivec2 pixel) const;
+
+	int _imageWidth;
+	int _imageHeight;
+	PrefixTable _rows;
+	PrefixTable _columns;
+	PrefixTable _diagonals;
+	PrefixTable _antiDiagonals;
+};
+
+
+/*********
+calcSurfaceDistance that takes the two lookups of the tables for lines they cover, and walks the surface for all other lines.
+The tables must have been built from the same height data.
+**********/
+float calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const AxisDistanceTables& tables);
+
+
+#endif // !AXIS_TABLES_H
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cstdlib>
+#include "batch.h"
+#include "distance.h"
+
+
+static const std::size_t QUERY_BLOCK_SIZE = 64;
+
+// part of the result, so it must not depend on the pool
+static const long long SPLIT_CELLS = 512;
+
+
+void calcSurfaceDistances(const SurfaceQuery* queries, std::size_t count,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool, const AxisDistanceTables* tables)
+{
+	std::size_t blockCount = (count + QUERY_BLOCK_SIZE - 1) / QUERY_BLOCK_SIZE;
+	pool.parallelFor(blockCount, [&](std::size_t block) {
+		std::size_t first = block * QUERY_BLOCK_SIZE;
+		std::size_t last = std::min(first + QUERY_BLOCK_SIZE, count);
+		for (std::size_t i = first; i < last; ++i) {
+			if (tables && tables->lookupSurfaceDistance(queries[i].begin, queries[i].end, distances[i])) {
+				continue;
+			}
+
+			distances[i] = calcSurfaceDistance(queries[i].begin, queries[i].end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+		}
+	});
+}
+
+
+std::vector<float> calcSurfaceDistances(const std::vector<SurfaceQuery>& queries,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool)
+{
+	std::vector<float> distances(queries.size());
+	calcSurfaceDistances(queries.data(), queries.size(), heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight, distances.data(), pool);
+	return distances;
+}
+
+
+void areSurfaceDistancesWithin(const SurfaceQuery* queries, std::size_t count, float limit,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	unsigned char* within, ThreadPool& pool, const SlopeBounds* bounds)
+{
+	std::size_t blockCount = (count + QUERY_BLOCK_SIZE - 1) / QUERY_BLOCK_SIZE;
+	pool.parallelFor(blockCount, [&](std::size_t block) {
+		std::size_t first = block * QUERY_BLOCK_SIZE;
+		std::size_t last = std::min(first + QUERY_BLOCK_SIZE, count);
+		for (std::size_t i = first; i < last; ++i) {
+			within[i] = isSurfaceDistanceWithin(queries[i].begin, queries[i].end, limit,
+				heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight, bounds) ? 1 : 0;
+		}
+	});
+}
+
+
+float calcSurfaceDistanceSplit(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool)
+{
+	glm::ivec2 delta = end - begin;
+	bool majorX = std::abs(delta.x) >= std::abs(delta.y);
+	long long majorLength = majorX ? std::abs(delta.x) : std::abs(delta.y);
+	long long minorLength = majorX ? std::abs(delta.y) : std::abs(delta.x);
+	if (majorLength <= SPLIT_CELLS) {
+		return calcSurfaceDistance(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+	}
+
+	// the same first voxel as VoxelTraversal, the voxel at offset (i, j) is first + (i, j) * step
+	glm::ivec2 step{ delta.x < 0 ? -1 : 1, delta.y < 0 ? -1 : 1 };
+	glm::ivec2 first = begin + glm::min(step, 0);
+
+	std::size_t pieceCount = static_cast<std::size_t>((majorLength + SPLIT_CELLS - 1) / SPLIT_CELLS);
+	std::vector<float> sums(pieceCount);
+	pool.parallelFor(pieceCount, [&](std::size_t piece) {
+		long long major = static_cast<long long>(piece) * SPLIT_CELLS;
+		long long lastMajor = std::min(major + SPLIT_CELLS, majorLength) - 1;
+
+		// the line crosses minor grid line m at m / minorLength and major grid line k at k / majorLength,
+		// on a tie VoxelTraversal steps along y first. Count the minor crossings before the piece starts.
+		long long minor = 0;
+		if (majorX) {
+			minor = major * minorLength / majorLength;
+		}
+		else if (major * minorLength > 0) {
+			minor = (major * minorLength - 1) / majorLength;
+		}
+
+		float distance = 0.0f;
+		SurfacePoint points[5];
+		while (true) {
+			glm::ivec2 offset = majorX ? glm::ivec2(major, minor) : glm::ivec2(minor, major);
+			glm::ivec2 voxel = first + offset * step;
+
+			// the voxels leave the grid at most once, where VoxelTraversal stops
+			if (voxel.x >= 0 && voxel.y >= 0 && voxel.x < imageWidth - 1 && voxel.y < imageHeight - 1) {
+				int count = intersectLineAndVoxel(begin, end, voxel, heightdata, imageWidth, pixelDistance, pixelHeight, points);
+				for (int i = 0; i < count - 1; ++i) {
+					distance += glm::distance(points[i].position, points[i + 1].position);
+				}
+			}
+
+			bool stepMajor = minor + 1 >= minorLength ||
+				(majorX ? (major + 1) * minorLength < (minor + 1) * majorLength : (major + 1) * minorLength <= (minor + 1) * majorLength);
+			if (!stepMajor) {
+				++minor;
+			}
+			else if (major < lastMajor) {
+				++major;
+			}
+			else {
+				break;
+			}
+		}
+
+		sums[piece] = distance;
+	});
+
+	double distance = 0.0;
+	for (float sum : sums) {
+		distance += sum;
+	}
+
+	return static_cast<float>(distance);
+}
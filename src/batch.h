@@ -0,0 +1,59 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+#include "thread_pool.h"
+#include "axis_tables.h"
+#include "slope_bounds.h"
+
+
+struct SurfaceQuery {
+	glm::ivec2 begin;
+	glm::ivec2 end;
+};
+
+
+/*********
+Find the surface distance of many lines over the same height data.
+The queries are split into blocks that are spread over the threads of the pool.
+distances[i] receives exactly the value calcSurfaceDistance returns for queries[i].
+With tables, the lines they cover are looked up instead, which matches calcSurfaceDistance up to float rounding.
+**********/
+void calcSurfaceDistances(const SurfaceQuery* queries, std::size_t count,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool, const AxisDistanceTables* tables = nullptr);
+
+
+std::vector<float> calcSurfaceDistances(const std::vector<SurfaceQuery>& queries,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool);
+
+
+/*********
+Find out for many lines whether their surface distance is at most limit, e.g. to filter the places reachable within a distance.
+within[i] receives 1 if isSurfaceDistanceWithin holds for queries[i] and 0 otherwise. With bounds, most lines that are far
+from limit are answered from the slope bounds alone, and the others stop walking as soon as they exceed limit.
+**********/
+void areSurfaceDistancesWithin(const SurfaceQuery* queries, std::size_t count, float limit,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	unsigned char* within, ThreadPool& pool, const SlopeBounds* bounds = nullptr);
+
+
+/*********
+Find the surface distance of a single long line with all threads of the pool.
+The voxels of the line are cut at every 512th column (or row, whichever axis the line is longer along) into pieces,
+the pieces are summed in parallel with the math of calcSurfaceDistance, and the sums of the pieces are added up in their order along the line.
+The pieces do not depend on the number of threads, so the result is bit-identical for every pool.
+Lines short enough to be a single piece return exactly calcSurfaceDistance.
+Longer lines find their voxels with integer arithmetic, so they do not pick up the drift of VoxelTraversal over thousands of voxels,
+which puts them within float rounding of the exact surface distance even where calcSurfaceDistance is off by a fraction of a percent.
+Must not be called from inside a task of the same pool.
+**********/
+float calcSurfaceDistanceSplit(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool);
+
+
+#endif // !BATCH_H
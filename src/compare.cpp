@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <stdexcept>
+#include "compare.h"
+#include "distance.h"
+
+
+static const int MASK_TILE_SIZE = 64;
+
+static const std::size_t COMPARE_BLOCK_SIZE = 64;
+
+
+ChangeMask::ChangeMask(const std::vector<unsigned char>& before, const std::vector<unsigned char>& after, int imageWidth, int imageHeight)
+	: _voxelWidth{imageWidth - 1}, _voxelHeight{imageHeight - 1}
+{
+	std::size_t pixelCount = static_cast<std::size_t>(imageWidth) * imageHeight;
+	if (imageWidth < 2 || imageHeight < 2 || before.size() < pixelCount || after.size() < pixelCount) {
+		throw std::invalid_argument("a change mask needs two height maps of at least 2x2 pixels that cover the image");
+	}
+
+	_tileCount = (glm::ivec2(_voxelWidth, _voxelHeight) + MASK_TILE_SIZE - 1) / MASK_TILE_SIZE;
+	_tileBitmaps.assign(static_cast<std::size_t>(_tileCount.x) * _tileCount.y, -1);
+
+	for (int y = 0; y < imageHeight; ++y) {
+		const unsigned char* rowBefore = before.data() + static_cast<std::size_t>(y) * imageWidth;
+		const unsigned char* rowAfter = after.data() + static_cast<std::size_t>(y) * imageWidth;
+		int x = 0;
+		for (; x + 8 <= imageWidth; x += 8) {
+			std::uint64_t wordBefore;
+			std::uint64_t wordAfter;
+			std::memcpy(&wordBefore, rowBefore + x, sizeof(wordBefore));
+			std::memcpy(&wordAfter, rowAfter + x, sizeof(wordAfter));
+			if (wordBefore == wordAfter) {
+				continue;
+			}
+
+			for (int i = 0; i < 8; ++i) {
+				if (rowBefore[x + i] != rowAfter[x + i]) {
+					markPixel(x + i, y);
+				}
+			}
+		}
+
+		for (; x < imageWidth; ++x) {
+			if (rowBefore[x] != rowAfter[x]) {
+				markPixel(x, y);
+			}
+		}
+	}
+}
+
+
+void ChangeMask::markPixel(int x, int y) {
+	// the pixel is a corner of up to 4 voxels
+	for (int voxelY = std::max(y - 1, 0); voxelY <= std::min(y, _voxelHeight - 1); ++voxelY) {
+		for (int voxelX = std::max(x - 1, 0); voxelX <= std::min(x, _voxelWidth - 1); ++voxelX) {
+			std::size_t tile = static_cast<std::size_t>(voxelY / MASK_TILE_SIZE) * _tileCount.x + voxelX / MASK_TILE_SIZE;
+			if (_tileBitmaps[tile] < 0) {
+				_tileBitmaps[tile] = static_cast<std::int32_t>(_bitmaps.size());
+				_bitmaps.resize(_bitmaps.size() + MASK_TILE_SIZE, 0);
+			}
+
+			_bitmaps[_tileBitmaps[tile] + voxelY % MASK_TILE_SIZE] |= std::uint64_t(1) << (voxelX % MASK_TILE_SIZE);
+		}
+	}
+}
+
+
+bool ChangeMask::isVoxelChanged(glm::ivec2 voxel) const {
+	if (voxel.x < 0 || voxel.y < 0 || voxel.x >= _voxelWidth || voxel.y >= _voxelHeight) {
+		return false;
+	}
+
+	std::int32_t bitmap = _tileBitmaps[static_cast<std::size_t>(voxel.y / MASK_TILE_SIZE) * _tileCount.x + voxel.x / MASK_TILE_SIZE];
+	return bitmap >= 0 && ((_bitmaps[bitmap + voxel.y % MASK_TILE_SIZE] >> (voxel.x % MASK_TILE_SIZE)) & 1);
+}
+
+
+bool ChangeMask::isTileChanged(glm::ivec2 tile) const {
+	return _tileBitmaps[static_cast<std::size_t>(tile.y) * _tileCount.x + tile.x] >= 0;
+}
+
+
+glm::ivec2 ChangeMask::getTileCount() const {
+	return _tileCount;
+}
+
+
+std::size_t ChangeMask::getChangedTileCount() const {
+	return _bitmaps.size() / MASK_TILE_SIZE;
+}
+
+
+std::size_t ChangeMask::getChangedVoxelCount() const {
+	std::size_t count = 0;
+	for (std::uint64_t row : _bitmaps) {
+		count += std::bitset<64>(row).count();
+	}
+
+	return count;
+}
+
+
+SurfaceComparison compareSurfaceDistance(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& before, const std::vector<unsigned char>& after, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const ChangeMask& mask)
+{
+	SurfaceComparison comparison{ 0.0f, 0.0f, 0.0f };
+	VoxelTraversal traversal(begin, end, imageWidth - 1, imageHeight - 1);
+	SurfacePoint points[5];
+	glm::ivec2 voxel;
+	while (traversal.next(voxel)) {
+		int count = intersectLineAndVoxel(begin, end, voxel, before, imageWidth, pixelDistance, pixelHeight, points);
+		bool changed = mask.isVoxelChanged(voxel);
+		for (int i = 0; i < count - 1; ++i) {
+			float distance = glm::distance(points[i].position, points[i + 1].position);
+			comparison.before += distance;
+			if (!changed) {
+				comparison.after += distance;
+			}
+		}
+
+		if (changed) {
+			count = intersectLineAndVoxel(begin, end, voxel, after, imageWidth, pixelDistance, pixelHeight, points);
+			for (int i = 0; i < count - 1; ++i) {
+				comparison.after += glm::distance(points[i].position, points[i + 1].position);
+			}
+		}
+	}
+
+	comparison.difference = comparison.after - comparison.before;
+	return comparison;
+}
+
+
+void compareSurfaceDistances(const SurfaceQuery* queries, std::size_t count,
+	const std::vector<unsigned char>& before, const std::vector<unsigned char>& after, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const ChangeMask& mask, SurfaceComparison* comparisons, ThreadPool& pool)
+{
+	std::size_t blockCount = (count + COMPARE_BLOCK_SIZE - 1) / COMPARE_BLOCK_SIZE;
+	pool.parallelFor(blockCount, [&](std::size_t block) {
+		std::size_t first = block * COMPARE_BLOCK_SIZE;
+		std::size_t last = std::min(first + COMPARE_BLOCK_SIZE, count);
+		for (std::size_t i = first; i < last; ++i) {
+			comparisons[i] = compareSurfaceDistance(queries[i].begin, queries[i].end, before, after, imageWidth, imageHeight, pixelDistance, pixelHeight, mask);
+		}
+	});
+}
@@ -0,0 +1,69 @@
+#ifndef COMPARE_H
+#define COMPARE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+#include "batch.h"
+#include "thread_pool.h"
+
+
+/*********
+The voxels whose surface differs between two height maps of the same size, e.g. before and after an eruption.
+A voxel changed if any of its 4 corner pixels changed. The height maps are compared 8 pixels at a time, and runs of equal pixels are skipped.
+The mask is a bitmap per tile of 64 x 64 voxels, and only tiles with a changed voxel have one, so a small change takes little memory.
+**********/
+class ChangeMask {
+public:
+	ChangeMask(const std::vector<unsigned char>& before, const std::vector<unsigned char>& after, int imageWidth, int imageHeight);
+
+	bool isVoxelChanged(glm::ivec2 voxel) const;
+
+	bool isTileChanged(glm::ivec2 tile) const;
+
+	glm::ivec2 getTileCount() const;
+
+	std::size_t getChangedTileCount() const;
+
+	std::size_t getChangedVoxelCount() const;
+
+private:
+	void markPixel(int x, int y);
+
+	int _voxelWidth;
+	int _voxelHeight;
+	glm::ivec2 _tileCount;
+	std::vector<std::int32_t> _tileBitmaps;
+	std::vector<std::uint64_t> _bitmaps;
+};
+
+
+/*********
+Surface distance of a line before and after a change, in unit meter. difference is after - before.
+**********/
+struct SurfaceComparison {
+	float before;
+	float after;
+	float difference;
+};
+
+
+/*********
+Find the surface distance of a line on both height maps in one walk.
+Every voxel is intersected with the line once on the before heights, and a second time on the after heights only if the mask marks it as changed,
+otherwise its pieces count the same for both. The pieces are added up in the order calcSurfaceDistance does,
+so before and after are exactly calcSurfaceDistance on the two height maps, and a line that crosses no changed voxel
+never reads the after heights and has a difference of exactly 0. The mask must have been built from the same height maps.
+**********/
+SurfaceComparison compareSurfaceDistance(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& before, const std::vector<unsigned char>& after, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const ChangeMask& mask);
+
+
+void compareSurfaceDistances(const SurfaceQuery* queries, std::size_t count,
+	const std::vector<unsigned char>& before, const std::vector<unsigned char>& after, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const ChangeMask& mask, SurfaceComparison* comparisons, ThreadPool& pool);
+
+
+#endif // !COMPARE_H
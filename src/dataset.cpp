@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include "dataset.h"
+
+
+// slots hold this epoch while their reader is not pinned
+static const std::uint64_t IDLE_EPOCH = 0;
+
+static const std::size_t DATASET_BLOCK_SIZE = 64;
+
+
+HeightDataset::HeightDataset(std::vector<unsigned char> heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight)
+	: _heightdata{std::move(heightdata)}, _imageWidth{imageWidth}, _imageHeight{imageHeight},
+	_pixelDistance{pixelDistance}, _pixelHeight{pixelHeight}, _key{0, 0}, _kernelIsa{selectKernelIsa()}, _kernel{getSurfaceDistanceKernel(_kernelIsa)}
+{
+	if (imageWidth <= 0 || imageHeight <= 0 || _heightdata.size() < static_cast<std::size_t>(imageWidth) * imageHeight) {
+		throw std::invalid_argument("the height data must cover the image");
+	}
+}
+
+
+const std::vector<unsigned char>& HeightDataset::getHeightData() const {
+	return _heightdata;
+}
+
+
+int HeightDataset::getImageWidth() const {
+	return _imageWidth;
+}
+
+
+int HeightDataset::getImageHeight() const {
+	return _imageHeight;
+}
+
+
+float HeightDataset::getPixelDistance() const {
+	return _pixelDistance;
+}
+
+
+float HeightDataset::getPixelHeight() const {
+	return _pixelHeight;
+}
+
+
+DatasetKey HeightDataset::getKey() const {
+	return _key;
+}
+
+
+KernelIsa HeightDataset::getKernelIsa() const {
+	return _kernelIsa;
+}
+
+
+float HeightDataset::calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end) const {
+	return _kernel(begin, end, _heightdata, _imageWidth, _imageHeight, _pixelDistance, _pixelHeight);
+}
+
+
+void calcSurfaceDistances(const SurfaceQuery* queries, std::size_t count, const HeightDataset& dataset, float* distances, ThreadPool& pool) {
+	std::size_t blockCount = (count + DATASET_BLOCK_SIZE - 1) / DATASET_BLOCK_SIZE;
+	pool.parallelFor(blockCount, [&](std::size_t block) {
+		std::size_t last = std::min((block + 1) * DATASET_BLOCK_SIZE, count);
+		for (std::size_t i = block * DATASET_BLOCK_SIZE; i < last; ++i) {
+			distances[i] = dataset.calcSurfaceDistance(queries[i].begin, queries[i].end);
+		}
+	});
+}
+
+
+DatasetHandle::DatasetHandle(std::uint32_t id, std::vector<unsigned char> heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	std::size_t maxReaders)
+	: _id{id}, _current{nullptr}, _version{0}, _epoch{IDLE_EPOCH + 1}, _slots{new ReaderSlot[maxReaders]}, _slotCount{maxReaders}
+{
+	for (std::size_t i = 0; i < _slotCount; ++i) {
+		_slots[i].epoch.store(IDLE_EPOCH);
+		_slots[i].taken.store(false);
+	}
+
+	HeightDataset* dataset = new HeightDataset(std::move(heightdata), imageWidth, imageHeight, pixelDistance, pixelHeight);
+	dataset->_key = DatasetKey{ _id, 0 };
+	_current.store(dataset);
+}
+
+
+DatasetHandle::~DatasetHandle() {
+	for (const RetiredDataset& retired : _retired) {
+		delete retired.dataset;
+	}
+
+	delete _current.load();
+}
+
+
+std::uint32_t DatasetHandle::publish(std::vector<unsigned char> heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight) {
+	std::unique_ptr<HeightDataset> dataset(new HeightDataset(std::move(heightdata), imageWidth, imageHeight, pixelDistance, pixelHeight));
+	std::lock_guard<std::mutex> lock(_publishMutex);
+	_retired.reserve(_retired.size() + 1);
+	std::uint32_t version = _version.load() + 1;
+	dataset->_key = DatasetKey{ _id, version };
+
+	// readers that see the new epoch pinned after the swap, so they cannot hold the old version
+	const HeightDataset* old = _current.exchange(dataset.release());
+	std::uint64_t epoch = _epoch.fetch_add(1) + 1;
+	_version.store(version);
+	_retired.push_back(RetiredDataset{ old, epoch });
+	reclaimLocked();
+	return version;
+}
+
+
+std::size_t DatasetHandle::reclaim() {
+	std::lock_guard<std::mutex> lock(_publishMutex);
+	return reclaimLocked();
+}
+
+
+std::size_t DatasetHandle::reclaimLocked() {
+	std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+	for (std::size_t i = 0; i < _slotCount; ++i) {
+		std::uint64_t epoch = _slots[i].epoch.load();
+		if (epoch != IDLE_EPOCH) {
+			oldest = std::min(oldest, epoch);
+		}
+	}
+
+	auto freed = std::partition(_retired.begin(), _retired.end(), [&](const RetiredDataset& retired) { return retired.epoch > oldest; });
+	for (auto it = freed; it != _retired.end(); ++it) {
+		delete it->dataset;
+	}
+
+	_retired.erase(freed, _retired.end());
+	return _retired.size();
+}
+
+
+std::size_t DatasetHandle::getRetiredCount() const {
+	std::lock_guard<std::mutex> lock(_publishMutex);
+	return _retired.size();
+}
+
+
+std::uint32_t DatasetHandle::getVersion() const {
+	return _version.load();
+}
+
+
+DatasetReader DatasetHandle::registerReader() {
+	for (std::size_t i = 0; i < _slotCount; ++i) {
+		bool taken = false;
+		if (_slots[i].taken.compare_exchange_strong(taken, true)) {
+			return DatasetReader(this, i);
+		}
+	}
+
+	throw std::runtime_error("all " + std::to_string(_slotCount) + " reader slots of the dataset are taken");
+}
+
+
+DatasetPin::DatasetPin(std::atomic<std::uint64_t>* slotEpoch, const HeightDataset* dataset)
+	: _slotEpoch{slotEpoch}, _dataset{dataset}
+{
+}
+
+
+DatasetPin::DatasetPin(DatasetPin&& other) noexcept
+	: _slotEpoch{other._slotEpoch}, _dataset{other._dataset}
+{
+	other._slotEpoch = nullptr;
+	other._dataset = nullptr;
+}
+
+
+DatasetPin::~DatasetPin() {
+	if (_slotEpoch) {
+		_slotEpoch->store(IDLE_EPOCH, std::memory_order_release);
+	}
+}
+
+
+const HeightDataset& DatasetPin::operator*() const {
+	return *_dataset;
+}
+
+
+const HeightDataset* DatasetPin::operator->() const {
+	return _dataset;
+}
+
+
+DatasetReader::DatasetReader(DatasetHandle* handle, std::size_t slot)
+	: _handle{handle}, _slot{slot}
+{
+}
+
+
+DatasetReader::DatasetReader(DatasetReader&& other) noexcept
+	: _handle{other._handle}, _slot{other._slot}
+{
+	other._handle = nullptr;
+}
+
+
+DatasetReader::~DatasetReader() {
+	if (_handle) {
+		_handle->_slots[_slot].taken.store(false, std::memory_order_release);
+	}
+}
+
+
+DatasetPin DatasetReader::pin() {
+	std::atomic<std::uint64_t>& slotEpoch = _handle->_slots[_slot].epoch;
+	// the announcement must be visible before the version is loaded, which the sequentially consistent store and load guarantee
+	slotEpoch.store(_handle->_epoch.load());
+	return DatasetPin(&slotEpoch, _handle->_current.load());
+}
@@ -0,0 +1,199 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "glm/glm.hpp"
+#include "kernel.h"
+#include "result_cache.h"
+#include "thread_pool.h"
+
+
+/*********
+One version of a height map together with its geometry. It never changes once published,
+so any number of threads may read it while they hold a pin on it.
+The kernel variant of calcSurfaceDistance is chosen with selectKernelIsa when the dataset is created.
+**********/
+class HeightDataset {
+public:
+	HeightDataset(std::vector<unsigned char> heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+	const std::vector<unsigned char>& getHeightData() const;
+
+	int getImageWidth() const;
+
+	int getImageHeight() const;
+
+	float getPixelDistance() const;
+
+	float getPixelHeight() const;
+
+	/*********
+	Id of the handle and version it was published under, for use with ResultCache.
+	**********/
+	DatasetKey getKey() const;
+
+	KernelIsa getKernelIsa() const;
+
+	float calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end) const;
+
+private:
+	friend class DatasetHandle;
+
+	std::vector<unsigned char> _heightdata;
+	int _imageWidth;
+	int _imageHeight;
+	float _pixelDistance;
+	float _pixelHeight;
+	DatasetKey _key;
+	KernelIsa _kernelIsa;
+	SurfaceDistanceKernel _kernel;
+};
+
+
+/*********
+Same as the calcSurfaceDistances of batch.h, with the kernel variant of the dataset.
+**********/
+void calcSurfaceDistances(const SurfaceQuery* queries, std::size_t count, const HeightDataset& dataset, float* distances, ThreadPool& pool);
+
+
+class DatasetReader;
+
+
+/*********
+The current version of a height map that is replaced while queries keep running, e.g. by a newer survey.
+Reclamation is epoch based:
+- every reader owns a slot, and pinning writes the global epoch into it before loading the current version
+- publish() swaps in the new version, moves the epoch forward and retires the old version with the new epoch
+- a retired version is freed once every slot is either idle or holds an epoch at least that of its retirement,
+  because such readers loaded the current version after the swap
+Pinning and unpinning are a few atomic loads and stores, so readers never wait, not even on a publish in progress.
+Publishers are serialized among themselves and free what they can after every swap; versions still pinned are freed by a later publish() or reclaim().
+The handle must outlive its readers, and no reader may be pinned when it is destroyed.
+**********/
+class DatasetHandle {
+public:
+	DatasetHandle(std::uint32_t id, std::vector<unsigned char> heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+		std::size_t maxReaders = 64);
+
+	~DatasetHandle();
+
+	DatasetHandle(const DatasetHandle&) = delete;
+
+	DatasetHandle& operator=(const DatasetHandle&) = delete;
+
+	/*********
+	Make a new version current and return its version number. Queries pinned on older versions finish on them.
+	**********/
+	std::uint32_t publish(std::vector<unsigned char> heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+	/*********
+	Free the retired versions no reader can still see, and return how many are left.
+	**********/
+	std::size_t reclaim();
+
+	std::size_t getRetiredCount() const;
+
+	/*********
+	The version number of the current version. It does not pin the version, so it may be older than the one a pin taken right after sees.
+	**********/
+	std::uint32_t getVersion() const;
+
+	/*********
+	Take one of the reader slots, throws std::runtime_error if all maxReaders are taken.
+	A reader belongs to one thread at a time.
+	**********/
+	DatasetReader registerReader();
+
+private:
+	friend class DatasetReader;
+
+	friend class DatasetPin;
+
+	struct ReaderSlot {
+		std::atomic<std::uint64_t> epoch;
+		std::atomic<bool> taken;
+		// keep readers of different slots off each other's cache line
+		char padding[64 - sizeof(std::atomic<std::uint64_t>) - sizeof(std::atomic<bool>)];
+	};
+
+	struct RetiredDataset {
+		const HeightDataset* dataset;
+		std::uint64_t epoch;
+	};
+
+	std::size_t reclaimLocked();
+
+	std::uint32_t _id;
+	std::atomic<const HeightDataset*> _current;
+	// kept apart from the current version, which may be freed under a reader that has not pinned it
+	std::atomic<std::uint32_t> _version;
+	std::atomic<std::uint64_t> _epoch;
+	std::unique_ptr<ReaderSlot[]> _slots;
+	std::size_t _slotCount;
+	mutable std::mutex _publishMutex;
+	std::vector<RetiredDataset> _retired;
+};
+
+
+/*********
+Keeps the version that was current when it was created alive until it is destroyed.
+**********/
+class DatasetPin {
+public:
+	DatasetPin(DatasetPin&& other) noexcept;
+
+	~DatasetPin();
+
+	DatasetPin(const DatasetPin&) = delete;
+
+	DatasetPin& operator=(const DatasetPin&) = delete;
+
+	DatasetPin& operator=(DatasetPin&&) = delete;
+
+	const HeightDataset& operator*() const;
+
+	const HeightDataset* operator->() const;
+
+private:
+	friend class DatasetReader;
+
+	DatasetPin(std::atomic<std::uint64_t>* slotEpoch, const HeightDataset* dataset);
+
+	std::atomic<std::uint64_t>* _slotEpoch;
+	const HeightDataset* _dataset;
+};
+
+
+/*********
+A reader slot of a DatasetHandle. pin() is wait-free. A reader holds at most one pin at a time.
+**********/
+class DatasetReader {
+public:
+	DatasetReader(DatasetReader&& other) noexcept;
+
+	~DatasetReader();
+
+	DatasetReader(const DatasetReader&) = delete;
+
+	DatasetReader& operator=(const DatasetReader&) = delete;
+
+	DatasetReader& operator=(DatasetReader&&) = delete;
+
+	DatasetPin pin();
+
+private:
+	friend class DatasetHandle;
+
+	DatasetReader(DatasetHandle* handle, std::size_t slot);
+
+	DatasetHandle* _handle;
+	std::size_t _slot;
+};
+
+
+#endif // !DATASET_H
@@ -42,6 +42,93 @@ http://www.cse.yorku.ca/~amana/research/grid.pdf
 std::vector<glm::ivec2> traverseRayAndVoxels(glm::ivec2 begin, glm::ivec2 end, int gridWidth, int gridHeight);
 
 
+/*********
+Where a VoxelTraversal stands. It is a plain struct so the kernel variants of kernel.h can step it as well.
+**********/
+struct VoxelTraversalState {
+	glm::ivec2 voxel;
+	glm::ivec2 endVoxel;
+	glm::ivec2 step;
+	glm::vec2 tMax;
+	glm::vec2 tDelta;
+	int gridWidth;
+	int gridHeight;
+	bool finished;
+};
+
+
+/*********
+Visit the voxels of traverseRayAndVoxels one at a time, in the same order, without storing them.
+next() returns false once there are no more voxels.
+**********/
+class VoxelTraversal {
+public:
+	VoxelTraversal(glm::ivec2 begin, glm::ivec2 end, int gridWidth, int gridHeight);
+
+	/*********
+	Continue the traversal of the line at startVoxel, a voxel the line passes through, as if the voxels before it had been visited.
+	**********/
+	VoxelTraversal(glm::ivec2 begin, glm::ivec2 end, int gridWidth, int gridHeight, glm::ivec2 startVoxel);
+
+	bool next(glm::ivec2& voxel);
+
+private:
+	VoxelTraversalState _state;
+};
+
+
+/*********
+Find the first voxel the line from begin to end enters after it leaves the block of size voxels whose lowest voxel is corner,
+with integer arithmetic only, e.g. to go on with a VoxelTraversal past a block that needs no visit.
+The line leaves through the far side in its direction that it reaches first; through a corner it goes on diagonally,
+as the voxels beside the corner only touch it. Returns false if the line ends inside the block or on its border.
+**********/
+bool findVoxelAfterBlock(glm::ivec2 begin, glm::ivec2 end, glm::ivec2 corner, glm::ivec2 size, glm::ivec2& voxel);
+
+
+/*********
+A point of the line on the surface.
+ray is the parameter along the line: 0 at begin and 1 at end. position is latitude, longtitude, and height in unit meter.
+**********/
+struct SurfacePoint {
+	float ray;
+	glm::vec3 position;
+};
+
+
+/*********
+Find the points where the line from begin to end crosses the boundary and the diagonal of a voxel, sorted along the line.
+If the line runs along the voxel boundary or the diagonal, only the two ends of the overlap are returned.
+points must have room for 5 points. The function returns the number of points written.
+**********/
+int intersectLineAndVoxel(glm::ivec2 begin, glm::ivec2 end, glm::ivec2 voxel, 
+	const std::vector<unsigned char>& heightdata, int imageWidth, float pixelDistance, float pixelHeight, SurfacePoint* points);
+
+
+/*********
+Walk the line from begin to end over the surface the same way calcSurfaceDistance does, 
+and call visitor(from, to) for every pair of consecutive crossings with a voxel boundary or diagonal.
+The visitor returns false to stop the walk early, in which case walkSurface returns false as well.
+calcSurfaceDistance is the sum of glm::distance(from.position, to.position) over all calls, in call order.
+**********/
+template<typename Visitor>
+bool walkSurface(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight, Visitor&& visitor) {
+	VoxelTraversal traversal(begin, end, imageWidth - 1, imageHeight - 1);
+	SurfacePoint points[5];
+	glm::ivec2 voxel;
+	while (traversal.next(voxel)) {
+		int count = intersectLineAndVoxel(begin, end, voxel, heightdata, imageWidth, pixelDistance, pixelHeight, points);
+		for (int i = 0; i < count - 1; ++i) {
+			if (!visitor(points[i], points[i + 1])) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
 /*********
 Find the surface distance between two points accounting for the topology of the surface.
 Approach:
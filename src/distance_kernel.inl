@@ -0,0 +1,238 @@
+// The hot kernels of calcSurfaceDistance: voxel traversal, intersection of the line with a voxel and the sum of the lengths.
+// distance.cpp includes this file at global scope for the baseline, and every kernel variant of kernel.h includes it
+// into a namespace of its own, compiled for its instruction set. Include <algorithm>, <limits>, <vector> and distance.h first.
+
+
+static float cross(glm::vec2 a, glm::vec2 b) {
+	return a.x * b.y - a.y * b.x;
+}
+
+
+static int sub2ind(int width, int x, int y) {
+	return y * width + x;
+}
+
+
+static glm::ivec2 toVoxelCoord(glm::ivec2 coord, glm::vec2 direction, int gridWidth, int gridHeight) {
+	int voxelX = coord.x;
+	int voxelY = coord.y;
+
+	int stepX = direction.x < 0 ? -1 : 1;
+	int stepY = direction.y < 0 ? -1 : 1;
+	if (stepX == 1 && stepY == -1) {
+		--voxelY;
+	}
+	else if (stepX == -1 && stepY == -1) {
+		--voxelX;
+		--voxelY;
+	}
+	else if (stepX == -1 && stepY == 1) {
+		--voxelX;
+	}
+
+	return glm::ivec2{ voxelX, voxelY };
+}
+
+
+static RayLineIntersection intersectRayAndLineKernel(Ray ray, glm::vec2 lineBegin, glm::vec2 lineEnd) {
+	glm::vec2 beginOrigin = lineBegin - ray.origin;
+	glm::vec2 endBegin = lineEnd - lineBegin;
+	float rayLineCross = cross(ray.direction, endBegin);
+	float beginOriginRayCross = cross(beginOrigin, ray.direction);
+
+	// line and ray are colinear
+	if (glm::abs(rayLineCross) < std::numeric_limits<float>::epsilon() && 
+		glm::abs(beginOriginRayCross) < std::numeric_limits<float>::epsilon()) 
+	{
+		return RayLineIntersection{ IntersectionType::Colinear, -1.0f, -1.0f };
+	}
+
+	// line and ray are parallel 
+	if (glm::abs(rayLineCross) < std::numeric_limits<float>::epsilon()) {
+		return RayLineIntersection{ IntersectionType::Parallel, -1.0f, -1.0f };
+	}
+
+	RayLineIntersection intersect{ IntersectionType::Intersect, -1.0f, -1.0f};
+	intersect.ray = cross(beginOrigin, endBegin) / rayLineCross;
+	intersect.line = cross(beginOrigin, ray.direction) / rayLineCross;
+
+	return intersect;
+}
+
+
+static float intersectRayAndLowerUpperVoxelBound(Ray ray, glm::vec2 beginLower, glm::vec2 endLower, glm::vec2 beginUpper, glm::vec2 endUpper) {
+	RayLineIntersection lowerIntersect = intersectRayAndLineKernel(ray, beginLower, endLower);
+	RayLineIntersection upperIntersect = intersectRayAndLineKernel(ray, beginUpper, endUpper);
+
+	if (lowerIntersect.type == IntersectionType::Intersect && upperIntersect.type == IntersectionType::Intersect) {
+		return std::max(lowerIntersect.ray, upperIntersect.ray);
+	}
+
+	return std::numeric_limits<float>::max();
+}
+
+
+static glm::vec3 interpolateVoxelBound(glm::ivec2 from, glm::ivec2 to, float tline, 
+	const std::vector<unsigned char>& heightdata, int imageWidth, float pixelDistance, float pixelHeight) 
+{
+	int indFrom = sub2ind(imageWidth, from.x, from.y);
+	int indTo = sub2ind(imageWidth, to.x, to.y);
+	float heightFrom = heightdata[indFrom] * pixelHeight;
+	float heightTo = heightdata[indTo] * pixelHeight;
+
+	glm::vec3 attribFrom = glm::vec3(pixelDistance * from.x, pixelDistance * from.y, heightFrom);
+	glm::vec3 attribTo = glm::vec3(pixelDistance * to.x, pixelDistance * to.y, heightTo);
+	return attribFrom + tline * (attribTo - attribFrom);
+}
+
+
+static void beginVoxelTraversalAt(VoxelTraversalState& state, glm::ivec2 begin, glm::ivec2 end, int gridWidth, int gridHeight, glm::ivec2 startVoxel) {
+	state.gridWidth = gridWidth;
+	state.gridHeight = gridHeight;
+	state.finished = false;
+	Ray ray{begin, glm::normalize(static_cast<glm::vec2>(end-begin))};
+	state.voxel = startVoxel;
+
+	// find stepX and stepY depends on the direction of ray
+	state.step.x = ray.direction.x < 0 ? -1 : 1;
+	state.step.y = ray.direction.y < 0 ? -1 : 1;
+
+	// find tMaxX, tMaxY
+	state.tMax.x = intersectRayAndLowerUpperVoxelBound(
+		ray, 
+		state.voxel, state.voxel + glm::ivec2(0, 1),
+		state.voxel + glm::ivec2(1, 0), state.voxel + glm::ivec2(1, 1));
+
+	state.tMax.y = intersectRayAndLowerUpperVoxelBound(
+		ray,
+		state.voxel, state.voxel + glm::ivec2(1, 0),
+		state.voxel + glm::ivec2(0, 1), state.voxel + glm::ivec2(1, 1));
+
+	// find tDeltaX, tDeltaY
+	state.tDelta.x = glm::abs(1.0f / ray.direction.x);
+	state.tDelta.y = glm::abs(1.0f / ray.direction.y);
+
+	state.endVoxel = toVoxelCoord(end, -ray.direction, gridWidth, gridHeight);
+}
+
+
+static void beginVoxelTraversal(VoxelTraversalState& state, glm::ivec2 begin, glm::ivec2 end, int gridWidth, int gridHeight) {
+	// find the begin voxel 
+	glm::vec2 direction = glm::normalize(static_cast<glm::vec2>(end-begin));
+	beginVoxelTraversalAt(state, begin, end, gridWidth, gridHeight, toVoxelCoord(begin, direction, gridWidth, gridHeight));
+}
+
+
+static bool nextVoxel(VoxelTraversalState& state, glm::ivec2& voxel) {
+	if (state.finished) {
+		return false;
+	}
+
+	if ((state.voxel.x >= 0 && state.voxel.x < state.gridWidth) && (state.voxel.y >= 0 && state.voxel.y < state.gridHeight) &&  // out of bound condition
+		(state.voxel.x != state.endVoxel.x || state.voxel.y != state.endVoxel.y))                                       // We arrive at the destination voxel
+	{
+		voxel = state.voxel;
+		if (state.tMax.x < state.tMax.y) {
+			state.tMax.x += state.tDelta.x;
+			state.voxel.x = state.voxel.x + state.step.x;
+		}
+		else {
+			state.tMax.y += state.tDelta.y;
+			state.voxel.y = state.voxel.y + state.step.y;
+		}
+
+		return true;
+	}
+
+	state.finished = true;
+	if (state.voxel.x == state.endVoxel.x && state.voxel.y == state.endVoxel.y) {
+		voxel = state.voxel;
+		return true;
+	}
+
+	return false;
+}
+
+
+static int intersectLineAndVoxelKernel(glm::ivec2 begin, glm::ivec2 end, glm::ivec2 voxel, 
+	const std::vector<unsigned char>& heightdata, int imageWidth, float pixelDistance, float pixelHeight, SurfacePoint* points) 
+{
+	const glm::ivec2 voxelBounds[] = {
+		glm::ivec2(voxel.x + 1, voxel.y), glm::ivec2(voxel.x, voxel.y),
+		glm::ivec2(voxel.x, voxel.y + 1), glm::ivec2(voxel.x + 1, voxel.y + 1),
+		glm::ivec2(voxel.x + 1, voxel.y), glm::ivec2(voxel.x, voxel.y + 1)
+	};
+
+	glm::vec2 lineVector = static_cast<glm::vec2>(end - begin);
+	float lineLength = glm::dot(lineVector, lineVector);
+	Ray ray{ begin, lineVector };
+	bool colinear = false;
+	SurfacePoint colinearPoints[2];
+	int count = 0;
+	for (std::size_t i = 0; i < 5; ++i) {
+		glm::ivec2 from = voxelBounds[i];
+		glm::ivec2 to = voxelBounds[i + 1];
+		RayLineIntersection intersect = intersectRayAndLineKernel(ray, from, to);
+
+		if (intersect.type == IntersectionType::Colinear) {
+			glm::vec2 voxelBoundVector = static_cast<glm::vec2>(to - from);
+			float voxelBoundLength = glm::dot(voxelBoundVector, voxelBoundVector);
+			float tline0 = glm::dot(static_cast<glm::vec2>(begin - from), voxelBoundVector) / voxelBoundLength;
+			float tline1 = tline0 + glm::dot(lineVector, voxelBoundVector) / voxelBoundLength;
+
+			// if two lines are overlapped
+			if (tline1 >= 0 && tline0 <= 1) {
+				tline0 = std::max(tline0, 0.0f);
+				tline1 = std::min(tline1, 1.0f);
+				colinear = true;
+
+				float tlines[] = { tline0, tline1 };
+				for (int j = 0; j < 2; ++j) {
+					glm::vec2 point = static_cast<glm::vec2>(from) + tlines[j] * voxelBoundVector;
+					colinearPoints[j].ray = lineLength > 0.0f ? glm::dot(point - static_cast<glm::vec2>(begin), lineVector) / lineLength : 0.0f;
+					colinearPoints[j].position = interpolateVoxelBound(from, to, tlines[j], heightdata, imageWidth, pixelDistance, pixelHeight);
+				}
+			}
+		}
+		else if (intersect.type == IntersectionType::Intersect && intersect.line >= 0.0f && intersect.line <= 1.0f) {
+			points[count].ray = intersect.ray;
+			points[count].position = interpolateVoxelBound(from, to, intersect.line, heightdata, imageWidth, pixelDistance, pixelHeight);
+			++count;
+		}
+	}
+
+	if (colinear) {
+		// keep the overlap in the direction of the line
+		if (colinearPoints[0].ray > colinearPoints[1].ray) {
+			std::swap(colinearPoints[0], colinearPoints[1]);
+		}
+
+		points[0] = colinearPoints[0];
+		points[1] = colinearPoints[1];
+		return 2;
+	}
+
+	std::sort(points, points + count, 
+		[](const SurfacePoint& a, const SurfacePoint& b) { return a.ray < b.ray; });
+
+	return count;
+}
+
+
+static float calcSurfaceDistanceKernel(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight)
+{
+	VoxelTraversalState state;
+	beginVoxelTraversal(state, begin, end, imageWidth - 1, imageHeight - 1);
+	SurfacePoint points[5];
+	glm::ivec2 voxel;
+	float distance = 0.0f;
+	while (nextVoxel(state, voxel)) {
+		int count = intersectLineAndVoxelKernel(begin, end, voxel, heightdata, imageWidth, pixelDistance, pixelHeight, points);
+		for (int i = 0; i < count - 1; ++i) {
+			distance += glm::distance(points[i].position, points[i + 1].position);
+		}
+	}
+
+	return distance;
+}
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include "distance_transform.h"
+#include "mapped_file.h"
+
+
+static const int TILE_SIZE = 64;
+
+// wide enough for the knight moves of Sixteen connectivity
+static const int HALO = 2;
+
+
+typedef std::pair<float, int> QueueEntry;
+
+
+void calcSurfaceDistanceTransform(const std::vector<unsigned char>& seedMask,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool, GraphConnectivity connectivity)
+{
+	std::size_t pixelCount = static_cast<std::size_t>(imageWidth) * imageHeight;
+	if (seedMask.size() < pixelCount || heightdata.size() < pixelCount) {
+		throw std::invalid_argument("the seed mask and the height data must cover the image");
+	}
+
+	const float infinity = std::numeric_limits<float>::infinity();
+	const std::vector<glm::ivec2> offsets = getNeighbourOffsets(connectivity);
+	const int neighbourCount = static_cast<int>(offsets.size());
+	std::vector<int> opposites(neighbourCount);
+	for (int neighbour = 0; neighbour < neighbourCount; ++neighbour) {
+		opposites[neighbour] = static_cast<int>(std::find(offsets.begin(), offsets.end(), -offsets[neighbour]) - offsets.begin());
+	}
+
+	const int tilesX = (imageWidth + TILE_SIZE - 1) / TILE_SIZE;
+	const int tilesY = (imageHeight + TILE_SIZE - 1) / TILE_SIZE;
+	const std::size_t tileCount = static_cast<std::size_t>(tilesX) * tilesY;
+	const int windowSize = TILE_SIZE + 2 * HALO;
+
+	// every flag is only written by the task of its own tile, or between the parallel phases
+	std::vector<unsigned char> active(tileCount, 0);
+	std::vector<unsigned char> started(tileCount, 0);
+	std::vector<unsigned char> borderChanged(tileCount, 0);
+
+	auto getTileBounds = [&](std::size_t tile, glm::ivec2& begin, glm::ivec2& end) {
+		begin = glm::ivec2(static_cast<int>(tile % tilesX), static_cast<int>(tile / tilesX)) * TILE_SIZE;
+		end = glm::min(begin + TILE_SIZE, glm::ivec2(imageWidth, imageHeight));
+	};
+
+	pool.parallelFor(tileCount, [&](std::size_t tile) {
+		glm::ivec2 begin, end;
+		getTileBounds(tile, begin, end);
+		for (int y = begin.y; y < end.y; ++y) {
+			for (int x = begin.x; x < end.x; ++x) {
+				std::size_t index = static_cast<std::size_t>(y) * imageWidth + x;
+				distances[index] = seedMask[index] ? 0.0f : infinity;
+				active[tile] |= seedMask[index] ? 1 : 0;
+			}
+		}
+	});
+
+	std::vector<std::size_t> tiles;
+	std::vector<std::vector<float>> windows;
+	while (true) {
+		tiles.clear();
+		for (std::size_t tile = 0; tile < tileCount; ++tile) {
+			if (active[tile]) {
+				tiles.push_back(tile);
+				active[tile] = 0;
+			}
+		}
+
+		if (tiles.empty()) {
+			break;
+		}
+
+		// snapshot the tiles with their halos while no tile writes
+		windows.resize(tiles.size());
+		pool.parallelFor(tiles.size(), [&](std::size_t i) {
+			glm::ivec2 begin, end;
+			getTileBounds(tiles[i], begin, end);
+			std::vector<float>& window = windows[i];
+			window.assign(windowSize * windowSize, infinity);
+			for (int y = std::max(begin.y - HALO, 0); y < std::min(end.y + HALO, imageHeight); ++y) {
+				for (int x = std::max(begin.x - HALO, 0); x < std::min(end.x + HALO, imageWidth); ++x) {
+					window[(y - begin.y + HALO) * windowSize + (x - begin.x + HALO)] = distances[static_cast<std::size_t>(y) * imageWidth + x];
+				}
+			}
+		});
+
+		pool.parallelFor(tiles.size(), [&](std::size_t i) {
+			std::size_t tile = tiles[i];
+			glm::ivec2 begin, end;
+			getTileBounds(tile, begin, end);
+			glm::ivec2 origin = begin - HALO;
+			std::vector<float>& window = windows[i];
+			auto isInside = [&](glm::ivec2 pixel) {
+				return pixel.x >= begin.x && pixel.y >= begin.y && pixel.x < end.x && pixel.y < end.y;
+			};
+
+			// both directions of an edge are relaxed in a run, so each weight is computed once per run and kept for the other direction
+			static thread_local std::vector<float> weights;
+			weights.assign(windowSize * windowSize * neighbourCount, -1.0f);
+
+			// the own pixels of a tile only change when it runs, so after its first round only the halo brings news
+			std::vector<QueueEntry> queue;
+			for (int y = 0; y < windowSize; ++y) {
+				for (int x = 0; x < windowSize; ++x) {
+					float distance = window[y * windowSize + x];
+					if (distance != infinity && (!started[tile] || !isInside(origin + glm::ivec2(x, y)))) {
+						queue.emplace_back(distance, y * windowSize + x);
+					}
+				}
+			}
+
+			std::make_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+			while (!queue.empty()) {
+				std::pop_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+				QueueEntry entry = queue.back();
+				queue.pop_back();
+				if (entry.first > window[entry.second]) {
+					continue;
+				}
+
+				glm::ivec2 pixel = origin + glm::ivec2(entry.second % windowSize, entry.second / windowSize);
+				for (int neighbour = 0; neighbour < neighbourCount; ++neighbour) {
+					glm::ivec2 next = pixel + offsets[neighbour];
+					if (!isInside(next)) {
+						continue;
+					}
+
+					int nextIndex = (next.y - origin.y) * windowSize + (next.x - origin.x);
+					float& weight = weights[entry.second * neighbourCount + neighbour];
+					if (weight < 0.0f) {
+						weight = calcEdgeWeight(pixel, next, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+						weights[nextIndex * neighbourCount + opposites[neighbour]] = weight;
+					}
+
+					float distance = entry.first + weight;
+					if (distance < window[nextIndex]) {
+						window[nextIndex] = distance;
+						queue.emplace_back(distance, nextIndex);
+						std::push_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+					}
+				}
+			}
+
+			for (int y = begin.y; y < end.y; ++y) {
+				for (int x = begin.x; x < end.x; ++x) {
+					float& distance = distances[static_cast<std::size_t>(y) * imageWidth + x];
+					float local = window[(y - origin.y) * windowSize + (x - origin.x)];
+					if (local < distance) {
+						distance = local;
+						if (x - begin.x < HALO || y - begin.y < HALO || end.x - x <= HALO || end.y - y <= HALO) {
+							borderChanged[tile] = 1;
+						}
+					}
+				}
+			}
+
+			started[tile] = 1;
+		});
+
+		for (std::size_t tile : tiles) {
+			if (!borderChanged[tile]) {
+				continue;
+			}
+
+			borderChanged[tile] = 0;
+			int tileX = static_cast<int>(tile % tilesX);
+			int tileY = static_cast<int>(tile / tilesX);
+			for (int y = std::max(tileY - 1, 0); y <= std::min(tileY + 1, tilesY - 1); ++y) {
+				for (int x = std::max(tileX - 1, 0); x <= std::min(tileX + 1, tilesX - 1); ++x) {
+					if (x != tileX || y != tileY) {
+						active[static_cast<std::size_t>(y) * tilesX + x] = 1;
+					}
+				}
+			}
+		}
+	}
+}
+
+
+void writeSurfaceDistanceTransform(const std::string& filename, const std::vector<unsigned char>& seedMask,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool, GraphConnectivity connectivity)
+{
+	MappedFile file(filename, static_cast<std::size_t>(imageWidth) * imageHeight * sizeof(float));
+	calcSurfaceDistanceTransform(seedMask, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight,
+		static_cast<float*>(file.getData()), pool, connectivity);
+	file.flush();
+}
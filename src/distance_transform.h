@@ -0,0 +1,37 @@
+#ifndef DISTANCE_TRANSFORM_H
+#define DISTANCE_TRANSFORM_H
+
+#include <string>
+#include <vector>
+#include "graph.h"
+#include "thread_pool.h"
+
+
+/*********
+Surface distance from every pixel to the nearest seed pixel, a pixel whose seedMask byte is not 0.
+Distances follow the pixel graph of SurfaceGraph, whose edges weigh the surface distance of the straight line between neighbours,
+so with Sixteen connectivity they stay within a few percent above the geodesic distance. distances receives imageWidth * imageHeight
+values row by row. Pixels no seed reaches get infinity.
+
+The image is cut into tiles of 64x64 pixels that run Dijkstra's algorithm in parallel, in rounds:
+- every tile that works in a round first copies its own pixels and a halo 2 pixels wide around them, while no tile writes
+- each tile then runs Dijkstra from its seeds (in its first round) and its halo, and writes back only its own pixels
+- a tile that lowers a distance within 2 pixels of its border activates its neighbours for the next round
+The rounds stop when no tile is active, at which point every distance is that of the shortest path to a seed.
+The edge weights are computed as needed, so the memory used besides distances is a few tiles per thread.
+**********/
+void calcSurfaceDistanceTransform(const std::vector<unsigned char>& seedMask,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool, GraphConnectivity connectivity = GraphConnectivity::Sixteen);
+
+
+/*********
+Same as calcSurfaceDistanceTransform, written straight into a file mapped into memory.
+The file holds imageWidth * imageHeight floats row by row, in the byte order of the machine, without a header.
+**********/
+void writeSurfaceDistanceTransform(const std::string& filename, const std::vector<unsigned char>& seedMask,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool, GraphConnectivity connectivity = GraphConnectivity::Sixteen);
+
+
+#endif // !DISTANCE_TRANSFORM_H
@@ -0,0 +1,645 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include "geodesic.h"
+
+
+static const float PI = 3.14159265358979f;
+
+// heap handles with this bit set are vertices, the others index the window pool
+static const std::uint32_t VERTEX_EVENT = 0x80000000u;
+
+// a vertex is a saddle if its angles add up to more than 2 pi by this much, flat vertices let geodesics through unbent
+static const float SADDLE_EPSILON = 1e-4f;
+
+// relative slack of the pruning test, so rounding cannot drop the window that carries a geodesic
+static const float PRUNE_SLACK = 1e-5f;
+
+// windows narrower than this fraction of their edge only touch a vertex, whose distance is already known
+static const float MIN_WINDOW_WIDTH = 1e-6f;
+
+// per-vertex flags; whether a vertex is a pseudo source is found the first time it matters and kept across queries
+static const unsigned char KIND_KNOWN = 1;
+static const unsigned char PSEUDO_SOURCE = 2;
+static const unsigned char ACCEPTED = 4;
+
+
+struct Triangle {
+	glm::ivec2 voxel;
+	int upper;
+};
+
+
+static float cross(glm::vec2 a, glm::vec2 b) {
+	return a.x * b.y - a.y * b.x;
+}
+
+
+static void getTriangleVertices(const Triangle& triangle, glm::ivec2* vertices) {
+	glm::ivec2 voxel = triangle.voxel;
+	if (triangle.upper) {
+		vertices[0] = voxel + glm::ivec2(1, 1);
+		vertices[1] = voxel + glm::ivec2(0, 1);
+		vertices[2] = voxel + glm::ivec2(1, 0);
+	}
+	else {
+		vertices[0] = voxel;
+		vertices[1] = voxel + glm::ivec2(1, 0);
+		vertices[2] = voxel + glm::ivec2(0, 1);
+	}
+}
+
+
+static void getEdgeEnds(const GeodesicEdge& edge, glm::ivec2& first, glm::ivec2& second) {
+	switch (edge.type) {
+	case 0:
+		first = edge.cell;
+		second = edge.cell + glm::ivec2(1, 0);
+		break;
+	case 1:
+		first = edge.cell;
+		second = edge.cell + glm::ivec2(0, 1);
+		break;
+	default:
+		first = edge.cell + glm::ivec2(1, 0);
+		second = edge.cell + glm::ivec2(0, 1);
+		break;
+	}
+}
+
+
+static GeodesicEdge makeEdge(glm::ivec2 a, glm::ivec2 b) {
+	glm::ivec2 cell = glm::min(a, b);
+	if (a.y == b.y) {
+		return GeodesicEdge{ 0, cell };
+	}
+
+	if (a.x == b.x) {
+		return GeodesicEdge{ 1, cell };
+	}
+
+	return GeodesicEdge{ 2, cell };
+}
+
+
+// side 0 of every edge is a lower triangle, side 1 an upper triangle
+static Triangle getEdgeTriangle(const GeodesicEdge& edge, int side) {
+	if (side == 0) {
+		return Triangle{ edge.cell, 0 };
+	}
+
+	switch (edge.type) {
+	case 0:
+		return Triangle{ edge.cell - glm::ivec2(0, 1), 1 };
+	case 1:
+		return Triangle{ edge.cell - glm::ivec2(1, 0), 1 };
+	default:
+		return Triangle{ edge.cell, 1 };
+	}
+}
+
+
+static int getIncidentTriangles(glm::ivec2 pixel, int imageWidth, int imageHeight, Triangle* triangles) {
+	const Triangle candidates[] = {
+		Triangle{ pixel, 0 },
+		Triangle{ pixel - glm::ivec2(1, 0), 0 },
+		Triangle{ pixel - glm::ivec2(0, 1), 0 },
+		Triangle{ pixel - glm::ivec2(1, 1), 1 },
+		Triangle{ pixel - glm::ivec2(1, 0), 1 },
+		Triangle{ pixel - glm::ivec2(0, 1), 1 }
+	};
+
+	int count = 0;
+	for (const Triangle& candidate : candidates) {
+		glm::ivec2 voxel = candidate.voxel;
+		if (voxel.x >= 0 && voxel.y >= 0 && voxel.x < imageWidth - 1 && voxel.y < imageHeight - 1) {
+			triangles[count++] = candidate;
+		}
+	}
+
+	return count;
+}
+
+
+// the two vertices of the triangle other than pixel, in the order they appear in the triangle
+static void getOtherVertices(const Triangle& triangle, glm::ivec2 pixel, glm::ivec2& first, glm::ivec2& second) {
+	glm::ivec2 vertices[3];
+	getTriangleVertices(triangle, vertices);
+	int index = vertices[0] == pixel ? 0 : (vertices[1] == pixel ? 1 : 2);
+	first = vertices[(index + 1) % 3];
+	second = vertices[(index + 2) % 3];
+}
+
+
+// position of c in the plane where a is the origin and b lies on the positive x axis, with c at y >= 0
+static glm::vec2 unfold(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+	float length = glm::distance(a, b);
+	float toA = glm::dot(c - a, c - a);
+	float toB = glm::dot(c - b, c - b);
+	float x = (toA - toB + length * length) / (2.0f * length);
+	return glm::vec2(x, std::sqrt(std::max(toA - x * x, 0.0f)));
+}
+
+
+// point where the ray from source through (through, 0) meets the segment from a to b, clamped to the segment
+static glm::vec2 intersectRay(glm::vec2 source, float through, glm::vec2 a, glm::vec2 b) {
+	glm::vec2 ray = glm::vec2(through, 0.0f) - source;
+	glm::vec2 segment = b - a;
+	float denominator = cross(segment, ray);
+	float t;
+	if (std::abs(denominator) < 1e-12f) {
+		t = glm::dot(glm::vec2(through, 0.0f) - a, segment) / glm::dot(segment, segment);
+	}
+	else {
+		t = cross(source - a, ray) / denominator;
+	}
+
+	return a + glm::clamp(t, 0.0f, 1.0f) * segment;
+}
+
+
+static float calcWindowKey(const GeodesicWindow& window) {
+	float x = glm::clamp(window.source.x, window.begin, window.end);
+	return window.sigma + glm::distance(window.source, glm::vec2(x, 0.0f));
+}
+
+
+// distance of c from a virtual point source at distanceA from a and distanceB from b, on the side of ab away from c,
+// if the straight line from the source to c crosses ab
+static bool calcVirtualSourceDistance(glm::vec2 a, float distanceA, glm::vec2 b, float distanceB, glm::vec2 c, float& distance) {
+	float length = glm::distance(a, b);
+	glm::vec2 direction = (b - a) / length;
+	glm::vec2 normal(-direction.y, direction.x);
+	if (glm::dot(c - a, normal) < 0.0f) {
+		normal = -normal;
+	}
+
+	float x = (distanceA * distanceA - distanceB * distanceB + length * length) / (2.0f * length);
+	float y2 = distanceA * distanceA - x * x;
+	if (y2 < 0.0f) {
+		return false;
+	}
+
+	glm::vec2 source = a + direction * x - normal * std::sqrt(y2);
+	float sourceHeight = glm::dot(source - a, normal);
+	float targetHeight = glm::dot(c - a, normal);
+	if (targetHeight - sourceHeight <= 0.0f) {
+		return false;
+	}
+
+	glm::vec2 crossing = source + (c - source) * (-sourceHeight / (targetHeight - sourceHeight));
+	float t = glm::dot(crossing - a, direction);
+	if (t < 0.0f || t > length) {
+		return false;
+	}
+
+	distance = glm::distance(source, c);
+	return true;
+}
+
+
+GeodesicSolver::GeodesicSolver(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight)
+	: _heightdata{heightdata}, _imageWidth{imageWidth}, _imageHeight{imageHeight}, _pixelDistance{pixelDistance}, _pixelHeight{pixelHeight}, _hasTarget{false}, _eventCount{0}
+{
+	if (imageWidth < 2 || imageHeight < 2) {
+		throw std::invalid_argument("the height data must hold at least 2x2 pixels");
+	}
+
+	std::size_t vertexCount = static_cast<std::size_t>(imageWidth) * imageHeight;
+	_distances.assign(vertexCount, std::numeric_limits<float>::infinity());
+	_vertexFlags.assign(vertexCount, 0);
+}
+
+
+float GeodesicSolver::findGeodesicDistance(glm::ivec2 source, glm::ivec2 target, GeodesicMode mode) {
+	if (target.x < 0 || target.y < 0 || target.x >= _imageWidth || target.y >= _imageHeight) {
+		throw std::out_of_range("the target is outside of the image");
+	}
+
+	std::int64_t targetVertex = static_cast<std::int64_t>(target.y) * _imageWidth + target.x;
+	run(source, targetVertex, mode);
+	return _distances[targetVertex];
+}
+
+
+void GeodesicSolver::findGeodesicDistances(glm::ivec2 source, GeodesicMode mode) {
+	run(source, -1, mode);
+}
+
+
+float GeodesicSolver::getDistance(glm::ivec2 pixel) const {
+	return _distances[static_cast<std::size_t>(pixel.y) * _imageWidth + pixel.x];
+}
+
+
+std::size_t GeodesicSolver::getEventCount() const {
+	return _eventCount;
+}
+
+
+void GeodesicSolver::reset() {
+	for (std::uint32_t vertex : _touched) {
+		_distances[vertex] = std::numeric_limits<float>::infinity();
+		_vertexFlags[vertex] &= ~ACCEPTED;
+	}
+
+	_touched.clear();
+	_windows.clear();
+	_freeWindows.clear();
+	_heap.clear();
+	_eventCount = 0;
+}
+
+
+void GeodesicSolver::run(glm::ivec2 source, std::int64_t target, GeodesicMode mode) {
+	if (source.x < 0 || source.y < 0 || source.x >= _imageWidth || source.y >= _imageHeight) {
+		throw std::out_of_range("the source is outside of the image");
+	}
+
+	reset();
+	_hasTarget = target >= 0;
+	if (_hasTarget) {
+		_targetPosition = getPosition(glm::ivec2(static_cast<int>(target % _imageWidth), static_cast<int>(target / _imageWidth)));
+	}
+
+	std::uint32_t sourceVertex = static_cast<std::uint32_t>(source.y * _imageWidth + source.x);
+	updateVertex(sourceVertex, 0.0f);
+	if (mode == GeodesicMode::Exact) {
+		pushEvent(getTargetBound(source), sourceVertex | VERTEX_EVENT);
+		runExact(target);
+	}
+	else {
+		pushEvent(0.0f, sourceVertex);
+		runFastMarching(target);
+	}
+}
+
+
+void GeodesicSolver::runExact(std::int64_t target) {
+	while (!_heap.empty()) {
+		// a key is a lower bound of every distance that can reach the target through its event,
+		// so once the smallest one reaches the target distance, the distance is final
+		if (target >= 0 && _heap.front().first >= _distances[target]) {
+			break;
+		}
+
+		std::pop_heap(_heap.begin(), _heap.end(), std::greater<std::pair<float, std::uint32_t>>());
+		std::pair<float, std::uint32_t> entry = _heap.back();
+		_heap.pop_back();
+		++_eventCount;
+
+		if (entry.second & VERTEX_EVENT) {
+			std::uint32_t vertex = entry.second & ~VERTEX_EVENT;
+			glm::ivec2 pixel(vertex % _imageWidth, vertex / _imageWidth);
+			if (entry.first <= _distances[vertex] + getTargetBound(pixel)) {
+				propagateVertex(vertex);
+			}
+		}
+		else {
+			GeodesicWindow window = _windows[entry.second];
+			_freeWindows.push_back(entry.second);
+			propagateWindow(window);
+		}
+	}
+}
+
+
+void GeodesicSolver::runFastMarching(std::int64_t target) {
+	while (!_heap.empty()) {
+		std::pop_heap(_heap.begin(), _heap.end(), std::greater<std::pair<float, std::uint32_t>>());
+		std::pair<float, std::uint32_t> entry = _heap.back();
+		_heap.pop_back();
+
+		std::uint32_t vertex = entry.second;
+		if ((_vertexFlags[vertex] & ACCEPTED) || entry.first > _distances[vertex]) {
+			continue;
+		}
+
+		_vertexFlags[vertex] |= ACCEPTED;
+		++_eventCount;
+		if (vertex == target) {
+			break;
+		}
+
+		glm::ivec2 pixel(vertex % _imageWidth, vertex / _imageWidth);
+		glm::vec3 position = getPosition(pixel);
+		float distance = _distances[vertex];
+		// next is updated from the triangle (vertex, other, next) through a virtual point source. The angle at next is often obtuse
+		// on steep ground, and then the source seen from vertex and other lies outside of the triangle. The triangle on the other side
+		// of the edge from vertex to other is unfolded as well, which splits the obtuse angle at the vertex opposite to next
+		auto relax = [&](const Triangle& triangle, glm::ivec2 next, glm::ivec2 other) {
+			std::uint32_t nextVertex = static_cast<std::uint32_t>(next.y * _imageWidth + next.x);
+			if (_vertexFlags[nextVertex] & ACCEPTED) {
+				return;
+			}
+
+			glm::vec3 otherPosition = getPosition(other);
+			glm::vec2 flatVertex(0.0f);
+			glm::vec2 flatOther(glm::distance(position, otherPosition), 0.0f);
+			glm::vec2 flatNext = unfold(position, otherPosition, getPosition(next));
+			float candidate = distance + glm::length(flatNext);
+			float through;
+
+			std::uint32_t otherVertex = static_cast<std::uint32_t>(other.y * _imageWidth + other.x);
+			bool otherAccepted = (_vertexFlags[otherVertex] & ACCEPTED) != 0;
+			if (otherAccepted && calcVirtualSourceDistance(flatVertex, distance, flatOther, _distances[otherVertex], flatNext, through)) {
+				candidate = std::min(candidate, through);
+			}
+
+			Triangle across = getEdgeTriangle(makeEdge(pixel, other), 1 - triangle.upper);
+			if (across.voxel.x >= 0 && across.voxel.y >= 0 && across.voxel.x < _imageWidth - 1 && across.voxel.y < _imageHeight - 1) {
+				glm::ivec2 first, second;
+				getOtherVertices(across, pixel, first, second);
+				glm::ivec2 opposite = first == other ? second : first;
+				std::uint32_t oppositeVertex = static_cast<std::uint32_t>(opposite.y * _imageWidth + opposite.x);
+				if (_vertexFlags[oppositeVertex] & ACCEPTED) {
+					glm::vec2 flatOpposite = unfold(position, otherPosition, getPosition(opposite));
+					flatOpposite.y = -flatOpposite.y;
+					float oppositeDistance = _distances[oppositeVertex];
+					if (calcVirtualSourceDistance(flatVertex, distance, flatOpposite, oppositeDistance, flatNext, through)) {
+						candidate = std::min(candidate, through);
+					}
+
+					if (otherAccepted && calcVirtualSourceDistance(flatOpposite, oppositeDistance, flatOther, _distances[otherVertex], flatNext, through)) {
+						candidate = std::min(candidate, through);
+					}
+				}
+			}
+
+			if (updateVertex(nextVertex, candidate)) {
+				pushEvent(candidate, nextVertex);
+			}
+		};
+
+		Triangle triangles[6];
+		int triangleCount = getIncidentTriangles(pixel, _imageWidth, _imageHeight, triangles);
+		for (int i = 0; i < triangleCount; ++i) {
+			glm::ivec2 first, second;
+			getOtherVertices(triangles[i], pixel, first, second);
+			relax(triangles[i], first, second);
+			relax(triangles[i], second, first);
+		}
+	}
+}
+
+
+bool GeodesicSolver::updateVertex(std::uint32_t vertex, float distance) {
+	float& current = _distances[vertex];
+	if (distance >= current) {
+		return false;
+	}
+
+	if (current == std::numeric_limits<float>::infinity()) {
+		// the list grows to one entry per vertex at most, so it never takes more than 4 bytes per pixel
+		if (_touched.size() == _touched.capacity()) {
+			_touched.reserve(std::min(std::max<std::size_t>(2 * _touched.capacity(), 1024), _distances.size()));
+		}
+
+		_touched.push_back(vertex);
+	}
+
+	current = distance;
+	return true;
+}
+
+
+void GeodesicSolver::reachVertex(glm::ivec2 pixel, float distance) {
+	std::uint32_t vertex = static_cast<std::uint32_t>(pixel.y * _imageWidth + pixel.x);
+	if (updateVertex(vertex, distance) && isPseudoSource(pixel)) {
+		pushEvent(distance + getTargetBound(pixel), vertex | VERTEX_EVENT);
+	}
+}
+
+
+void GeodesicSolver::pushEvent(float key, std::uint32_t handle) {
+	_heap.emplace_back(key, handle);
+	std::push_heap(_heap.begin(), _heap.end(), std::greater<std::pair<float, std::uint32_t>>());
+}
+
+
+void GeodesicSolver::pushWindow(const GeodesicWindow& window) {
+	glm::ivec2 vertices[3];
+	glm::vec2 positions[3];
+	getWindowTriangle(window, vertices, positions);
+	if (isPruned(window, vertices, positions)) {
+		return;
+	}
+
+	std::uint32_t index;
+	if (_freeWindows.empty()) {
+		index = static_cast<std::uint32_t>(_windows.size());
+		_windows.push_back(window);
+	}
+	else {
+		index = _freeWindows.back();
+		_freeWindows.pop_back();
+		_windows[index] = window;
+	}
+
+	float bound = 0.0f;
+	if (_hasTarget) {
+		// the target is at least as far from the window as the closest point of the edge segment it covers
+		glm::vec3 first = getPosition(vertices[0]);
+		glm::vec3 direction = (getPosition(vertices[1]) - first) / positions[1].x;
+		float x = glm::clamp(glm::dot(_targetPosition - first, direction), window.begin, window.end);
+		bound = glm::distance(first + direction * x, _targetPosition);
+	}
+
+	pushEvent(calcWindowKey(window) + bound, index);
+}
+
+
+void GeodesicSolver::propagateVertex(std::uint32_t vertex) {
+	glm::ivec2 pixel(vertex % _imageWidth, vertex / _imageWidth);
+	glm::vec3 position = getPosition(pixel);
+	float sigma = _distances[vertex];
+
+	Triangle triangles[6];
+	int triangleCount = getIncidentTriangles(pixel, _imageWidth, _imageHeight, triangles);
+	for (int i = 0; i < triangleCount; ++i) {
+		glm::ivec2 first, second;
+		getOtherVertices(triangles[i], pixel, first, second);
+		GeodesicEdge edge = makeEdge(first, second);
+		getEdgeEnds(edge, first, second);
+
+		glm::vec3 firstPosition = getPosition(first);
+		glm::vec3 secondPosition = getPosition(second);
+		reachVertex(first, sigma + glm::distance(position, firstPosition));
+		reachVertex(second, sigma + glm::distance(position, secondPosition));
+
+		// the window leaves the triangle around the vertex through the opposite edge
+		int side = 1 - triangles[i].upper;
+		Triangle next = getEdgeTriangle(edge, side);
+		if (next.voxel.x < 0 || next.voxel.y < 0 || next.voxel.x >= _imageWidth - 1 || next.voxel.y >= _imageHeight - 1) {
+			continue;
+		}
+
+		glm::vec2 source = unfold(firstPosition, secondPosition, position);
+		pushWindow(GeodesicWindow{ edge, side, 0.0f, glm::distance(firstPosition, secondPosition), glm::vec2(source.x, -source.y), sigma });
+	}
+}
+
+
+void GeodesicSolver::propagateWindow(const GeodesicWindow& window) {
+	glm::ivec2 vertices[3];
+	glm::vec2 positions[3];
+	getWindowTriangle(window, vertices, positions);
+	if (isPruned(window, vertices, positions)) {
+		return;
+	}
+
+	glm::vec2 source = window.source;
+	glm::vec2 apex = positions[2];
+	float denominator = apex.y - source.y;
+	if (denominator <= 0.0f) {
+		return;
+	}
+
+	// rays that cross the edge left of where the ray to the apex crosses it leave through the edge from the first end to the apex
+	// the ends of the window count as seen, geodesics through flat vertices run along them
+	float apexCrossing = source.x + (apex.x - source.x) * -source.y / denominator;
+	float tolerance = MIN_WINDOW_WIDTH * positions[1].x;
+	if (apexCrossing >= window.begin - tolerance && apexCrossing <= window.end + tolerance) {
+		reachVertex(vertices[2], window.sigma + glm::distance(source, apex));
+	}
+
+	Triangle triangle = getEdgeTriangle(window.edge, window.side);
+	if (window.begin < apexCrossing) {
+		glm::vec2 a = intersectRay(source, window.begin, positions[0], apex);
+		glm::vec2 b = apexCrossing < window.end ? apex : intersectRay(source, window.end, positions[0], apex);
+		pushChildWindow(window, triangle.upper, vertices[0], vertices[2], positions[0], apex, a, b);
+	}
+
+	if (window.end > apexCrossing) {
+		glm::vec2 a = apexCrossing > window.begin ? apex : intersectRay(source, window.begin, apex, positions[1]);
+		glm::vec2 b = intersectRay(source, window.end, apex, positions[1]);
+		pushChildWindow(window, triangle.upper, vertices[2], vertices[1], apex, positions[1], a, b);
+	}
+}
+
+
+void GeodesicSolver::pushChildWindow(const GeodesicWindow& parent, int upper, glm::ivec2 from, glm::ivec2 to,
+	glm::vec2 fromPosition, glm::vec2 toPosition, glm::vec2 begin, glm::vec2 end)
+{
+	GeodesicEdge edge = makeEdge(from, to);
+	int side = 1 - upper;
+	Triangle next = getEdgeTriangle(edge, side);
+	if (next.voxel.x < 0 || next.voxel.y < 0 || next.voxel.x >= _imageWidth - 1 || next.voxel.y >= _imageHeight - 1) {
+		return;
+	}
+
+	// express the window in the frame of the edge, whose first end may be either of from and to
+	glm::ivec2 first, second;
+	getEdgeEnds(edge, first, second);
+	glm::vec2 origin = first == from ? fromPosition : toPosition;
+	glm::vec2 direction = (first == from ? toPosition : fromPosition) - origin;
+	float length = glm::length(direction);
+	direction /= length;
+
+	float a = glm::dot(begin - origin, direction);
+	float b = glm::dot(end - origin, direction);
+	float windowBegin = glm::clamp(std::min(a, b), 0.0f, length);
+	float windowEnd = glm::clamp(std::max(a, b), 0.0f, length);
+	if (windowEnd - windowBegin <= MIN_WINDOW_WIDTH * length) {
+		return;
+	}
+
+	// the source lies on the side of the triangle the window leaves
+	glm::vec2 relative = parent.source - origin;
+	glm::vec2 source(glm::dot(relative, direction), -std::abs(cross(direction, relative)));
+	pushWindow(GeodesicWindow{ edge, side, windowBegin, windowEnd, source, parent.sigma });
+}
+
+
+void GeodesicSolver::getWindowTriangle(const GeodesicWindow& window, glm::ivec2* vertices, glm::vec2* positions) const {
+	getEdgeEnds(window.edge, vertices[0], vertices[1]);
+	glm::ivec2 triangleVertices[3];
+	getTriangleVertices(getEdgeTriangle(window.edge, window.side), triangleVertices);
+	for (glm::ivec2 vertex : triangleVertices) {
+		if (vertex != vertices[0] && vertex != vertices[1]) {
+			vertices[2] = vertex;
+		}
+	}
+
+	glm::vec3 first = getPosition(vertices[0]);
+	glm::vec3 second = getPosition(vertices[1]);
+	positions[0] = glm::vec2(0.0f);
+	positions[1] = glm::vec2(glm::distance(first, second), 0.0f);
+	positions[2] = unfold(first, second, getPosition(vertices[2]));
+}
+
+
+bool GeodesicSolver::isPruned(const GeodesicWindow& window, const glm::ivec2* vertices, const glm::vec2* positions) const {
+	// the source mirrored to the side of the triangle, it is as far from every point of the edge as the source
+	glm::vec2 mirrored(window.source.x, -window.source.y);
+	float slack = calcWindowKey(window) * PRUNE_SLACK;
+	for (int i = 0; i < 3; ++i) {
+		float distance = _distances[static_cast<std::size_t>(vertices[i].y) * _imageWidth + vertices[i].x];
+		if (distance == std::numeric_limits<float>::infinity()) {
+			continue;
+		}
+
+		// |Vq| - |Sq| along the edge has one extremum, where the line through V and the mirrored source meets the edge
+		float checks[3] = { window.begin, window.end, window.begin };
+		float denominator = mirrored.y - positions[i].y;
+		if (denominator != 0.0f) {
+			float extremum = positions[i].x + (mirrored.x - positions[i].x) * -positions[i].y / denominator;
+			checks[2] = glm::clamp(extremum, window.begin, window.end);
+		}
+
+		bool dominated = true;
+		for (float x : checks) {
+			glm::vec2 point(x, 0.0f);
+			if (distance + glm::distance(positions[i], point) >= window.sigma + glm::distance(window.source, point) - slack) {
+				dominated = false;
+				break;
+			}
+		}
+
+		if (dominated) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+float GeodesicSolver::getTargetBound(glm::ivec2 pixel) const {
+	return _hasTarget ? glm::distance(getPosition(pixel), _targetPosition) : 0.0f;
+}
+
+
+bool GeodesicSolver::isPseudoSource(glm::ivec2 pixel) {
+	unsigned char& flags = _vertexFlags[static_cast<std::size_t>(pixel.y) * _imageWidth + pixel.x];
+	if (!(flags & KIND_KNOWN)) {
+		bool border = pixel.x == 0 || pixel.y == 0 || pixel.x == _imageWidth - 1 || pixel.y == _imageHeight - 1;
+		float angle = 0.0f;
+		if (!border) {
+			glm::vec3 position = getPosition(pixel);
+			Triangle triangles[6];
+			int triangleCount = getIncidentTriangles(pixel, _imageWidth, _imageHeight, triangles);
+			for (int i = 0; i < triangleCount; ++i) {
+				glm::ivec2 first, second;
+				getOtherVertices(triangles[i], pixel, first, second);
+				glm::vec3 a = glm::normalize(getPosition(first) - position);
+				glm::vec3 b = glm::normalize(getPosition(second) - position);
+				angle += std::acos(glm::clamp(glm::dot(a, b), -1.0f, 1.0f));
+			}
+		}
+
+		flags |= KIND_KNOWN;
+		if (border || angle > 2.0f * PI + SADDLE_EPSILON) {
+			flags |= PSEUDO_SOURCE;
+		}
+	}
+
+	return (flags & PSEUDO_SOURCE) != 0;
+}
+
+
+glm::vec3 GeodesicSolver::getPosition(glm::ivec2 pixel) const {
+	return glm::vec3(static_cast<glm::vec2>(pixel) * _pixelDistance, _heightdata[pixel.y * _imageWidth + pixel.x] * _pixelHeight);
+}
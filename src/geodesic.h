@@ -0,0 +1,138 @@
+#ifndef GEODESIC_H
+#define GEODESIC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "glm/glm.hpp"
+
+
+enum class GeodesicMode {
+	Exact,
+	FastMarching
+};
+
+
+/*********
+An edge of the triangulated surface. type 0 runs from (x, y) to (x + 1, y), type 1 from (x, y) to (x, y + 1)
+and type 2 is the voxel diagonal from (x + 1, y) to (x, y + 1).
+**********/
+struct GeodesicEdge {
+	int type;
+	glm::ivec2 cell;
+};
+
+
+/*********
+The part [begin, end] of an edge that a source sees straight. The source is unfolded into the plane of the edge,
+with the first end of the edge at the origin, the second at (length, 0) and the triangle the window enters at y > 0.
+side is 0 if that triangle is the lower triangle of its voxel, 1 if it is the upper one.
+**********/
+struct GeodesicWindow {
+	GeodesicEdge edge;
+	int side;
+	float begin;
+	float end;
+	glm::vec2 source;
+	float sigma;
+};
+
+
+/*********
+Shortest paths over the triangulated surface calcSurfaceDistance walks, not restricted to straight lines or to the pixel graph.
+Every voxel is split into two triangles by its diagonal from (x + 1, y) to (x, y + 1). Sources and targets are pixels.
+
+Exact mode propagates windows across the triangles the way Chen and Han do, with improvements in the style of Xin and Wang:
+- a window is an interval of an edge that is seen straight from one (unfolded) source, with the distance sigma at that source
+- windows and vertices are processed in order of the smallest distance they can give, from one binary heap.
+  A query with a target adds the 3D distance to the target, which no path on the surface can beat, so the search heads for it
+- a window is dropped if one of the 3 vertices V of the triangle it enters already has d(V) + |Vq| < sigma + |Sq| for every point q
+  of the window, which only needs the ends of the window and the one point where |Vq| - |Sq| has its extremum
+- saddle vertices (angle sum above 2 pi) and vertices on the border become new sources, geodesics can bend only there
+FastMarching mode computes approximate distances on the vertices only, updating a vertex from two known vertices through a virtual
+point source. Obtuse angles, which steep ground makes common, are split by unfolding the next triangle as well.
+
+Windows live in a pool that is reused across queries, and the heap holds indices into it, so no window allocates on its own.
+Per-vertex state is reset only where the last query touched it, so a query that stops early costs little on large grids.
+Besides the windows on the heap, the solver keeps 5 bytes per pixel, and 4 more for every vertex the largest query so far reached
+in the list that resets them. A query over the whole grid brings it to 9 bytes per pixel, about 180 MB for 4512x4512 pixels.
+The height data must outlive the solver. A solver is not safe to use from several threads at once.
+**********/
+class GeodesicSolver {
+public:
+	GeodesicSolver(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+	/*********
+	Geodesic distance from source to target. The search stops as soon as no remaining window can give target a shorter distance.
+	**********/
+	float findGeodesicDistance(glm::ivec2 source, glm::ivec2 target, GeodesicMode mode = GeodesicMode::Exact);
+
+	/*********
+	Geodesic distance from source to every pixel. Read them back with getDistance.
+	**********/
+	void findGeodesicDistances(glm::ivec2 source, GeodesicMode mode = GeodesicMode::Exact);
+
+	/*********
+	Distance of a pixel found by the last query, or infinity if the query did not reach it.
+	After findGeodesicDistance, only the target distance is final.
+	**********/
+	float getDistance(glm::ivec2 pixel) const;
+
+	/*********
+	Number of windows and vertices the last query took from the heap.
+	**********/
+	std::size_t getEventCount() const;
+
+private:
+	void reset();
+
+	void run(glm::ivec2 source, std::int64_t target, GeodesicMode mode);
+
+	void runExact(std::int64_t target);
+
+	void runFastMarching(std::int64_t target);
+
+	bool updateVertex(std::uint32_t vertex, float distance);
+
+	void reachVertex(glm::ivec2 pixel, float distance);
+
+	void pushEvent(float key, std::uint32_t handle);
+
+	void pushWindow(const GeodesicWindow& window);
+
+	void propagateVertex(std::uint32_t vertex);
+
+	void propagateWindow(const GeodesicWindow& window);
+
+	void pushChildWindow(const GeodesicWindow& parent, int upper, glm::ivec2 from, glm::ivec2 to,
+		glm::vec2 fromPosition, glm::vec2 toPosition, glm::vec2 begin, glm::vec2 end);
+
+	void getWindowTriangle(const GeodesicWindow& window, glm::ivec2* vertices, glm::vec2* positions) const;
+
+	bool isPruned(const GeodesicWindow& window, const glm::ivec2* vertices, const glm::vec2* positions) const;
+
+	float getTargetBound(glm::ivec2 pixel) const;
+
+	bool isPseudoSource(glm::ivec2 pixel);
+
+	glm::vec3 getPosition(glm::ivec2 pixel) const;
+
+	const std::vector<unsigned char>& _heightdata;
+	int _imageWidth;
+	int _imageHeight;
+	float _pixelDistance;
+	float _pixelHeight;
+	std::vector<float> _distances;
+	std::vector<unsigned char> _vertexFlags;
+	std::vector<std::uint32_t> _touched;
+	std::vector<GeodesicWindow> _windows;
+	std::vector<std::uint32_t> _freeWindows;
+	std::vector<std::pair<float, std::uint32_t>> _heap;
+	bool _hasTarget;
+	glm::vec3 _targetPosition;
+	std::size_t _eventCount;
+};
+
+
+#endif // !GEODESIC_H
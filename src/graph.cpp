@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include "graph.h"
+#include "distance.h"
+
+
+// the potentials are scaled down a little so float rounding of the edge weights cannot make a reduced weight negative
+static const float POTENTIAL_SCALE = 0.999f;
+
+
+typedef std::pair<float, std::int32_t> QueueEntry;
+typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> NodeQueue;
+
+
+std::vector<glm::ivec2> getNeighbourOffsets(GraphConnectivity connectivity) {
+	std::vector<glm::ivec2> offsets = {
+		glm::ivec2(1, 0), glm::ivec2(1, 1), glm::ivec2(0, 1), glm::ivec2(-1, 1),
+		glm::ivec2(-1, 0), glm::ivec2(-1, -1), glm::ivec2(0, -1), glm::ivec2(1, -1)
+	};
+
+	if (connectivity == GraphConnectivity::Sixteen) {
+		const glm::ivec2 knightMoves[] = {
+			glm::ivec2(2, 1), glm::ivec2(1, 2), glm::ivec2(-1, 2), glm::ivec2(-2, 1),
+			glm::ivec2(-2, -1), glm::ivec2(-1, -2), glm::ivec2(1, -2), glm::ivec2(2, -1)
+		};
+
+		offsets.insert(offsets.end(), std::begin(knightMoves), std::end(knightMoves));
+	}
+
+	return offsets;
+}
+
+
+static int findOffset(const std::vector<glm::ivec2>& offsets, glm::ivec2 offset) {
+	return static_cast<int>(std::find(offsets.begin(), offsets.end(), offset) - offsets.begin());
+}
+
+
+float calcEdgeWeight(glm::ivec2 from, glm::ivec2 to, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight) {
+	if (from.x == to.x || from.y == to.y) {
+		glm::vec3 fromPosition(static_cast<glm::vec2>(from) * pixelDistance, heightdata[from.y * imageWidth + from.x] * pixelHeight);
+		glm::vec3 toPosition(static_cast<glm::vec2>(to) * pixelDistance, heightdata[to.y * imageWidth + to.x] * pixelHeight);
+		return glm::distance(fromPosition, toPosition);
+	}
+
+	return calcSurfaceDistance(from, to, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+}
+
+
+SurfaceGraph::SurfaceGraph(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	GraphConnectivity connectivity, ThreadPool& pool)
+	: _imageWidth{imageWidth}, _imageHeight{imageHeight}, _pixelDistance{pixelDistance}, _offsets{getNeighbourOffsets(connectivity)}
+{
+	int neighbourCount = getNeighbourCount();
+	_weights.assign(getNodeCount() * neighbourCount, std::numeric_limits<float>::infinity());
+
+	std::vector<int> opposites(neighbourCount);
+	for (int neighbour = 0; neighbour < neighbourCount; ++neighbour) {
+		opposites[neighbour] = findOffset(_offsets, -_offsets[neighbour]);
+	}
+
+	// every edge is computed once from the pixel it leaves in +y (or +x on the same row), and stored for both of its ends
+	pool.parallelFor(imageHeight, [&](std::size_t row) {
+		int y = static_cast<int>(row);
+		for (int x = 0; x < imageWidth; ++x) {
+			glm::ivec2 from{ x, y };
+			for (int neighbour = 0; neighbour < neighbourCount; ++neighbour) {
+				glm::ivec2 offset = _offsets[neighbour];
+				glm::ivec2 to = from + offset;
+				bool forward = offset.y > 0 || (offset.y == 0 && offset.x > 0);
+				if (!forward || to.x < 0 || to.x >= imageWidth || to.y < 0 || to.y >= imageHeight) {
+					continue;
+				}
+
+				float weight = calcEdgeWeight(from, to, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+				_weights[(y * imageWidth + x) * neighbourCount + neighbour] = weight;
+				_weights[(to.y * imageWidth + to.x) * neighbourCount + opposites[neighbour]] = weight;
+			}
+		}
+	});
+}
+
+
+int SurfaceGraph::getImageWidth() const {
+	return _imageWidth;
+}
+
+
+int SurfaceGraph::getImageHeight() const {
+	return _imageHeight;
+}
+
+
+float SurfaceGraph::getPixelDistance() const {
+	return _pixelDistance;
+}
+
+
+std::size_t SurfaceGraph::getNodeCount() const {
+	return static_cast<std::size_t>(_imageWidth) * _imageHeight;
+}
+
+
+int SurfaceGraph::getNeighbourCount() const {
+	return static_cast<int>(_offsets.size());
+}
+
+
+glm::ivec2 SurfaceGraph::getNeighbourOffset(int neighbour) const {
+	return _offsets[neighbour];
+}
+
+
+float SurfaceGraph::getEdgeWeight(std::size_t node, int neighbour) const {
+	return _weights[node * _offsets.size() + neighbour];
+}
+
+
+BidirectionalSearch::BidirectionalSearch(const SurfaceGraph& graph)
+	: _graph{graph}, _stamp{0}, _settledCount{0}
+{
+	for (Direction& direction : _directions) {
+		direction.distances.resize(graph.getNodeCount());
+		direction.parents.resize(graph.getNodeCount());
+		direction.stamps.assign(graph.getNodeCount(), 0);
+	}
+}
+
+
+float BidirectionalSearch::findShortestPath(glm::ivec2 begin, glm::ivec2 end, std::vector<glm::ivec2>* path) {
+	const float infinity = std::numeric_limits<float>::infinity();
+	int imageWidth = _graph.getImageWidth();
+	int neighbourCount = _graph.getNeighbourCount();
+	float pixelDistance = _graph.getPixelDistance();
+
+	// a node whose stamp is not the current one has not been reached by this query
+	if (++_stamp == 0) {
+		for (Direction& direction : _directions) {
+			std::fill(direction.stamps.begin(), direction.stamps.end(), 0);
+		}
+
+		_stamp = 1;
+	}
+
+	auto toPixel = [&](std::int32_t node) { return glm::ivec2(node % imageWidth, node / imageWidth); };
+	auto distanceOf = [&](int side, std::int32_t node) {
+		const Direction& direction = _directions[side];
+		return direction.stamps[node] == _stamp ? direction.distances[node] : infinity;
+	};
+
+	// forward potential; the backward search uses its negation
+	glm::vec2 beginPixel = static_cast<glm::vec2>(begin);
+	glm::vec2 endPixel = static_cast<glm::vec2>(end);
+	auto potential = [&](std::int32_t node) {
+		glm::vec2 pixel = static_cast<glm::vec2>(toPixel(node));
+		return 0.5f * POTENTIAL_SCALE * pixelDistance * (glm::distance(pixel, endPixel) - glm::distance(pixel, beginPixel));
+	};
+
+	std::int32_t endpoints[] = { begin.y * imageWidth + begin.x, end.y * imageWidth + end.x };
+	NodeQueue queues[2];
+	for (int side = 0; side < 2; ++side) {
+		Direction& direction = _directions[side];
+		direction.distances[endpoints[side]] = 0.0f;
+		direction.parents[endpoints[side]] = -1;
+		direction.stamps[endpoints[side]] = _stamp;
+		queues[side].push(QueueEntry(side == 0 ? potential(endpoints[side]) : -potential(endpoints[side]), endpoints[side]));
+	}
+
+	float best = endpoints[0] == endpoints[1] ? 0.0f : infinity;
+	std::int32_t meeting = endpoints[0];
+	_settledCount = 0;
+	while (!queues[0].empty() && !queues[1].empty() && queues[0].top().first + queues[1].top().first < best) {
+		int side = queues[0].top().first <= queues[1].top().first ? 0 : 1;
+		float sign = side == 0 ? 1.0f : -1.0f;
+		QueueEntry entry = queues[side].top();
+		queues[side].pop();
+
+		std::int32_t node = entry.second;
+		float distance = _directions[side].distances[node];
+		if (entry.first != distance + sign * potential(node)) {
+			continue;
+		}
+
+		++_settledCount;
+		glm::ivec2 pixel = toPixel(node);
+		for (int neighbour = 0; neighbour < neighbourCount; ++neighbour) {
+			float weight = _graph.getEdgeWeight(node, neighbour);
+			if (weight == infinity) {
+				continue;
+			}
+
+			glm::ivec2 nextPixel = pixel + _graph.getNeighbourOffset(neighbour);
+			std::int32_t next = nextPixel.y * imageWidth + nextPixel.x;
+			float nextDistance = distance + weight;
+			if (nextDistance >= distanceOf(side, next)) {
+				continue;
+			}
+
+			Direction& direction = _directions[side];
+			direction.distances[next] = nextDistance;
+			direction.parents[next] = node;
+			direction.stamps[next] = _stamp;
+			queues[side].push(QueueEntry(nextDistance + sign * potential(next), next));
+
+			float through = nextDistance + distanceOf(1 - side, next);
+			if (through < best) {
+				best = through;
+				meeting = next;
+			}
+		}
+	}
+
+	if (path) {
+		path->clear();
+		if (best != infinity) {
+			for (std::int32_t node = meeting; node != -1; node = _directions[0].parents[node]) {
+				path->push_back(toPixel(node));
+			}
+
+			std::reverse(path->begin(), path->end());
+			for (std::int32_t node = _directions[1].parents[meeting]; node != -1; node = _directions[1].parents[node]) {
+				path->push_back(toPixel(node));
+			}
+		}
+	}
+
+	return best;
+}
+
+
+std::size_t BidirectionalSearch::getSettledCount() const {
+	return _settledCount;
+}
@@ -0,0 +1,105 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+#include "thread_pool.h"
+
+
+/*********
+Which pixels are neighbours in the pixel graph. Eight adds the diagonals to the 4 axis neighbours,
+Sixteen also adds the knight moves (1, 2) and (2, 1), which bring the path closer to the true shortest path on the surface.
+**********/
+enum class GraphConnectivity {
+	Eight = 8,
+	Sixteen = 16
+};
+
+
+/*********
+Offsets from a pixel to its neighbours, in the order SurfaceGraph numbers them.
+**********/
+std::vector<glm::ivec2> getNeighbourOffsets(GraphConnectivity connectivity);
+
+
+/*********
+Weight of the edge between two neighbouring pixels, see SurfaceGraph.
+**********/
+float calcEdgeWeight(glm::ivec2 from, glm::ivec2 to, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+
+/*********
+Undirected graph over the pixels of a height map. An edge between two neighbouring pixels weighs the surface distance of the straight line between them,
+from the same surface calcSurfaceDistance walks. Axis edges weigh the 3D length of the pixel edge, also on the last row and column,
+where calcSurfaceDistance gives 0. Both directions of an edge have the same weight. Pixels are numbered y * imageWidth + x.
+The edge weights are computed in parallel over the pool.
+**********/
+class SurfaceGraph {
+public:
+	SurfaceGraph(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+		GraphConnectivity connectivity, ThreadPool& pool);
+
+	int getImageWidth() const;
+
+	int getImageHeight() const;
+
+	float getPixelDistance() const;
+
+	std::size_t getNodeCount() const;
+
+	int getNeighbourCount() const;
+
+	glm::ivec2 getNeighbourOffset(int neighbour) const;
+
+	/*********
+	Weight of the edge from node to its neighbour-th neighbour, or infinity if the neighbour is outside of the image.
+	**********/
+	float getEdgeWeight(std::size_t node, int neighbour) const;
+
+private:
+	int _imageWidth;
+	int _imageHeight;
+	float _pixelDistance;
+	std::vector<glm::ivec2> _offsets;
+	std::vector<float> _weights;
+};
+
+
+/*********
+Point to point shortest paths on a SurfaceGraph with bidirectional A*.
+Both searches use the average of the planar distance potentials towards the two endpoints, which keeps the reduced edge weights
+non-negative in both directions, so the search can stop once the two smallest keys add up to the best path found.
+The object keeps its search state between queries, so one thread can reuse it without clearing memory of the size of the graph.
+It is not safe to use one object from several threads at once.
+**********/
+class BidirectionalSearch {
+public:
+	explicit BidirectionalSearch(const SurfaceGraph& graph);
+
+	/*********
+	Length of the shortest path from begin to end. If path is given, it receives the pixels of the path from begin to end.
+	**********/
+	float findShortestPath(glm::ivec2 begin, glm::ivec2 end, std::vector<glm::ivec2>* path = nullptr);
+
+	/*********
+	Number of nodes the last query settled in both directions.
+	**********/
+	std::size_t getSettledCount() const;
+
+private:
+	struct Direction {
+		std::vector<float> distances;
+		std::vector<std::int32_t> parents;
+		std::vector<std::uint32_t> stamps;
+	};
+
+	const SurfaceGraph& _graph;
+	Direction _directions[2];
+	std::uint32_t _stamp;
+	std::size_t _settledCount;
+};
+
+
+#endif // !GRAPH_H
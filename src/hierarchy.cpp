@@ -0,0 +1,508 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include "hierarchy.h"
+
+
+static const char HIERARCHY_MAGIC[4] = { 'S', 'D', 'C', 'H' };
+static const std::uint32_t HIERARCHY_VERSION = 1;
+
+// witness searches settle fewer nodes to estimate the priority of a node than to contract it
+static const std::size_t PRIORITY_SETTLE_LIMIT = 16;
+static const std::size_t CONTRACTION_SETTLE_LIMIT = 64;
+
+
+typedef std::pair<float, std::int32_t> QueueEntry;
+
+
+struct HierarchyEdge {
+	std::int32_t target;
+	float weight;
+	std::int32_t via;
+};
+
+
+struct Shortcut {
+	std::int32_t from;
+	std::int32_t to;
+	float weight;
+	std::int32_t via;
+};
+
+
+typedef std::vector<std::vector<HierarchyEdge>> Adjacency;
+
+
+/*********
+Distances of a witness search. Every thread keeps one for all the searches it runs, so a search does not clear memory of the size of the graph.
+**********/
+struct WitnessSpace {
+	std::vector<float> distances;
+	std::vector<std::uint32_t> stamps;
+	std::uint32_t stamp;
+	std::vector<QueueEntry> heap;
+};
+
+
+static WitnessSpace& getWitnessSpace(std::size_t nodeCount) {
+	thread_local WitnessSpace space{ std::vector<float>(), std::vector<std::uint32_t>(), 0, std::vector<QueueEntry>() };
+	if (space.stamps.size() < nodeCount) {
+		space.distances.resize(nodeCount);
+		space.stamps.assign(nodeCount, 0);
+		space.stamp = 0;
+	}
+
+	return space;
+}
+
+
+/*********
+State of the two upward searches of a query. Every thread keeps one for all the queries it runs, like WitnessSpace,
+so a query neither hashes the nodes it reaches nor clears memory of the size of the graph.
+**********/
+struct QuerySpace {
+	struct Direction {
+		std::vector<float> distances;
+		std::vector<std::int32_t> parents;
+		std::vector<QueueEntry> heap;
+	};
+
+	Direction directions[2];
+	std::vector<std::uint32_t> stamps[2];
+	std::uint32_t stamp;
+};
+
+
+static QuerySpace& getQuerySpace(std::size_t nodeCount) {
+	thread_local QuerySpace space{ {}, {}, 0 };
+	if (space.stamps[0].size() < nodeCount) {
+		for (int side = 0; side < 2; ++side) {
+			space.directions[side].distances.resize(nodeCount);
+			space.directions[side].parents.resize(nodeCount);
+			space.stamps[side].assign(nodeCount, 0);
+		}
+
+		space.stamp = 0;
+	}
+
+	return space;
+}
+
+
+/*********
+Find the shortcuts contracting node would need between its neighbours. Contracted nodes are skipped.
+A search settles at most settleLimit nodes and adds the shortcut if it found no witness, which is always safe.
+**********/
+static std::vector<Shortcut> findShortcuts(std::int32_t node, const Adjacency& adjacency, const std::vector<char>& contracted, std::size_t settleLimit) {
+	std::vector<HierarchyEdge> neighbours;
+	for (const HierarchyEdge& edge : adjacency[node]) {
+		if (!contracted[edge.target]) {
+			neighbours.push_back(edge);
+		}
+	}
+
+	WitnessSpace& space = getWitnessSpace(adjacency.size());
+	auto distanceOf = [&](std::int32_t other) {
+		return space.stamps[other] == space.stamp ? space.distances[other] : std::numeric_limits<float>::infinity();
+	};
+
+	std::vector<Shortcut> shortcuts;
+	for (std::size_t i = 0; i + 1 < neighbours.size(); ++i) {
+		float maxDistance = 0.0f;
+		for (std::size_t j = i + 1; j < neighbours.size(); ++j) {
+			maxDistance = std::max(maxDistance, neighbours[i].weight + neighbours[j].weight);
+		}
+
+		if (++space.stamp == 0) {
+			std::fill(space.stamps.begin(), space.stamps.end(), 0);
+			space.stamp = 1;
+		}
+
+		// the heap is kept in the space so its memory is reused by the next search
+		std::vector<QueueEntry>& heap = space.heap;
+		heap.clear();
+		space.distances[neighbours[i].target] = 0.0f;
+		space.stamps[neighbours[i].target] = space.stamp;
+		heap.push_back(QueueEntry(0.0f, neighbours[i].target));
+		std::size_t settledCount = 0;
+		while (!heap.empty() && heap.front().first <= maxDistance && settledCount < settleLimit) {
+			std::pop_heap(heap.begin(), heap.end(), std::greater<QueueEntry>());
+			QueueEntry entry = heap.back();
+			heap.pop_back();
+			if (entry.first > distanceOf(entry.second)) {
+				continue;
+			}
+
+			++settledCount;
+			for (const HierarchyEdge& edge : adjacency[entry.second]) {
+				if (edge.target == node || contracted[edge.target]) {
+					continue;
+				}
+
+				float distance = entry.first + edge.weight;
+				if (distance < distanceOf(edge.target)) {
+					space.distances[edge.target] = distance;
+					space.stamps[edge.target] = space.stamp;
+					heap.push_back(QueueEntry(distance, edge.target));
+					std::push_heap(heap.begin(), heap.end(), std::greater<QueueEntry>());
+				}
+			}
+		}
+
+		for (std::size_t j = i + 1; j < neighbours.size(); ++j) {
+			float through = neighbours[i].weight + neighbours[j].weight;
+			if (distanceOf(neighbours[j].target) > through) {
+				shortcuts.push_back(Shortcut{ neighbours[i].target, neighbours[j].target, through, node });
+			}
+		}
+	}
+
+	return shortcuts;
+}
+
+
+static void addOrImproveEdge(Adjacency& adjacency, std::int32_t from, std::int32_t to, float weight, std::int32_t via) {
+	for (HierarchyEdge& edge : adjacency[from]) {
+		if (edge.target == to) {
+			if (weight < edge.weight) {
+				edge.weight = weight;
+				edge.via = via;
+			}
+
+			return;
+		}
+	}
+
+	adjacency[from].push_back(HierarchyEdge{ to, weight, via });
+}
+
+
+template<typename T>
+static void writeArray(std::ofstream& file, const std::vector<T>& values) {
+	file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+
+template<typename T>
+static void readArray(std::ifstream& file, std::vector<T>& values, std::size_t count) {
+	values.resize(count);
+	file.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+}
+
+
+ContractionHierarchy::ContractionHierarchy()
+	: _imageWidth{0}, _imageHeight{0}
+{
+}
+
+
+ContractionHierarchy::ContractionHierarchy(const SurfaceGraph& graph, ThreadPool& pool)
+	: _imageWidth{graph.getImageWidth()}, _imageHeight{graph.getImageHeight()}
+{
+	std::int32_t nodeCount = static_cast<std::int32_t>(graph.getNodeCount());
+	Adjacency adjacency(nodeCount);
+	for (std::int32_t node = 0; node < nodeCount; ++node) {
+		glm::ivec2 pixel{ node % _imageWidth, node / _imageWidth };
+		for (int neighbour = 0; neighbour < graph.getNeighbourCount(); ++neighbour) {
+			float weight = graph.getEdgeWeight(node, neighbour);
+			if (weight != std::numeric_limits<float>::infinity()) {
+				glm::ivec2 next = pixel + graph.getNeighbourOffset(neighbour);
+				adjacency[node].push_back(HierarchyEdge{ next.y * _imageWidth + next.x, weight, -1 });
+			}
+		}
+	}
+
+	std::vector<char> contracted(nodeCount, 0);
+	std::vector<char> dirty(nodeCount, 0);
+	std::vector<int> depths(nodeCount, 0);
+	std::vector<int> priorities(nodeCount, 0);
+	Adjacency upward(nodeCount);
+	std::vector<std::int32_t> remaining(nodeCount);
+	for (std::int32_t node = 0; node < nodeCount; ++node) {
+		remaining[node] = node;
+	}
+
+	// only the nodes next to the ones contracted in the last round need a new priority
+	std::vector<std::int32_t> dirtyNodes = remaining;
+	while (!remaining.empty()) {
+		pool.parallelFor(dirtyNodes.size(), [&](std::size_t i) {
+			std::int32_t node = dirtyNodes[i];
+			int degree = static_cast<int>(adjacency[node].size());
+			priorities[node] = static_cast<int>(findShortcuts(node, adjacency, contracted, PRIORITY_SETTLE_LIMIT).size()) - degree + depths[node];
+			dirty[node] = 0;
+		});
+
+		dirtyNodes.clear();
+
+		// a node is contracted in this round if it comes before all of its neighbours, so no two neighbours are contracted at once
+		std::vector<std::int32_t> selected;
+		for (std::int32_t node : remaining) {
+			bool lowest = true;
+			for (const HierarchyEdge& edge : adjacency[node]) {
+				std::int32_t other = edge.target;
+				if (!contracted[other] && std::make_pair(priorities[other], other) < std::make_pair(priorities[node], node)) {
+					lowest = false;
+					break;
+				}
+			}
+
+			if (lowest) {
+				selected.push_back(node);
+			}
+		}
+
+		// witness searches must not pass through any node of this round, their shortcuts are not known yet
+		for (std::int32_t node : selected) {
+			contracted[node] = 1;
+		}
+
+		std::vector<std::vector<Shortcut>> shortcuts(selected.size());
+		pool.parallelFor(selected.size(), [&](std::size_t i) {
+			shortcuts[i] = findShortcuts(selected[i], adjacency, contracted, CONTRACTION_SETTLE_LIMIT);
+		});
+
+		// the edges of a contracted node to the rest are final and all lead upward, so they move out of the graph that is still searched
+		for (std::size_t i = 0; i < selected.size(); ++i) {
+			std::int32_t node = selected[i];
+			for (const HierarchyEdge& edge : adjacency[node]) {
+				std::vector<HierarchyEdge>& neighbourEdges = adjacency[edge.target];
+				neighbourEdges.erase(std::remove_if(neighbourEdges.begin(), neighbourEdges.end(),
+					[&](const HierarchyEdge& neighbourEdge) { return neighbourEdge.target == node; }), neighbourEdges.end());
+				depths[edge.target] = std::max(depths[edge.target], depths[node] + 1);
+				if (!dirty[edge.target]) {
+					dirty[edge.target] = 1;
+					dirtyNodes.push_back(edge.target);
+				}
+			}
+
+			upward[node] = std::move(adjacency[node]);
+			adjacency[node].clear();
+			for (const Shortcut& shortcut : shortcuts[i]) {
+				addOrImproveEdge(adjacency, shortcut.from, shortcut.to, shortcut.weight, shortcut.via);
+				addOrImproveEdge(adjacency, shortcut.to, shortcut.from, shortcut.weight, shortcut.via);
+			}
+		}
+
+		remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [&](std::int32_t node) { return contracted[node] != 0; }), remaining.end());
+	}
+
+	_edgeOffsets.assign(nodeCount + 1, 0);
+	for (std::int32_t node = 0; node < nodeCount; ++node) {
+		_edgeOffsets[node + 1] = _edgeOffsets[node] + upward[node].size();
+		for (const HierarchyEdge& edge : upward[node]) {
+			_edgeTargets.push_back(edge.target);
+			_edgeWeights.push_back(edge.weight);
+			_edgeVias.push_back(edge.via);
+		}
+	}
+}
+
+
+int ContractionHierarchy::getImageWidth() const {
+	return _imageWidth;
+}
+
+
+int ContractionHierarchy::getImageHeight() const {
+	return _imageHeight;
+}
+
+
+std::size_t ContractionHierarchy::getNodeCount() const {
+	return _edgeOffsets.empty() ? 0 : _edgeOffsets.size() - 1;
+}
+
+
+std::size_t ContractionHierarchy::getEdgeCount() const {
+	return _edgeTargets.size();
+}
+
+
+float ContractionHierarchy::findShortestPath(glm::ivec2 begin, glm::ivec2 end, std::vector<glm::ivec2>* path) const {
+	const float infinity = std::numeric_limits<float>::infinity();
+	std::int32_t endpoints[] = { begin.y * _imageWidth + begin.x, end.y * _imageWidth + end.x };
+
+	// a node whose stamp is not the current one has not been reached by this query
+	QuerySpace& space = getQuerySpace(getNodeCount());
+	if (++space.stamp == 0) {
+		for (std::vector<std::uint32_t>& stamps : space.stamps) {
+			std::fill(stamps.begin(), stamps.end(), 0);
+		}
+
+		space.stamp = 1;
+	}
+
+	auto distanceOf = [&](int side, std::int32_t node) {
+		return space.stamps[side][node] == space.stamp ? space.directions[side].distances[node] : infinity;
+	};
+
+	for (int side = 0; side < 2; ++side) {
+		QuerySpace::Direction& direction = space.directions[side];
+		direction.distances[endpoints[side]] = 0.0f;
+		direction.parents[endpoints[side]] = -1;
+		space.stamps[side][endpoints[side]] = space.stamp;
+		direction.heap.clear();
+		direction.heap.push_back(QueueEntry(0.0f, endpoints[side]));
+	}
+
+	float best = infinity;
+	std::int32_t meeting = -1;
+	while (true) {
+		// a search is done once its smallest key cannot improve the best path
+		bool active[2];
+		for (int side = 0; side < 2; ++side) {
+			const std::vector<QueueEntry>& heap = space.directions[side].heap;
+			active[side] = !heap.empty() && heap.front().first < best;
+		}
+
+		if (!active[0] && !active[1]) {
+			break;
+		}
+
+		int side = !active[1] || (active[0] && space.directions[0].heap.front().first <= space.directions[1].heap.front().first) ? 0 : 1;
+		QuerySpace::Direction& direction = space.directions[side];
+		std::pop_heap(direction.heap.begin(), direction.heap.end(), std::greater<QueueEntry>());
+		QueueEntry entry = direction.heap.back();
+		direction.heap.pop_back();
+		std::int32_t node = entry.second;
+		if (entry.first > direction.distances[node]) {
+			continue;
+		}
+
+		float through = entry.first + distanceOf(1 - side, node);
+		if (through < best) {
+			best = through;
+			meeting = node;
+		}
+
+		for (std::uint64_t edge = _edgeOffsets[node]; edge < _edgeOffsets[node + 1]; ++edge) {
+			std::int32_t next = _edgeTargets[edge];
+			float distance = entry.first + _edgeWeights[edge];
+			if (distance < distanceOf(side, next)) {
+				direction.distances[next] = distance;
+				direction.parents[next] = node;
+				space.stamps[side][next] = space.stamp;
+				direction.heap.push_back(QueueEntry(distance, next));
+				std::push_heap(direction.heap.begin(), direction.heap.end(), std::greater<QueueEntry>());
+			}
+		}
+	}
+
+	if (path) {
+		path->clear();
+		if (meeting != -1) {
+			const std::vector<std::int32_t>& forwardParents = space.directions[0].parents;
+			const std::vector<std::int32_t>& backwardParents = space.directions[1].parents;
+			std::vector<std::int32_t> upward;
+			for (std::int32_t node = meeting; node != -1; node = forwardParents[node]) {
+				upward.push_back(node);
+			}
+
+			std::reverse(upward.begin(), upward.end());
+			for (std::int32_t node = meeting; backwardParents[node] != -1; node = backwardParents[node]) {
+				upward.push_back(backwardParents[node]);
+			}
+
+			std::vector<std::int32_t> nodes = { upward.front() };
+			for (std::size_t i = 0; i + 1 < upward.size(); ++i) {
+				unpackEdge(upward[i], upward[i + 1], nodes);
+			}
+
+			for (std::int32_t node : nodes) {
+				path->push_back(glm::ivec2(node % _imageWidth, node / _imageWidth));
+			}
+		}
+	}
+
+	return best;
+}
+
+
+/*********
+Append the original nodes of the edge from one node to another, without from itself.
+The edge is stored at whichever of the two nodes was contracted first.
+**********/
+void ContractionHierarchy::unpackEdge(std::int32_t from, std::int32_t to, std::vector<std::int32_t>& nodes) const {
+	std::int32_t via = -1;
+	bool found = false;
+	std::int32_t directions[2][2] = { { from, to }, { to, from } };
+	for (auto& ends : directions) {
+		for (std::uint64_t edge = _edgeOffsets[ends[0]]; edge < _edgeOffsets[ends[0] + 1] && !found; ++edge) {
+			if (_edgeTargets[edge] == ends[1]) {
+				via = _edgeVias[edge];
+				found = true;
+			}
+		}
+	}
+
+	if (via == -1) {
+		nodes.push_back(to);
+		return;
+	}
+
+	unpackEdge(from, via, nodes);
+	unpackEdge(via, to, nodes);
+}
+
+
+void writeContractionHierarchy(const std::string& filename, const ContractionHierarchy& hierarchy) {
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("cannot open " + filename + " for writing");
+	}
+
+	std::int32_t size[] = { hierarchy._imageWidth, hierarchy._imageHeight };
+	std::uint64_t counts[] = { hierarchy.getNodeCount(), hierarchy.getEdgeCount() };
+	file.write(HIERARCHY_MAGIC, sizeof(HIERARCHY_MAGIC));
+	file.write(reinterpret_cast<const char*>(&HIERARCHY_VERSION), sizeof(HIERARCHY_VERSION));
+	file.write(reinterpret_cast<const char*>(size), sizeof(size));
+	file.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+	writeArray(file, hierarchy._edgeOffsets);
+	writeArray(file, hierarchy._edgeTargets);
+	writeArray(file, hierarchy._edgeWeights);
+	writeArray(file, hierarchy._edgeVias);
+	if (!file) {
+		throw std::runtime_error("cannot write " + filename);
+	}
+}
+
+
+ContractionHierarchy readContractionHierarchy(const std::string& filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("cannot open " + filename);
+	}
+
+	char magic[sizeof(HIERARCHY_MAGIC)];
+	std::uint32_t version = 0;
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&version), sizeof(version));
+	if (!file || std::memcmp(magic, HIERARCHY_MAGIC, sizeof(magic)) != 0 || version != HIERARCHY_VERSION) {
+		throw std::runtime_error(filename + ": not a contraction hierarchy of version " + std::to_string(HIERARCHY_VERSION));
+	}
+
+	ContractionHierarchy hierarchy;
+	std::int32_t size[2];
+	std::uint64_t counts[2];
+	file.read(reinterpret_cast<char*>(size), sizeof(size));
+	file.read(reinterpret_cast<char*>(counts), sizeof(counts));
+	if (!file || size[0] < 0 || size[1] < 0 || counts[0] != static_cast<std::uint64_t>(size[0]) * static_cast<std::uint64_t>(size[1])) {
+		throw std::runtime_error(filename + ": malformed header");
+	}
+
+	hierarchy._imageWidth = size[0];
+	hierarchy._imageHeight = size[1];
+	readArray(file, hierarchy._edgeOffsets, counts[0] + 1);
+	readArray(file, hierarchy._edgeTargets, counts[1]);
+	readArray(file, hierarchy._edgeWeights, counts[1]);
+	readArray(file, hierarchy._edgeVias, counts[1]);
+	if (!file || hierarchy._edgeOffsets.back() != counts[1]) {
+		throw std::runtime_error(filename + ": file is cut short");
+	}
+
+	return hierarchy;
+}
@@ -0,0 +1,71 @@
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "graph.h"
+#include "thread_pool.h"
+
+
+/*********
+Contraction hierarchy over a SurfaceGraph for repeated shortest path queries on a fixed DEM.
+Nodes are contracted in rounds. Each round computes the priority of the nodes whose neighbourhood changed in parallel,
+contracts in parallel the nodes whose priority is lower than that of all their neighbours, and adds the shortcuts they need.
+A shortcut is needed between two neighbours of a contracted node if a bounded witness search finds no path between them as short as the one through the node.
+The priority is the number of shortcuts minus the number of edges removed, plus the contraction depth of the node, which keeps the hierarchy flat.
+Only the upward edges (to nodes contracted later) are kept, each with the node it bypasses so paths can be unpacked.
+**********/
+class ContractionHierarchy {
+public:
+	ContractionHierarchy(const SurfaceGraph& graph, ThreadPool& pool);
+
+	int getImageWidth() const;
+
+	int getImageHeight() const;
+
+	std::size_t getNodeCount() const;
+
+	std::size_t getEdgeCount() const;
+
+	/*********
+	Length of the shortest path from begin to end. If path is given, it receives the pixels of the path from begin to end
+	with all shortcuts unpacked. The search only follows upward edges from both ends, so it settles few nodes.
+	The query keeps its search state in arrays of the size of the graph per thread, which the next query of the thread reuses
+	without clearing them, so it can be called from several threads at once.
+	**********/
+	float findShortestPath(glm::ivec2 begin, glm::ivec2 end, std::vector<glm::ivec2>* path = nullptr) const;
+
+private:
+	ContractionHierarchy();
+
+	void unpackEdge(std::int32_t from, std::int32_t to, std::vector<std::int32_t>& nodes) const;
+
+	friend void writeContractionHierarchy(const std::string& filename, const ContractionHierarchy& hierarchy);
+
+	friend ContractionHierarchy readContractionHierarchy(const std::string& filename);
+
+	int _imageWidth;
+	int _imageHeight;
+	std::vector<std::uint64_t> _edgeOffsets;
+	std::vector<std::int32_t> _edgeTargets;
+	std::vector<float> _edgeWeights;
+	std::vector<std::int32_t> _edgeVias;
+};
+
+
+/*********
+Save the hierarchy as a binary file in the byte order of the machine. It starts with the magic "SDCH" and a format version.
+**********/
+void writeContractionHierarchy(const std::string& filename, const ContractionHierarchy& hierarchy);
+
+
+/*********
+Load a hierarchy written by writeContractionHierarchy. Throws std::runtime_error if the file is not a hierarchy or is cut short.
+**********/
+ContractionHierarchy readContractionHierarchy(const std::string& filename);
+
+
+#endif // !HIERARCHY_H
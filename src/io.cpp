@@ -0,0 +1,109 @@
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include "io.h"
+
+
+static std::ofstream openOutput(const std::string& filename) {
+	std::ofstream file(filename);
+	if (!file) {
+		throw std::runtime_error("cannot open " + filename + " for writing");
+	}
+
+	file.precision(std::numeric_limits<float>::max_digits10);
+	return file;
+}
+
+
+std::vector<unsigned char> readHeightData(const std::string& filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("cannot open " + filename);
+	}
+
+	file.unsetf(std::ios::skipws);
+
+	std::streampos fileSize;
+	file.seekg(0, std::ios::end);
+	fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	std::vector<unsigned char> height;
+	height.reserve(fileSize);
+	height.insert(height.begin(), std::istream_iterator<unsigned char>(file), std::istream_iterator<unsigned char>());
+
+	return height;
+}
+
+
+std::vector<unsigned char> readHeightData(const std::string& filename, int imageWidth, int imageHeight, glm::ivec2 pixelMin, glm::ivec2 pixelMax) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("cannot open " + filename);
+	}
+
+	std::vector<unsigned char> height(static_cast<std::size_t>(imageWidth) * imageHeight, 0);
+	pixelMin = glm::max(pixelMin, glm::ivec2(0, 0));
+	pixelMax = glm::min(pixelMax, glm::ivec2(imageWidth - 1, imageHeight - 1));
+	if (pixelMin.x > pixelMax.x) {
+		return height;
+	}
+
+	for (int y = pixelMin.y; y <= pixelMax.y; ++y) {
+		std::size_t offset = static_cast<std::size_t>(y) * imageWidth + pixelMin.x;
+		file.seekg(static_cast<std::streamoff>(offset));
+		if (!file.read(reinterpret_cast<char*>(&height[offset]), pixelMax.x - pixelMin.x + 1)) {
+			throw std::runtime_error(filename + " is smaller than " + std::to_string(imageWidth) + "x" + std::to_string(imageHeight) + " pixels");
+		}
+	}
+
+	return height;
+}
+
+
+std::vector<SurfaceQuery> readQueries(const std::string& filename) {
+	std::ifstream file(filename);
+	if (!file) {
+		throw std::runtime_error("cannot open " + filename);
+	}
+
+	std::vector<SurfaceQuery> queries;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		++lineNumber;
+		std::size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#') {
+			continue;
+		}
+
+		std::istringstream stream(line);
+		SurfaceQuery query;
+		std::string rest;
+		if (!(stream >> query.begin.x >> query.begin.y >> query.end.x >> query.end.y) || (stream >> rest)) {
+			throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": expected four pixel coordinates");
+		}
+
+		queries.push_back(query);
+	}
+
+	return queries;
+}
+
+
+void writeQueries(const std::string& filename, const std::vector<SurfaceQuery>& queries) {
+	std::ofstream file = openOutput(filename);
+	for (const SurfaceQuery& query : queries) {
+		file << query.begin.x << " " << query.begin.y << " " << query.end.x << " " << query.end.y << "\n";
+	}
+}
+
+
+void writeDistances(const std::string& filename, const std::vector<float>& distances) {
+	std::ofstream file = openOutput(filename);
+	for (float distance : distances) {
+		file << distance << "\n";
+	}
+}
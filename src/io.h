@@ -0,0 +1,41 @@
+#ifndef IO_H
+#define IO_H
+
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "batch.h"
+
+
+/*********
+Read a raw height map where every pixel is one unsigned byte, stored row by row.
+**********/
+std::vector<unsigned char> readHeightData(const std::string& filename);
+
+
+/*********
+Read only the pixels from pixelMin to pixelMax (inclusive) of a raw height map of imageWidth x imageHeight pixels.
+The result has the size of the whole image so pixel coordinates stay the same, and the pixels outside of the window are 0.
+Throws std::runtime_error if the file is smaller than the window needs.
+**********/
+std::vector<unsigned char> readHeightData(const std::string& filename, int imageWidth, int imageHeight, glm::ivec2 pixelMin, glm::ivec2 pixelMax);
+
+
+/*********
+Read and write a query file.
+A query file has one line per query: [begin_pixel_X] [begin_pixel_Y] [end_pixel_X] [end_pixel_Y]
+Empty lines and lines starting with '#' are skipped. A malformed line throws std::runtime_error.
+**********/
+std::vector<SurfaceQuery> readQueries(const std::string& filename);
+
+
+void writeQueries(const std::string& filename, const std::vector<SurfaceQuery>& queries);
+
+
+/*********
+Write one distance per line, printed with enough digits to read back the exact float.
+**********/
+void writeDistances(const std::string& filename, const std::vector<float>& distances);
+
+
+#endif // !IO_H
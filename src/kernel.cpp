@@ -0,0 +1,114 @@
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include "kernel.h"
+#include "distance.h"
+
+
+#ifdef SURFACE_DISTANCE_X86_KERNELS
+
+// defined in kernel_sse42.cpp, kernel_avx2.cpp and kernel_avx512.cpp
+float calcSurfaceDistanceSse42(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+float calcSurfaceDistanceAvx2(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+float calcSurfaceDistanceAvx512(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+#endif
+
+
+static const KernelIsa KERNEL_ISAS[] = { KernelIsa::Baseline, KernelIsa::Sse42, KernelIsa::Avx2, KernelIsa::Avx512 };
+
+
+bool isKernelIsaSupported(KernelIsa isa) {
+#ifdef SURFACE_DISTANCE_X86_KERNELS
+	// also checks that the operating system saves the AVX registers
+	__builtin_cpu_init();
+	switch (isa) {
+	case KernelIsa::Baseline:
+		return true;
+	case KernelIsa::Sse42:
+		return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+	case KernelIsa::Avx2:
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+	case KernelIsa::Avx512:
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")
+			&& __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("bmi2");
+	}
+
+	return false;
+#else
+	return isa == KernelIsa::Baseline;
+#endif
+}
+
+
+KernelIsa detectKernelIsa() {
+	KernelIsa best = KernelIsa::Baseline;
+	for (KernelIsa isa : KERNEL_ISAS) {
+		if (isKernelIsaSupported(isa)) {
+			best = isa;
+		}
+	}
+
+	return best;
+}
+
+
+KernelIsa selectKernelIsa() {
+	const char* name = std::getenv("SURFACE_DISTANCE_ISA");
+	if (!name || !*name) {
+		return detectKernelIsa();
+	}
+
+	for (KernelIsa isa : KERNEL_ISAS) {
+		if (std::string(name) == getKernelIsaName(isa)) {
+			if (!isKernelIsaSupported(isa)) {
+				throw std::runtime_error(std::string("SURFACE_DISTANCE_ISA asks for ") + name + ", which this build or CPU does not support");
+			}
+
+			return isa;
+		}
+	}
+
+	throw std::invalid_argument(std::string("SURFACE_DISTANCE_ISA must be baseline, sse4.2, avx2 or avx512, not ") + name);
+}
+
+
+const char* getKernelIsaName(KernelIsa isa) {
+	switch (isa) {
+	case KernelIsa::Baseline:
+		return "baseline";
+	case KernelIsa::Sse42:
+		return "sse4.2";
+	case KernelIsa::Avx2:
+		return "avx2";
+	case KernelIsa::Avx512:
+		return "avx512";
+	}
+
+	return "unknown";
+}
+
+
+SurfaceDistanceKernel getSurfaceDistanceKernel(KernelIsa isa) {
+	if (!isKernelIsaSupported(isa)) {
+		throw std::runtime_error(std::string("the ") + getKernelIsaName(isa) + " kernels are not supported here");
+	}
+
+	switch (isa) {
+#ifdef SURFACE_DISTANCE_X86_KERNELS
+	case KernelIsa::Sse42:
+		return calcSurfaceDistanceSse42;
+	case KernelIsa::Avx2:
+		return calcSurfaceDistanceAvx2;
+	case KernelIsa::Avx512:
+		return calcSurfaceDistanceAvx512;
+#endif
+	default:
+		return calcSurfaceDistance;
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <vector>
+#include "glm/glm.hpp"
+
+
+/*********
+Instruction sets the kernels of calcSurfaceDistance are built for. Baseline is what the whole library is compiled for,
+the others exist on x86 builds with GCC or Clang and are only run on CPUs that have them.
+**********/
+enum class KernelIsa {
+	Baseline,
+	Sse42,
+	Avx2,
+	Avx512
+};
+
+
+/*********
+Same arguments and result as calcSurfaceDistance.
+**********/
+typedef float (*SurfaceDistanceKernel)(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+
+/*********
+Whether this build has the variant and this CPU, together with the operating system, can run it.
+**********/
+bool isKernelIsaSupported(KernelIsa isa);
+
+
+/*********
+The widest variant isKernelIsaSupported holds for.
+**********/
+KernelIsa detectKernelIsa();
+
+
+/*********
+The variant to run: detectKernelIsa, unless the environment variable SURFACE_DISTANCE_ISA names one of
+baseline, sse4.2, avx2 or avx512, e.g. to compare them on one machine.
+Throws std::invalid_argument for other names and std::runtime_error for a variant that is not supported here.
+**********/
+KernelIsa selectKernelIsa();
+
+
+const char* getKernelIsaName(KernelIsa isa);
+
+
+/*********
+The kernels are built from the same source with floating point contraction turned off,
+so every variant returns bit-identical results to calcSurfaceDistance and only differs in speed.
+Throws std::runtime_error for a variant that is not supported here.
+**********/
+SurfaceDistanceKernel getSurfaceDistanceKernel(KernelIsa isa);
+
+
+#endif // !KERNEL_H
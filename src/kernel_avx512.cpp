@@ -0,0 +1,33 @@
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "distance.h"
+
+
+// built the same way as kernel_sse42.cpp
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,bmi,bmi2,popcnt"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512vl,avx512bw,avx512dq,bmi,bmi2,popcnt")
+#endif
+
+
+namespace kernel_avx512 {
+#include "distance_kernel.inl"
+}
+
+
+float calcSurfaceDistanceAvx512(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight)
+{
+	return kernel_avx512::calcSurfaceDistanceKernel(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+}
+
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,34 @@
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "distance.h"
+
+
+// everything the headers above define stays baseline, so the linker cannot pick a copy built for SSE4.2
+// over the one the rest of the library calls; only the functions below are built for it
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.2,popcnt"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse4.2,popcnt")
+#endif
+
+
+namespace kernel_sse42 {
+#include "distance_kernel.inl"
+}
+
+
+float calcSurfaceDistanceSse42(glm::ivec2 begin, glm::ivec2 end,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight)
+{
+	return kernel_sse42::calcSurfaceDistanceKernel(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+}
+
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
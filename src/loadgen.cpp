@@ -0,0 +1,299 @@
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "loadgen.h"
+
+
+using Clock = std::chrono::steady_clock;
+
+
+static const float PI = 3.14159265358979f;
+
+
+static double elapsedMicroseconds(Clock::time_point from, Clock::time_point to) {
+	return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+
+static double percentile(const std::vector<double>& sorted, double fraction) {
+	if (sorted.empty()) {
+		return 0.0;
+	}
+
+	// nearest rank
+	std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+	rank = std::min(std::max<std::size_t>(rank, 1), sorted.size());
+	return sorted[rank - 1];
+}
+
+
+static std::size_t requestCount(std::size_t queryCount, std::size_t requestSize) {
+	return (queryCount + requestSize - 1) / requestSize;
+}
+
+
+static void runRequest(const std::vector<SurfaceQuery>& queries, std::size_t requestSize, std::size_t request, const RequestExecutor& executor) {
+	std::size_t first = request * requestSize;
+	executor(queries.data() + first, std::min(requestSize, queries.size() - first));
+}
+
+
+static glm::ivec2 clampToImage(glm::vec2 pixel, int imageWidth, int imageHeight) {
+	return glm::ivec2(
+		glm::clamp(static_cast<int>(std::lround(pixel.x)), 0, imageWidth - 1),
+		glm::clamp(static_cast<int>(std::lround(pixel.y)), 0, imageHeight - 1));
+}
+
+
+/*********
+Largest t such that begin + t * direction stays in the image.
+**********/
+static float maxStepInImage(glm::ivec2 begin, glm::vec2 direction, int imageWidth, int imageHeight) {
+	float t = std::numeric_limits<float>::max();
+	if (direction.x > 0.0f) {
+		t = std::min(t, (imageWidth - 1 - begin.x) / direction.x);
+	}
+	else if (direction.x < 0.0f) {
+		t = std::min(t, -begin.x / direction.x);
+	}
+
+	if (direction.y > 0.0f) {
+		t = std::min(t, (imageHeight - 1 - begin.y) / direction.y);
+	}
+	else if (direction.y < 0.0f) {
+		t = std::min(t, -begin.y / direction.y);
+	}
+
+	return t;
+}
+
+
+std::vector<SurfaceQuery> synthesizeWorkload(const WorkloadOptions& options) {
+	if (options.imageWidth < 2 || options.imageHeight < 2 || options.minLength < 0.0f || options.maxLength < options.minLength) {
+		throw std::invalid_argument("invalid workload options");
+	}
+
+	std::mt19937 random(options.seed);
+	std::uniform_int_distribution<int> pixelX(0, options.imageWidth - 1);
+	std::uniform_int_distribution<int> pixelY(0, options.imageHeight - 1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::normal_distribution<float> spread(0.0f, std::max(options.hotspotRadius, 0.0f));
+
+	std::vector<glm::vec2> hotspots;
+	for (int i = 0; i < options.hotspotCount; ++i) {
+		hotspots.push_back(glm::vec2(pixelX(random), pixelY(random)));
+	}
+
+	std::vector<SurfaceQuery> queries;
+	queries.reserve(options.queryCount);
+	for (std::size_t i = 0; i < options.queryCount; ++i) {
+		glm::ivec2 begin;
+		if (!hotspots.empty() && unit(random) < options.hotspotFraction) {
+			glm::vec2 center = hotspots[random() % hotspots.size()];
+			begin = clampToImage(center + glm::vec2(spread(random), spread(random)), options.imageWidth, options.imageHeight);
+		}
+		else {
+			begin = glm::ivec2(pixelX(random), pixelY(random));
+		}
+
+		// a begin on the border with an outward direction gives no line, so those draw the length and direction again
+		glm::ivec2 end;
+		do {
+			float length = options.minLength + unit(random) * (options.maxLength - options.minLength);
+			if (options.lengthDistribution == LengthDistribution::LogUniform) {
+				float logMin = std::log(std::max(options.minLength, 1.0f));
+				float logMax = std::log(std::max(options.maxLength, 1.0f));
+				length = std::exp(logMin + unit(random) * (logMax - logMin));
+			}
+
+			length = std::max(length, 1.0f);
+			if (options.orientationDistribution == OrientationDistribution::Uniform) {
+				float angle = unit(random) * 2.0f * PI;
+				glm::vec2 direction{ std::cos(angle), std::sin(angle) };
+				float step = std::min(length, maxStepInImage(begin, direction, options.imageWidth, options.imageHeight));
+				end = clampToImage(glm::vec2(begin) + step * direction, options.imageWidth, options.imageHeight);
+			}
+			else {
+				// integer steps keep the lines exactly on the axes or diagonals
+				static const glm::ivec2 directions[] = {
+					glm::ivec2(1, 0), glm::ivec2(0, 1), glm::ivec2(-1, 0), glm::ivec2(0, -1),
+					glm::ivec2(1, 1), glm::ivec2(-1, 1), glm::ivec2(-1, -1), glm::ivec2(1, -1)
+				};
+
+				int directionCount = options.orientationDistribution == OrientationDistribution::AxisAligned ? 4 : 8;
+				glm::ivec2 direction = directions[random() % directionCount];
+				float stepLength = glm::length(glm::vec2(direction));
+				int steps = static_cast<int>(std::lround(length / stepLength));
+				steps = std::min(steps, static_cast<int>(maxStepInImage(begin, glm::vec2(direction), options.imageWidth, options.imageHeight)));
+				end = begin + steps * direction;
+			}
+		} while (end == begin);
+
+		queries.push_back(SurfaceQuery{ begin, end });
+	}
+
+	return queries;
+}
+
+
+QueryLog readQueryLog(const std::string& filename) {
+	std::ifstream file(filename);
+	if (!file) {
+		throw std::runtime_error("cannot open " + filename);
+	}
+
+	QueryLog log;
+	std::string line;
+	int lineNumber = 0;
+	int columns = 0;
+	while (std::getline(file, line)) {
+		++lineNumber;
+		std::size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#') {
+			continue;
+		}
+
+		std::istringstream stream(line);
+		std::vector<double> values;
+		double value;
+		while (stream >> value) {
+			values.push_back(value);
+		}
+
+		if (!stream.eof() || (values.size() != 4 && values.size() != 5) || (columns != 0 && static_cast<int>(values.size()) != columns)) {
+			throw std::runtime_error(filename + ":" + std::to_string(lineNumber) + ": malformed query log line");
+		}
+
+		columns = static_cast<int>(values.size());
+		std::size_t offset = values.size() - 4;
+		if (offset == 1) {
+			log.arrivals.push_back(values[0]);
+		}
+
+		log.queries.push_back(SurfaceQuery{
+			glm::ivec2(static_cast<int>(values[offset]), static_cast<int>(values[offset + 1])),
+			glm::ivec2(static_cast<int>(values[offset + 2]), static_cast<int>(values[offset + 3])) });
+	}
+
+	// replay relative to the first recorded query
+	if (!log.arrivals.empty()) {
+		double start = *std::min_element(log.arrivals.begin(), log.arrivals.end());
+		for (double& arrival : log.arrivals) {
+			arrival -= start;
+		}
+	}
+
+	return log;
+}
+
+
+LoadResult runOpenLoop(const std::vector<SurfaceQuery>& queries, std::size_t requestSize, const std::vector<double>& arrivals,
+	unsigned workerCount, const RequestExecutor& executor)
+{
+	requestSize = std::max<std::size_t>(requestSize, 1);
+	std::size_t requests = requestCount(queries.size(), requestSize);
+	if (arrivals.size() < requests) {
+		throw std::invalid_argument("every request needs an arrival time");
+	}
+
+	LoadResult result;
+	result.latencies.resize(requests);
+	result.queryCount = queries.size();
+
+	std::atomic<std::size_t> next{ 0 };
+	Clock::time_point start = Clock::now();
+	auto serve = [&]() {
+		for (std::size_t request = next++; request < requests; request = next++) {
+			Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(arrivals[request]));
+			std::this_thread::sleep_until(due);
+			runRequest(queries, requestSize, request, executor);
+			result.latencies[request] = elapsedMicroseconds(due, Clock::now());
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned i = 1; i < std::max(workerCount, 1u); ++i) {
+		workers.emplace_back(serve);
+	}
+
+	serve();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	result.elapsedSeconds = elapsedMicroseconds(start, Clock::now()) * 1e-6;
+	return result;
+}
+
+
+LoadResult runClosedLoop(const std::vector<SurfaceQuery>& queries, std::size_t requestSize,
+	unsigned concurrency, const RequestExecutor& executor)
+{
+	requestSize = std::max<std::size_t>(requestSize, 1);
+	std::size_t requests = requestCount(queries.size(), requestSize);
+
+	LoadResult result;
+	result.latencies.resize(requests);
+	result.queryCount = queries.size();
+
+	std::atomic<std::size_t> next{ 0 };
+	Clock::time_point start = Clock::now();
+	auto client = [&]() {
+		for (std::size_t request = next++; request < requests; request = next++) {
+			Clock::time_point sent = Clock::now();
+			runRequest(queries, requestSize, request, executor);
+			result.latencies[request] = elapsedMicroseconds(sent, Clock::now());
+		}
+	};
+
+	std::vector<std::thread> clients;
+	for (unsigned i = 1; i < std::max(concurrency, 1u); ++i) {
+		clients.emplace_back(client);
+	}
+
+	client();
+	for (std::thread& worker : clients) {
+		worker.join();
+	}
+
+	result.elapsedSeconds = elapsedMicroseconds(start, Clock::now()) * 1e-6;
+	return result;
+}
+
+
+std::vector<double> fixedRateArrivals(std::size_t requestCount, double rate) {
+	if (rate <= 0.0) {
+		throw std::invalid_argument("the request rate must be positive");
+	}
+
+	std::vector<double> arrivals(requestCount);
+	for (std::size_t i = 0; i < requestCount; ++i) {
+		arrivals[i] = i / rate;
+	}
+
+	return arrivals;
+}
+
+
+LatencySummary summarizeLatencies(const LoadResult& result) {
+	std::vector<double> sorted = result.latencies;
+	std::sort(sorted.begin(), sorted.end());
+
+	LatencySummary summary;
+	summary.requests = sorted.size();
+	summary.mean = sorted.empty() ? 0.0 : std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+	summary.p50 = percentile(sorted, 0.5);
+	summary.p99 = percentile(sorted, 0.99);
+	summary.p999 = percentile(sorted, 0.999);
+	summary.max = sorted.empty() ? 0.0 : sorted.back();
+	summary.throughput = result.elapsedSeconds > 0.0 ? result.queryCount / result.elapsedSeconds : 0.0;
+	return summary;
+}
@@ -0,0 +1,123 @@
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+#include "batch.h"
+
+
+enum class LengthDistribution {
+	Uniform,
+	LogUniform
+};
+
+
+enum class OrientationDistribution {
+	Uniform,
+	AxisAligned,
+	Octilinear
+};
+
+
+/*********
+Parameters of a synthetic workload.
+Line lengths are in pixels. With hotspotCount > 0, a hotspotFraction share of the lines begins
+in one of the hotspots (normally distributed around a random center with standard deviation hotspotRadius),
+the rest begins anywhere in the image. Lines leaving the image are clamped to its border.
+Every line is at least one pixel long: where the direction leaves no line from a begin on the border, length and direction are drawn again.
+**********/
+struct WorkloadOptions {
+	int imageWidth;
+	int imageHeight;
+	std::size_t queryCount;
+	float minLength;
+	float maxLength;
+	LengthDistribution lengthDistribution;
+	OrientationDistribution orientationDistribution;
+	int hotspotCount;
+	float hotspotRadius;
+	float hotspotFraction;
+	std::uint32_t seed;
+};
+
+
+/*********
+A recorded query log: the queries in arrival order and their arrival times in seconds.
+arrivals is empty when the log holds no timestamps.
+**********/
+struct QueryLog {
+	std::vector<SurfaceQuery> queries;
+	std::vector<double> arrivals;
+};
+
+
+/*********
+Latencies in microseconds of every request of a load run, and the wall time of the run in seconds.
+**********/
+struct LoadResult {
+	std::vector<double> latencies;
+	double elapsedSeconds;
+	std::size_t queryCount;
+};
+
+
+/*********
+Latency percentiles in microseconds (nearest rank) and throughput in queries per second.
+**********/
+struct LatencySummary {
+	std::size_t requests;
+	double mean;
+	double p50;
+	double p99;
+	double p999;
+	double max;
+	double throughput;
+};
+
+
+/*********
+Run one request: the requestSize queries starting at the given pointer.
+**********/
+using RequestExecutor = std::function<void(const SurfaceQuery*, std::size_t)>;
+
+
+std::vector<SurfaceQuery> synthesizeWorkload(const WorkloadOptions& options);
+
+
+/*********
+Read a query log. Every line is either [begin_pixel_X] [begin_pixel_Y] [end_pixel_X] [end_pixel_Y]
+or [arrival_seconds] [begin_pixel_X] [begin_pixel_Y] [end_pixel_X] [end_pixel_Y]; all lines must use the same form.
+**********/
+QueryLog readQueryLog(const std::string& filename);
+
+
+/*********
+Open loop: request i is due at arrivals[i] seconds after the start, no matter how fast earlier requests finish.
+workerCount threads serve the requests; latency is measured from the due time, so queueing delay is included
+and a slow system cannot hide its tail by delaying the next arrival.
+**********/
+LoadResult runOpenLoop(const std::vector<SurfaceQuery>& queries, std::size_t requestSize, const std::vector<double>& arrivals,
+	unsigned workerCount, const RequestExecutor& executor);
+
+
+/*********
+Closed loop: concurrency clients each send the next request as soon as their previous one is answered,
+until all queries are used. Latency is measured from send to answer.
+**********/
+LoadResult runClosedLoop(const std::vector<SurfaceQuery>& queries, std::size_t requestSize,
+	unsigned concurrency, const RequestExecutor& executor);
+
+
+/*********
+Arrival times of requestCount requests sent at a fixed rate (requests per second).
+**********/
+std::vector<double> fixedRateArrivals(std::size_t requestCount, double rate);
+
+
+LatencySummary summarizeLatencies(const LoadResult& result);
+
+
+#endif // !LOADGEN_H
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "dataset.h"
+#include "distance.h"
+#include "io.h"
+#include "loadgen.h"
+
+
+struct Options {
+	std::string heightFile = "pre.data";
+	int imageWidth = 512;
+	int imageHeight = 512;
+	float pixelDistance = 30.0f;
+	float pixelHeight = 11.0f;
+	std::string replayFile;
+	WorkloadOptions workload{ 512, 512, 10000, 1.0f, 512.0f, LengthDistribution::Uniform, OrientationDistribution::Uniform, 0, 16.0f, 0.0f, 1 };
+	double rate = 0.0;
+	double speed = 1.0;
+	unsigned concurrency = 1;
+	unsigned workers = 0;
+	std::size_t batchSize = 0;
+	unsigned batchThreads = 0;
+};
+
+
+std::string formatNumber(double value) {
+	std::ostringstream stream;
+	stream << value;
+	return stream.str();
+}
+
+
+void displayUsage() {
+	std::cout << "Usage: [options]\n";
+	std::cout << "data:\n";
+	std::cout << "  --dem [height_file] [image_width] [image_height] [pixel_distance] [pixel_height]   default: pre.data 512 512 30 11\n";
+	std::cout << "workload (synthesized unless --replay is given):\n";
+	std::cout << "  --replay [query_log]          lines of [begin_X] [begin_Y] [end_X] [end_Y], optionally preceded by [arrival_seconds]\n";
+	std::cout << "  --queries [count]             number of synthesized queries, default 10000\n";
+	std::cout << "  --length [min] [max]          line length in pixels, default 1 512\n";
+	std::cout << "  --log-length                  draw lengths log-uniformly\n";
+	std::cout << "  --orientation [uniform|axis|octilinear]\n";
+	std::cout << "  --hotspots [count] [radius] [fraction]\n";
+	std::cout << "  --seed [seed]\n";
+	std::cout << "load (closed loop with concurrency 1 unless --rate is given or the log has arrival times):\n";
+	std::cout << "  --rate [requests_per_second]  open loop at a fixed rate\n";
+	std::cout << "  --speed [factor]              replay recorded arrival times this many times faster\n";
+	std::cout << "  --workers [count]             server threads of the open loop, default: hardware threads\n";
+	std::cout << "  --concurrency [clients]       closed loop with this many clients\n";
+	std::cout << "  --batch [size] [threads]      send requests of [size] queries through the batch path\n";
+	std::cout << "environment:\n";
+	std::cout << "  SURFACE_DISTANCE_ISA=[baseline|sse4.2|avx2|avx512]   run this kernel variant instead of the widest the CPU supports\n";
+}
+
+
+Options parseOptions(int argv, char** args) {
+	Options options;
+	for (int i = 1; i < argv; ++i) {
+		std::string option = args[i];
+		auto argument = [&]() -> std::string {
+			if (i + 1 >= argv) {
+				throw std::invalid_argument(option + " expects more arguments");
+			}
+
+			return args[++i];
+		};
+
+		if (option == "--dem") {
+			options.heightFile = argument();
+			options.imageWidth = std::stoi(argument());
+			options.imageHeight = std::stoi(argument());
+			options.pixelDistance = std::stof(argument());
+			options.pixelHeight = std::stof(argument());
+		}
+		else if (option == "--replay") {
+			options.replayFile = argument();
+		}
+		else if (option == "--queries") {
+			options.workload.queryCount = std::stoul(argument());
+		}
+		else if (option == "--length") {
+			options.workload.minLength = std::stof(argument());
+			options.workload.maxLength = std::stof(argument());
+		}
+		else if (option == "--log-length") {
+			options.workload.lengthDistribution = LengthDistribution::LogUniform;
+		}
+		else if (option == "--orientation") {
+			std::string orientation = argument();
+			if (orientation == "uniform") {
+				options.workload.orientationDistribution = OrientationDistribution::Uniform;
+			}
+			else if (orientation == "axis") {
+				options.workload.orientationDistribution = OrientationDistribution::AxisAligned;
+			}
+			else if (orientation == "octilinear") {
+				options.workload.orientationDistribution = OrientationDistribution::Octilinear;
+			}
+			else {
+				throw std::invalid_argument("unknown orientation " + orientation);
+			}
+		}
+		else if (option == "--hotspots") {
+			options.workload.hotspotCount = std::stoi(argument());
+			options.workload.hotspotRadius = std::stof(argument());
+			options.workload.hotspotFraction = std::stof(argument());
+		}
+		else if (option == "--seed") {
+			options.workload.seed = static_cast<std::uint32_t>(std::stoul(argument()));
+		}
+		else if (option == "--rate") {
+			options.rate = std::stod(argument());
+		}
+		else if (option == "--speed") {
+			options.speed = std::stod(argument());
+		}
+		else if (option == "--workers") {
+			options.workers = static_cast<unsigned>(std::stoul(argument()));
+		}
+		else if (option == "--concurrency") {
+			options.concurrency = static_cast<unsigned>(std::stoul(argument()));
+		}
+		else if (option == "--batch") {
+			options.batchSize = std::stoul(argument());
+			options.batchThreads = static_cast<unsigned>(std::stoul(argument()));
+		}
+		else {
+			throw std::invalid_argument("unknown option " + option);
+		}
+	}
+
+	options.workload.imageWidth = options.imageWidth;
+	options.workload.imageHeight = options.imageHeight;
+	return options;
+}
+
+
+int main(int argv, char** args) {
+	Options options;
+	try {
+		options = parseOptions(argv, args);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "error: " << e.what() << "\n";
+		displayUsage();
+		return 1;
+	}
+
+	try {
+		std::vector<unsigned char> heights = readHeightData(options.heightFile);
+		if (heights.size() < static_cast<std::size_t>(options.imageWidth) * options.imageHeight) {
+			throw std::runtime_error(options.heightFile + " is smaller than the image size");
+		}
+
+		QueryLog log;
+		if (options.replayFile.empty()) {
+			log.queries = synthesizeWorkload(options.workload);
+		}
+		else {
+			log = readQueryLog(options.replayFile);
+		}
+
+		// picks the kernel variant, see SURFACE_DISTANCE_ISA
+		HeightDataset dataset(std::move(heights), options.imageWidth, options.imageHeight, options.pixelDistance, options.pixelHeight);
+		std::size_t requestSize = std::max<std::size_t>(options.batchSize, 1);
+		std::unique_ptr<ThreadPool> pool;
+		RequestExecutor executor;
+		if (options.batchSize > 0) {
+			pool.reset(new ThreadPool(options.batchThreads));
+			executor = [&](const SurfaceQuery* queries, std::size_t count) {
+				std::vector<float> distances(count);
+				calcSurfaceDistances(queries, count, dataset, distances.data(), *pool);
+			};
+		}
+		else {
+			executor = [&](const SurfaceQuery* queries, std::size_t count) {
+				for (std::size_t i = 0; i < count; ++i) {
+					volatile float distance = dataset.calcSurfaceDistance(queries[i].begin, queries[i].end);
+					(void)distance;
+				}
+			};
+		}
+
+		std::size_t requests = (log.queries.size() + requestSize - 1) / requestSize;
+		unsigned workers = options.workers > 0 ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+		LoadResult result;
+		std::string mode;
+		if (options.rate > 0.0) {
+			mode = "open loop, " + formatNumber(options.rate) + " requests/s";
+			result = runOpenLoop(log.queries, requestSize, fixedRateArrivals(requests, options.rate), workers, executor);
+		}
+		else if (!log.arrivals.empty()) {
+			mode = "open loop, recorded arrivals x" + formatNumber(options.speed);
+			std::vector<double> arrivals;
+			for (std::size_t request = 0; request < requests; ++request) {
+				arrivals.push_back(log.arrivals[request * requestSize] / options.speed);
+			}
+
+			result = runOpenLoop(log.queries, requestSize, arrivals, workers, executor);
+		}
+		else {
+			mode = "closed loop, " + std::to_string(options.concurrency) + " clients";
+			result = runClosedLoop(log.queries, requestSize, options.concurrency, executor);
+		}
+
+		LatencySummary summary = summarizeLatencies(result);
+		std::cout << "mode: " << mode << "\n";
+		std::cout << "path: " << (options.batchSize > 0 ? "batch of " + std::to_string(options.batchSize) : std::string("calcSurfaceDistance")) << "\n";
+		std::cout << "kernel: " << getKernelIsaName(dataset.getKernelIsa()) << "\n";
+		std::cout << "requests: " << summary.requests << " (" << result.queryCount << " queries in " << result.elapsedSeconds << " s)\n";
+		std::cout << "latency us: mean " << summary.mean << ", p50 " << summary.p50 << ", p99 " << summary.p99
+			<< ", p99.9 " << summary.p999 << ", max " << summary.max << "\n";
+		std::cout << "throughput: " << summary.throughput << " queries/s\n";
+	}
+	catch (const std::exception& e) {
+		std::cerr << "error: " << e.what() << "\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -1,8 +1,7 @@
 #include <iostream>
-#include <fstream>
-#include <iterator>
 #include <string>
 #include "distance.h"
+#include "io.h"
 
 
 const float PIXEL_DISTANCE = 30.0f;
@@ -11,23 +10,6 @@ const int IMG_WIDTH = 512;
 const int IMG_HEIGHT = 512;
 
 
-std::vector<unsigned char> readHeightData(const std::string &filename) {
-	std::ifstream file(filename, std::ios::binary);
-	file.unsetf(std::ios::skipws);
-
-    std::streampos fileSize;
-    file.seekg(0, std::ios::end);
-    fileSize = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-	std::vector<unsigned char> height;
-	height.reserve(fileSize);
-	height.insert(height.begin(), std::istream_iterator<unsigned char>(file), std::istream_iterator<unsigned char>());
-
-	return height;
-}
-
-
 void displayUsage() {
 	std::cout << "Usage: [begin_pixel_X] [begin_pixel_Y] [end_pixel_X] [end_pixel_Y]" << "\n";
 	std::cout << "begin_pixel_X: x component of the begin pixel. x >= 0 && x < 511\n";
@@ -0,0 +1,117 @@
+#include <stdexcept>
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filename, std::size_t size)
+	: _filename{filename}, _data{nullptr}, _size{size}, _file{INVALID_HANDLE_VALUE}, _mapping{nullptr}
+{
+	_file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (_file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("cannot open " + filename + " for writing");
+	}
+
+	if (size == 0) {
+		return;
+	}
+
+	// the mapping grows the file to its size
+	unsigned long long size64 = size;
+	_mapping = CreateFileMappingA(_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), nullptr);
+	if (_mapping) {
+		_data = MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	}
+
+	if (!_data) {
+		if (_mapping) {
+			CloseHandle(_mapping);
+		}
+
+		CloseHandle(_file);
+		throw std::runtime_error("cannot map " + filename);
+	}
+}
+
+
+MappedFile::~MappedFile() {
+	if (_data) {
+		UnmapViewOfFile(_data);
+		CloseHandle(_mapping);
+	}
+
+	CloseHandle(_file);
+}
+
+
+void MappedFile::flush() {
+	if (_data && (!FlushViewOfFile(_data, _size) || !FlushFileBuffers(_file))) {
+		throw std::runtime_error("cannot write " + _filename);
+	}
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filename, std::size_t size)
+	: _filename{filename}, _data{nullptr}, _size{size}, _file{-1}
+{
+	_file = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (_file < 0) {
+		throw std::runtime_error("cannot open " + filename + " for writing");
+	}
+
+	if (size == 0) {
+		return;
+	}
+
+	if (ftruncate(_file, static_cast<off_t>(size)) != 0) {
+		close(_file);
+		throw std::runtime_error("cannot grow " + filename + " to " + std::to_string(size) + " bytes");
+	}
+
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0);
+	if (data == MAP_FAILED) {
+		close(_file);
+		throw std::runtime_error("cannot map " + filename);
+	}
+
+	_data = data;
+}
+
+
+MappedFile::~MappedFile() {
+	if (_data) {
+		munmap(_data, _size);
+	}
+
+	close(_file);
+}
+
+
+void MappedFile::flush() {
+	if (_data && msync(_data, _size, MS_SYNC) != 0) {
+		throw std::runtime_error("cannot write " + _filename);
+	}
+}
+
+#endif
+
+
+void* MappedFile::getData() const {
+	return _data;
+}
+
+
+std::size_t MappedFile::getSize() const {
+	return _size;
+}
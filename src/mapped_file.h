@@ -0,0 +1,43 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+
+/*********
+A file mapped into memory for reading and writing, so large rasters can be filled in place without a copy in memory.
+The constructor creates the file, or empties an existing one, and grows it to size bytes of zeros.
+Writes reach the file at the latest when the mapping is destroyed, flush() forces them out earlier.
+Throws std::runtime_error if the file cannot be created or mapped.
+**********/
+class MappedFile {
+public:
+	MappedFile(const std::string& filename, std::size_t size);
+
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	void* getData() const;
+
+	std::size_t getSize() const;
+
+	void flush();
+
+private:
+	std::string _filename;
+	void* _data;
+	std::size_t _size;
+#ifdef _WIN32
+	void* _file;
+	void* _mapping;
+#else
+	int _file;
+#endif
+};
+
+
+#endif // !MAPPED_FILE_H
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include "matrix.h"
+#include "distance.h"
+#include "mapped_file.h"
+#include "shard.h"
+
+
+static const std::size_t LANDMARK_BLOCK_SIZE = 32;
+
+
+void calcSurfaceDistanceMatrix(const std::vector<glm::ivec2>& landmarks,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool)
+{
+	const std::size_t count = landmarks.size();
+	std::vector<std::uint64_t> codes(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		glm::ivec2 landmark = landmarks[i];
+		if (landmark.x < 0 || landmark.y < 0 || landmark.x >= imageWidth || landmark.y >= imageHeight) {
+			throw std::out_of_range("landmark " + std::to_string(i) + " is outside of the image");
+		}
+
+		codes[i] = calcMortonCode(landmark);
+	}
+
+	std::vector<std::size_t> order(count);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return codes[a] < codes[b]; });
+
+	// the tiles of the upper triangle of blocks, row by row, so consecutive tiles share their first block
+	std::size_t blockCount = (count + LANDMARK_BLOCK_SIZE - 1) / LANDMARK_BLOCK_SIZE;
+	std::vector<std::pair<std::size_t, std::size_t>> tiles;
+	tiles.reserve(blockCount * (blockCount + 1) / 2);
+	for (std::size_t first = 0; first < blockCount; ++first) {
+		for (std::size_t second = first; second < blockCount; ++second) {
+			tiles.emplace_back(first, second);
+		}
+	}
+
+	pool.parallelFor(tiles.size(), [&](std::size_t tile) {
+		std::size_t firstBegin = tiles[tile].first * LANDMARK_BLOCK_SIZE;
+		std::size_t firstEnd = std::min(firstBegin + LANDMARK_BLOCK_SIZE, count);
+		std::size_t secondBegin = tiles[tile].second * LANDMARK_BLOCK_SIZE;
+		std::size_t secondEnd = std::min(secondBegin + LANDMARK_BLOCK_SIZE, count);
+		for (std::size_t a = firstBegin; a < firstEnd; ++a) {
+			for (std::size_t b = std::max(secondBegin, a); b < secondEnd; ++b) {
+				// the line runs from the landmark listed first, whatever the tiling
+				std::size_t i = std::min(order[a], order[b]);
+				std::size_t j = std::max(order[a], order[b]);
+				float distance = 0.0f;
+				if (landmarks[i] != landmarks[j]) {
+					distance = calcSurfaceDistance(landmarks[i], landmarks[j], heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+				}
+
+				distances[i * count + j] = distance;
+				distances[j * count + i] = distance;
+			}
+		}
+	});
+}
+
+
+void writeSurfaceDistanceMatrix(const std::string& filename, const std::vector<glm::ivec2>& landmarks,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool)
+{
+	MappedFile file(filename, landmarks.size() * landmarks.size() * sizeof(float));
+	calcSurfaceDistanceMatrix(landmarks, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight,
+		static_cast<float*>(file.getData()), pool);
+	file.flush();
+}
@@ -0,0 +1,35 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "thread_pool.h"
+
+
+/*********
+Surface distance between every pair of landmark pixels, e.g. for network analysis over a few thousand landmarks.
+distances receives landmarks.size() x landmarks.size() values row by row: distances[i * size + j] is the distance between landmark i and landmark j.
+The surface distance does not depend on the direction of the line, so only the pairs i < j are computed, as calcSurfaceDistance(landmarks[i], landmarks[j]),
+and copied to both halves. The diagonal, and pairs of landmarks on the same pixel, get 0.
+
+The landmarks are ordered along a Z-order curve and cut into blocks of 32, and the pairs are computed in tiles of two blocks spread over the pool,
+so the lines of a tile run between the same two small regions of the DEM and keep reading the same part of it.
+Every pair is computed once by one thread, so the matrix does not depend on the pool.
+Throws std::out_of_range if a landmark is outside of the image.
+**********/
+void calcSurfaceDistanceMatrix(const std::vector<glm::ivec2>& landmarks,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool);
+
+
+/*********
+Same as calcSurfaceDistanceMatrix, written straight into a file mapped into memory, one file per epoch of the height data.
+The file holds landmarks.size() x landmarks.size() floats row by row, in the byte order of the machine, without a header.
+**********/
+void writeSurfaceDistanceMatrix(const std::string& filename, const std::vector<glm::ivec2>& landmarks,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool);
+
+
+#endif // !MATRIX_H
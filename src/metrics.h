@@ -0,0 +1,105 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cmath>
+#include <vector>
+#include "glm/glm.hpp"
+#include "distance.h"
+
+
+/*********
+Flags selecting the metrics that calcSurfaceMetrics accumulates. Combine them with |.
+**********/
+struct SurfaceMetric {
+	static constexpr unsigned Ascent = 1u << 0;
+	static constexpr unsigned Descent = 1u << 1;
+	static constexpr unsigned MaxSlope = 1u << 2;
+	static constexpr unsigned MeanSlope = 1u << 3;
+	static constexpr unsigned TravelTime = 1u << 4;
+	static constexpr unsigned All = Ascent | Descent | MaxSlope | MeanSlope | TravelTime;
+};
+
+
+/*********
+Metrics of a line over the surface, in unit meter and second. Metrics that were not selected stay zero.
+distance is always computed and is exactly calcSurfaceDistance.
+Slopes are rise over run: maxSlope is the steepest piece, meanSlope the planar-length weighted mean of the absolute slope.
+**********/
+struct SurfaceMetrics {
+	float distance;
+	float ascent;
+	float descent;
+	float maxSlope;
+	float meanSlope;
+	float travelTime;
+};
+
+
+/*********
+Tobler's hiking function: walking speed in meter per second for a signed slope (rise over run in the walking direction).
+6 km/h * exp(-3.5 * |slope + 0.05|), fastest at 5% downhill.
+**********/
+struct ToblerHikingSpeed {
+	float operator()(float slope) const {
+		return 6000.0f / 3600.0f * std::exp(-3.5f * std::abs(slope + 0.05f));
+	}
+};
+
+
+/*********
+Accumulate the selected metrics in the same walk that calcSurfaceDistance does, sharing its crossings and interpolated heights.
+Metrics is a combination of SurfaceMetric flags. It is a template argument, so metrics that are not selected are not computed at all.
+travelTime integrates planar length over speed(slope) piece by piece; speed is any callable from signed slope to meter per second.
+**********/
+template<unsigned Metrics, typename SpeedFunction = ToblerHikingSpeed>
+SurfaceMetrics calcSurfaceMetrics(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	SpeedFunction speed = SpeedFunction())
+{
+	const bool needPlanar = (Metrics & (SurfaceMetric::MaxSlope | SurfaceMetric::MeanSlope | SurfaceMetric::TravelTime)) != 0;
+
+	SurfaceMetrics metrics{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	float planarLength = 0.0f;
+	float absoluteRise = 0.0f;
+	walkSurface(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight,
+		[&](const SurfacePoint& from, const SurfacePoint& to) {
+			metrics.distance += glm::distance(from.position, to.position);
+
+			float rise = to.position.z - from.position.z;
+			if (Metrics & SurfaceMetric::Ascent) {
+				metrics.ascent += glm::max(rise, 0.0f);
+			}
+
+			if (Metrics & SurfaceMetric::Descent) {
+				metrics.descent += glm::max(-rise, 0.0f);
+			}
+
+			if (needPlanar) {
+				float run = glm::distance(glm::vec2(from.position), glm::vec2(to.position));
+				if (run > 0.0f) {
+					if (Metrics & SurfaceMetric::MaxSlope) {
+						metrics.maxSlope = glm::max(metrics.maxSlope, glm::abs(rise) / run);
+					}
+
+					if (Metrics & SurfaceMetric::MeanSlope) {
+						planarLength += run;
+						absoluteRise += glm::abs(rise);
+					}
+
+					if (Metrics & SurfaceMetric::TravelTime) {
+						metrics.travelTime += run / speed(rise / run);
+					}
+				}
+			}
+
+			return true;
+		});
+
+	if ((Metrics & SurfaceMetric::MeanSlope) && planarLength > 0.0f) {
+		metrics.meanSlope = absoluteRise / planarLength;
+	}
+
+	return metrics;
+}
+
+
+#endif // !METRICS_H
@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "nearest.h"
+#include "distance.h"
+
+
+typedef std::pair<float, std::size_t> CandidateEntry;
+
+
+CandidateIndex::CandidateIndex(const std::vector<glm::ivec2>& candidates, int imageWidth, int imageHeight, int cellSize)
+	: _candidates{candidates}, _imageWidth{imageWidth}, _imageHeight{imageHeight}, _cellSize{cellSize}
+{
+	if (cellSize < 1) {
+		throw std::invalid_argument("the cell size must be at least 1");
+	}
+
+	_cellCount = (glm::ivec2(imageWidth, imageHeight) + cellSize - 1) / cellSize;
+	std::size_t cellCount = static_cast<std::size_t>(_cellCount.x) * _cellCount.y;
+	std::vector<std::size_t> cells(candidates.size());
+	_cellStarts.assign(cellCount + 1, 0);
+	for (std::size_t i = 0; i < candidates.size(); ++i) {
+		glm::ivec2 candidate = candidates[i];
+		if (candidate.x < 0 || candidate.y < 0 || candidate.x >= imageWidth || candidate.y >= imageHeight) {
+			throw std::out_of_range("candidate " + std::to_string(i) + " is outside of the image");
+		}
+
+		cells[i] = static_cast<std::size_t>(candidate.y / cellSize) * _cellCount.x + candidate.x / cellSize;
+		++_cellStarts[cells[i] + 1];
+	}
+
+	for (std::size_t cell = 0; cell < cellCount; ++cell) {
+		_cellStarts[cell + 1] += _cellStarts[cell];
+	}
+
+	// the candidates of a cell keep their order, so the cells are filled by a counting sort
+	_cellCandidates.resize(candidates.size());
+	std::vector<std::size_t> next(_cellStarts.begin(), _cellStarts.end() - 1);
+	for (std::size_t i = 0; i < candidates.size(); ++i) {
+		_cellCandidates[next[cells[i]]++] = i;
+	}
+}
+
+
+std::size_t CandidateIndex::getCandidateCount() const {
+	return _candidates.size();
+}
+
+
+std::vector<SurfaceNeighbour> CandidateIndex::findNearest(glm::ivec2 query, std::size_t k,
+	const std::vector<unsigned char>& heightdata, float pixelDistance, float pixelHeight,
+	const SlopeBounds& bounds, std::size_t* walkCount) const
+{
+	if (query.x < 0 || query.y < 0 || query.x >= _imageWidth || query.y >= _imageHeight) {
+		throw std::out_of_range("the query is outside of the image");
+	}
+
+	const float infinity = std::numeric_limits<float>::infinity();
+	std::size_t walks = 0;
+
+	// max-heaps of the k best distances and the k smallest upper bounds, and a min-heap of the queued candidates by lower bound
+	std::vector<CandidateEntry> best;
+	std::vector<float> uppers;
+	std::vector<CandidateEntry> queue;
+
+	auto getThreshold = [&]() {
+		float threshold = infinity;
+		if (k > 0 && best.size() == k) {
+			threshold = best.front().first;
+		}
+
+		if (k > 0 && uppers.size() == k) {
+			threshold = std::min(threshold, uppers.front());
+		}
+
+		return threshold;
+	};
+
+	auto pushCandidate = [&](std::size_t index) {
+		glm::ivec2 candidate = _candidates[index];
+		float lower = bounds.getLowerBound(query, candidate);
+		if (lower > getThreshold()) {
+			return;
+		}
+
+		queue.emplace_back(lower, index);
+		std::push_heap(queue.begin(), queue.end(), std::greater<CandidateEntry>());
+
+		float upper = candidate == query ? 0.0f : bounds.getUpperBound(query, candidate);
+		if (uppers.size() < k) {
+			uppers.push_back(upper);
+			std::push_heap(uppers.begin(), uppers.end());
+		}
+		else if (upper < uppers.front()) {
+			std::pop_heap(uppers.begin(), uppers.end());
+			uppers.back() = upper;
+			std::push_heap(uppers.begin(), uppers.end());
+		}
+	};
+
+	auto visitCell = [&](glm::ivec2 cell, bool alongLastRowOrColumn) {
+		std::size_t index = static_cast<std::size_t>(cell.y) * _cellCount.x + cell.x;
+		for (std::size_t i = _cellStarts[index]; i < _cellStarts[index + 1]; ++i) {
+			std::size_t candidate = _cellCandidates[i];
+			if (bounds.isAlongLastRowOrColumn(query, _candidates[candidate]) == alongLastRowOrColumn) {
+				pushCandidate(candidate);
+			}
+		}
+	};
+
+	if (k == 0 || _candidates.empty()) {
+		if (walkCount) {
+			*walkCount = 0;
+		}
+
+		return std::vector<SurfaceNeighbour>();
+	}
+
+	// calcSurfaceDistance is 0 along the last row and column, however far apart the pixels are, so those candidates are queued up front
+	if (query.y == _imageHeight - 1) {
+		for (int x = 0; x < _cellCount.x; ++x) {
+			visitCell(glm::ivec2(x, _cellCount.y - 1), true);
+		}
+	}
+
+	if (query.x == _imageWidth - 1) {
+		int lastY = query.y == _imageHeight - 1 ? _cellCount.y - 1 : _cellCount.y;
+		for (int y = 0; y < lastY; ++y) {
+			visitCell(glm::ivec2(_cellCount.x - 1, y), true);
+		}
+	}
+
+	const glm::ivec2 queryCell = query / _cellSize;
+	const int lastRing = std::max(std::max(queryCell.x, _cellCount.x - 1 - queryCell.x), std::max(queryCell.y, _cellCount.y - 1 - queryCell.y));
+
+	// the fewest pixels between the query and a pixel in a cell of the ring
+	auto getRingBound = [&](int ring) {
+		if (ring == 0) {
+			return 0.0f;
+		}
+
+		int gap = std::numeric_limits<int>::max();
+		if (queryCell.x - ring >= 0) {
+			gap = std::min(gap, query.x - ((queryCell.x - ring + 1) * _cellSize - 1));
+		}
+
+		if (queryCell.x + ring < _cellCount.x) {
+			gap = std::min(gap, (queryCell.x + ring) * _cellSize - query.x);
+		}
+
+		if (queryCell.y - ring >= 0) {
+			gap = std::min(gap, query.y - ((queryCell.y - ring + 1) * _cellSize - 1));
+		}
+
+		if (queryCell.y + ring < _cellCount.y) {
+			gap = std::min(gap, (queryCell.y + ring) * _cellSize - query.y);
+		}
+
+		return bounds.getLowerBound(static_cast<float>(gap));
+	};
+
+	int ring = 0;
+	while (true) {
+		float threshold = getThreshold();
+		if (ring <= lastRing && (queue.empty() || getRingBound(ring) <= queue.front().first)) {
+			if (getRingBound(ring) > threshold) {
+				ring = lastRing + 1;
+				continue;
+			}
+
+			glm::ivec2 first = glm::max(queryCell - ring, glm::ivec2(0));
+			glm::ivec2 last = glm::min(queryCell + ring, _cellCount - 1);
+			for (int y = first.y; y <= last.y; ++y) {
+				if (y == queryCell.y - ring || y == queryCell.y + ring) {
+					for (int x = first.x; x <= last.x; ++x) {
+						visitCell(glm::ivec2(x, y), false);
+					}
+
+					continue;
+				}
+
+				if (queryCell.x - ring >= 0) {
+					visitCell(glm::ivec2(queryCell.x - ring, y), false);
+				}
+
+				if (queryCell.x + ring < _cellCount.x) {
+					visitCell(glm::ivec2(queryCell.x + ring, y), false);
+				}
+			}
+
+			++ring;
+			continue;
+		}
+
+		if (queue.empty()) {
+			break;
+		}
+
+		std::pop_heap(queue.begin(), queue.end(), std::greater<CandidateEntry>());
+		CandidateEntry entry = queue.back();
+		queue.pop_back();
+		if (entry.first > threshold) {
+			break;
+		}
+
+		glm::ivec2 candidate = _candidates[entry.second];
+		float distance = 0.0f;
+		bool complete = true;
+		if (candidate != query) {
+			++walks;
+			complete = walkSurface(query, candidate, heightdata, _imageWidth, _imageHeight, pixelDistance, pixelHeight,
+				[&](const SurfacePoint& from, const SurfacePoint& to) {
+					distance += glm::distance(from.position, to.position);
+					return distance <= threshold;
+				});
+		}
+
+		CandidateEntry result{ distance, entry.second };
+		if (!complete || (best.size() == k && !(result < best.front()))) {
+			continue;
+		}
+
+		if (best.size() == k) {
+			std::pop_heap(best.begin(), best.end());
+			best.pop_back();
+		}
+
+		best.push_back(result);
+		std::push_heap(best.begin(), best.end());
+	}
+
+	if (walkCount) {
+		*walkCount = walks;
+	}
+
+	std::sort(best.begin(), best.end());
+	std::vector<SurfaceNeighbour> neighbours;
+	for (const CandidateEntry& entry : best) {
+		neighbours.push_back(SurfaceNeighbour{ entry.second, entry.first });
+	}
+
+	return neighbours;
+}
@@ -0,0 +1,55 @@
+#ifndef NEAREST_H
+#define NEAREST_H
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+#include "slope_bounds.h"
+
+
+struct SurfaceNeighbour {
+	std::size_t index;
+	float distance;
+};
+
+
+/*********
+Index over a fixed set of candidate pixels to find the ones closest to a query pixel by calcSurfaceDistance, e.g. up to a million points of interest.
+The candidates are bucketed into square cells of cellSize pixels, so a query can visit them in rings of cells around the query.
+
+findNearest returns the k candidates with the smallest calcSurfaceDistance(query, candidate), sorted by distance and then by index.
+Approach:
+- The lower bound of the slope bounds, the planar distance up to 1024 pixels, holds for the surface distance,
+and so does the bound of the planar distance to a ring of cells for all candidates in it.
+- Candidates are evaluated in the order of their lower bound. Rings are opened only while their bound may still beat the k-th best distance,
+and evaluation stops at the first candidate whose bound cannot.
+- The k smallest upper bounds from the slope bounds seen so far cap the k-th best distance before k candidates are walked,
+so candidates whose lower bound exceeds that cap are never queued.
+- The walk of a candidate stops as soon as its partial distance exceeds the k-th best distance.
+Throws std::out_of_range if the query or a candidate is outside of the image.
+**********/
+class CandidateIndex {
+public:
+	CandidateIndex(const std::vector<glm::ivec2>& candidates, int imageWidth, int imageHeight, int cellSize = 32);
+
+	std::size_t getCandidateCount() const;
+
+	/*********
+	walkCount, if given, receives the number of candidates whose line was walked.
+	**********/
+	std::vector<SurfaceNeighbour> findNearest(glm::ivec2 query, std::size_t k,
+		const std::vector<unsigned char>& heightdata, float pixelDistance, float pixelHeight,
+		const SlopeBounds& bounds, std::size_t* walkCount = nullptr) const;
+
+private:
+	std::vector<glm::ivec2> _candidates;
+	std::vector<std::size_t> _cellStarts;
+	std::vector<std::size_t> _cellCandidates;
+	int _imageWidth;
+	int _imageHeight;
+	int _cellSize;
+	glm::ivec2 _cellCount;
+};
+
+
+#endif // !NEAREST_H
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include "planar.h"
+#include "distance.h"
+
+
+/*********
+Clip the line begin + ray * lineVector, ray in [0, 1], to the rectangle of the block.
+**********/
+static void clipLineToBlock(glm::ivec2 begin, glm::vec2 lineVector, const PlanarBlock& block, float& enterRay, float& exitRay) {
+	enterRay = 0.0f;
+	exitRay = 1.0f;
+	for (int axis = 0; axis < 2; ++axis) {
+		if (lineVector[axis] == 0.0f) {
+			continue;
+		}
+
+		float ray0 = (block.corner[axis] - begin[axis]) / lineVector[axis];
+		float ray1 = (block.corner[axis] + block.size[axis] - begin[axis]) / lineVector[axis];
+		enterRay = std::max(enterRay, std::min(ray0, ray1));
+		exitRay = std::min(exitRay, std::max(ray0, ray1));
+	}
+}
+
+
+static glm::vec3 interpolatePlane(glm::ivec2 begin, glm::vec2 lineVector, float ray, const PlanarBlock& block,
+	const std::vector<unsigned char>& heightdata, int imageWidth, float pixelDistance, float pixelHeight)
+{
+	glm::vec2 point = static_cast<glm::vec2>(begin) + ray * lineVector;
+	glm::vec2 offset = point - static_cast<glm::vec2>(block.corner);
+	float height = heightdata[block.corner.y * imageWidth + block.corner.x] + block.slope.x * offset.x + block.slope.y * offset.y;
+	return glm::vec3(point * pixelDistance, height * pixelHeight);
+}
+
+
+PlanarQuadtree::PlanarQuadtree(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight)
+	: _voxelWidth{std::max(imageWidth - 1, 0)}, _voxelHeight{std::max(imageHeight - 1, 0)}
+{
+	glm::ivec2 size{ _voxelWidth, _voxelHeight };
+	std::vector<Gradient> voxels(size.x * size.y);
+	for (int y = 0; y < size.y; ++y) {
+		for (int x = 0; x < size.x; ++x) {
+			int h00 = heightdata[y * imageWidth + x];
+			int h10 = heightdata[y * imageWidth + x + 1];
+			int h01 = heightdata[(y + 1) * imageWidth + x];
+			int h11 = heightdata[(y + 1) * imageWidth + x + 1];
+			voxels[y * size.x + x] = Gradient{ static_cast<short>(h10 - h00), static_cast<short>(h01 - h00), h00 + h11 == h10 + h01 };
+		}
+	}
+
+	_levels.push_back(std::move(voxels));
+	_levelSizes.push_back(size);
+	while (size.x > 1 || size.y > 1) {
+		glm::ivec2 coarseSize = (size + 1) / 2;
+		const std::vector<Gradient>& fine = _levels.back();
+		std::vector<Gradient> coarse(coarseSize.x * coarseSize.y);
+		for (int y = 0; y < coarseSize.y; ++y) {
+			for (int x = 0; x < coarseSize.x; ++x) {
+				const Gradient& first = fine[2 * y * size.x + 2 * x];
+				Gradient merged = first;
+				for (int childY = 2 * y; childY < std::min(2 * y + 2, size.y); ++childY) {
+					for (int childX = 2 * x; childX < std::min(2 * x + 2, size.x); ++childX) {
+						const Gradient& child = fine[childY * size.x + childX];
+						merged.planar = merged.planar && child.planar && child.x == first.x && child.y == first.y;
+					}
+				}
+
+				coarse[y * coarseSize.x + x] = merged;
+			}
+		}
+
+		_levels.push_back(std::move(coarse));
+		_levelSizes.push_back(coarseSize);
+		size = coarseSize;
+	}
+
+	// a planar block only has planar sub-blocks, so the largest one is found by going up until a block is not planar
+	_voxelLevels.assign(_voxelWidth * _voxelHeight, -1);
+	for (int y = 0; y < _voxelHeight; ++y) {
+		for (int x = 0; x < _voxelWidth; ++x) {
+			signed char& voxelLevel = _voxelLevels[y * _voxelWidth + x];
+			for (int level = 0; level < getLevelCount(); ++level) {
+				glm::ivec2 block = glm::ivec2(x, y) >> level;
+				if (!_levels[level][block.y * _levelSizes[level].x + block.x].planar) {
+					break;
+				}
+
+				voxelLevel = static_cast<signed char>(level);
+			}
+		}
+	}
+}
+
+
+bool PlanarQuadtree::findPlanarBlock(glm::ivec2 voxel, PlanarBlock& block) const {
+	int level = _voxelLevels[voxel.y * _voxelWidth + voxel.x];
+	if (level < 0) {
+		return false;
+	}
+
+	glm::ivec2 index = voxel >> level;
+	const Gradient& gradient = _levels[level][index.y * _levelSizes[level].x + index.x];
+	block.corner = index << level;
+	block.size = glm::min(block.corner + (1 << level), glm::ivec2(_voxelWidth, _voxelHeight)) - block.corner;
+	block.slope = glm::ivec2(gradient.x, gradient.y);
+	return true;
+}
+
+
+int PlanarQuadtree::getLevelCount() const {
+	return static_cast<int>(_levels.size());
+}
+
+
+float calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const PlanarQuadtree& quadtree, std::size_t* voxelCount)
+{
+	glm::vec2 lineVector = static_cast<glm::vec2>(end - begin);
+	VoxelTraversal traversal(begin, end, imageWidth - 1, imageHeight - 1);
+	SurfacePoint points[5];
+	glm::ivec2 voxel;
+	PlanarBlock block;
+
+	// the line is crossed up to this ray by the planar blocks so far, so a block is never counted twice
+	float coveredRay = 0.0f;
+	float distance = 0.0f;
+	while (traversal.next(voxel)) {
+		if (voxelCount) {
+			++*voxelCount;
+		}
+
+		if (quadtree.findPlanarBlock(voxel, block)) {
+			float enterRay;
+			float exitRay;
+			clipLineToBlock(begin, lineVector, block, enterRay, exitRay);
+			enterRay = std::max(enterRay, coveredRay);
+
+			// a line that only touches the block is walked through the voxel as usual
+			if (exitRay > enterRay) {
+				glm::vec3 enter = interpolatePlane(begin, lineVector, enterRay, block, heightdata, imageWidth, pixelDistance, pixelHeight);
+				glm::vec3 exit = interpolatePlane(begin, lineVector, exitRay, block, heightdata, imageWidth, pixelDistance, pixelHeight);
+				distance += glm::distance(enter, exit);
+				coveredRay = exitRay;
+
+				glm::ivec2 next;
+				if (!findVoxelAfterBlock(begin, end, block.corner, block.size, next)) {
+					break;
+				}
+
+				traversal = VoxelTraversal(begin, end, imageWidth - 1, imageHeight - 1, next);
+				continue;
+			}
+		}
+
+		int count = intersectLineAndVoxel(begin, end, voxel, heightdata, imageWidth, pixelDistance, pixelHeight, points);
+		for (int i = 0; i < count - 1; ++i) {
+			distance += glm::distance(points[i].position, points[i + 1].position);
+		}
+	}
+
+	return distance;
+}
@@ -0,0 +1,65 @@
+#ifndef PLANAR_H
+#define PLANAR_H
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+
+
+/*********
+Gradient of a planar block in height units per pixel: height(x, y) = height(corner) + slope.x * (x - corner.x) + slope.y * (y - corner.y).
+**********/
+struct PlanarBlock {
+	glm::ivec2 corner;
+	glm::ivec2 size;
+	glm::ivec2 slope;
+};
+
+
+/*********
+Quadtree over the voxels of a height map that marks the blocks where the triangulated surface is a single plane.
+A voxel is planar if its two triangles have the same gradient (h00 + h11 == h10 + h01), and a block of 2^k x 2^k voxels is planar
+if its 4 sub-blocks are planar with the same gradient. Flat areas are planar blocks with gradient 0.
+Blocks on the right and bottom border are clipped to the grid.
+For every voxel the quadtree keeps the level of the largest planar block that contains it.
+**********/
+class PlanarQuadtree {
+public:
+	PlanarQuadtree(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight);
+
+	/*********
+	Find the largest planar block that contains the voxel. Returns false if the voxel is not planar.
+	**********/
+	bool findPlanarBlock(glm::ivec2 voxel, PlanarBlock& block) const;
+
+	int getLevelCount() const;
+
+private:
+	struct Gradient {
+		short x;
+		short y;
+		bool planar;
+	};
+
+	int _voxelWidth;
+	int _voxelHeight;
+	std::vector<std::vector<Gradient>> _levels;
+	std::vector<glm::ivec2> _levelSizes;
+	std::vector<signed char> _voxelLevels;
+};
+
+
+/*********
+calcSurfaceDistance that crosses every planar block the line passes through in one step.
+Inside a block it adds the straight 3D distance between the points where the line enters and leaves the block,
+then continues the voxel traversal at the first voxel past the block, so the voxels inside are never visited.
+Lines that cross no planar block give exactly calcSurfaceDistance. Other lines cannot be bit-identical, because one long piece
+replaces the sum of the per-voxel pieces; they stay within 1e-5 relative, the order of the rounding of the float sum of calcSurfaceDistance itself.
+With voxelCount, the number of voxels visited is added to it.
+The quadtree must have been built from the same height data.
+**********/
+float calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const PlanarQuadtree& quadtree, std::size_t* voxelCount = nullptr);
+
+
+#endif // !PLANAR_H
@@ -0,0 +1,176 @@
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "polyline.h"
+
+
+static bool isStrictlyInsideVoxel(glm::vec2 position, glm::ivec2 voxel) {
+	return position.x > voxel.x && position.x < voxel.x + 1 && position.y > voxel.y && position.y < voxel.y + 1;
+}
+
+
+PolylineSurfaceDistance::PolylineSurfaceDistance(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight)
+	: _heightdata{heightdata}, _imageWidth{imageWidth}, _imageHeight{imageHeight}, _pixelDistance{pixelDistance}, _pixelHeight{pixelHeight},
+	_lastVertex{0.0f}, _lastVoxel{0}, _lastHeight{0.0f}, _totalDistance{0.0}, _vertexCount{0}
+{
+	if (imageWidth < 2 || imageHeight < 2 || heightdata.size() < static_cast<std::size_t>(imageWidth) * imageHeight) {
+		throw std::invalid_argument("the height data must hold at least 2x2 pixels");
+	}
+}
+
+
+float PolylineSurfaceDistance::push(glm::vec2 vertex) {
+	if (!(vertex.x >= 0.0f && vertex.x <= _imageWidth - 1 && vertex.y >= 0.0f && vertex.y <= _imageHeight - 1)) {
+		throw std::out_of_range("polyline vertex is outside of the image");
+	}
+
+	float distance = 0.0f;
+	if (_vertexCount == 0) {
+		_lastVoxel = findStartVoxel(vertex, glm::vec2(1.0f, 1.0f));
+		_lastHeight = interpolateHeight(_lastVoxel, vertex);
+	}
+	else {
+		distance = traverseSegment(_lastVertex, vertex);
+		_totalDistance += distance;
+	}
+
+	_lastVertex = vertex;
+	++_vertexCount;
+	return distance;
+}
+
+
+float PolylineSurfaceDistance::getTotalDistance() const {
+	return static_cast<float>(_totalDistance);
+}
+
+
+std::size_t PolylineSurfaceDistance::getVertexCount() const {
+	return _vertexCount;
+}
+
+
+void PolylineSurfaceDistance::reset() {
+	_totalDistance = 0.0;
+	_vertexCount = 0;
+}
+
+
+float PolylineSurfaceDistance::traverseSegment(glm::vec2 from, glm::vec2 to) {
+	glm::vec2 delta = to - from;
+	if (delta.x == 0.0f && delta.y == 0.0f) {
+		return 0.0f;
+	}
+
+	// a join inside of a voxel continues in the voxel the previous segment ended in
+	glm::ivec2 voxel = isStrictlyInsideVoxel(from, _lastVoxel) ? _lastVoxel : findStartVoxel(from, delta);
+
+	const float infinity = std::numeric_limits<float>::infinity();
+	int stepX = delta.x < 0 ? -1 : 1;
+	int stepY = delta.y < 0 ? -1 : 1;
+	float tDeltaX = delta.x != 0.0f ? glm::abs(1.0f / delta.x) : infinity;
+	float tDeltaY = delta.y != 0.0f ? glm::abs(1.0f / delta.y) : infinity;
+	float tMaxX = delta.x > 0.0f ? (voxel.x + 1 - from.x) / delta.x : (delta.x < 0.0f ? (voxel.x - from.x) / delta.x : infinity);
+	float tMaxY = delta.y > 0.0f ? (voxel.y + 1 - from.y) / delta.y : (delta.y < 0.0f ? (voxel.y - from.y) / delta.y : infinity);
+
+	// planar length of the segment in meters, pieces are measured as parameter intervals of it
+	// so that the distance does not suffer from subtracting large coordinates
+	float planarLength = glm::length(delta) * _pixelDistance;
+	auto pieceLength = [&](float dt, float dh) {
+		float planar = dt * planarLength;
+		return std::sqrt(planar * planar + dh * dh);
+	};
+
+	float distance = 0.0f;
+	float tEnter = 0.0f;
+	float heightEnter = _lastHeight;
+	float diagonalSlope = delta.x + delta.y;
+	for (;;) {
+		float tExit = std::min(std::min(tMaxX, tMaxY), 1.0f);
+
+		// the diagonal from (x+1, y) to (x, y+1) splits the voxel into two triangles
+		if (diagonalSlope != 0.0f) {
+			float tDiagonal = (voxel.x + voxel.y + 1 - from.x - from.y) / diagonalSlope;
+			if (tDiagonal > tEnter && tDiagonal < tExit) {
+				float heightDiagonal = interpolateHeight(voxel, from + tDiagonal * delta);
+				distance += pieceLength(tDiagonal - tEnter, heightDiagonal - heightEnter);
+				tEnter = tDiagonal;
+				heightEnter = heightDiagonal;
+			}
+		}
+
+		bool lastVoxel = tExit >= 1.0f;
+		float heightExit = interpolateHeight(voxel, lastVoxel ? to : from + tExit * delta);
+		distance += pieceLength(tExit - tEnter, heightExit - heightEnter);
+		tEnter = tExit;
+		heightEnter = heightExit;
+		if (lastVoxel) {
+			break;
+		}
+
+		// through a voxel corner both coordinates step at once
+		float tStep = std::min(tMaxX, tMaxY);
+		if (tMaxX == tStep) {
+			voxel.x += stepX;
+			tMaxX += tDeltaX;
+		}
+
+		if (tMaxY == tStep) {
+			voxel.y += stepY;
+			tMaxY += tDeltaY;
+		}
+
+		// rounding can step past the image border when the segment ends on it
+		if (voxel.x < 0 || voxel.x > _imageWidth - 2) {
+			voxel.x = glm::clamp(voxel.x, 0, _imageWidth - 2);
+			tMaxX = infinity;
+		}
+
+		if (voxel.y < 0 || voxel.y > _imageHeight - 2) {
+			voxel.y = glm::clamp(voxel.y, 0, _imageHeight - 2);
+			tMaxY = infinity;
+		}
+	}
+
+	_lastVoxel = voxel;
+	_lastHeight = heightEnter;
+	return distance;
+}
+
+
+float PolylineSurfaceDistance::interpolateHeight(glm::ivec2 voxel, glm::vec2 position) const {
+	float u = glm::clamp(position.x - voxel.x, 0.0f, 1.0f);
+	float v = glm::clamp(position.y - voxel.y, 0.0f, 1.0f);
+	int index = voxel.y * _imageWidth + voxel.x;
+	float height00 = _heightdata[index];
+	float height10 = _heightdata[index + 1];
+	float height01 = _heightdata[index + _imageWidth];
+	float height11 = _heightdata[index + _imageWidth + 1];
+
+	float height;
+	if (u + v <= 1.0f) {
+		height = height00 + u * (height10 - height00) + v * (height01 - height00);
+	}
+	else {
+		height = height11 + (1.0f - u) * (height01 - height11) + (1.0f - v) * (height10 - height11);
+	}
+
+	return height * _pixelHeight;
+}
+
+
+glm::ivec2 PolylineSurfaceDistance::findStartVoxel(glm::vec2 position, glm::vec2 direction) const {
+	int voxelX = static_cast<int>(std::floor(position.x));
+	int voxelY = static_cast<int>(std::floor(position.y));
+
+	// on a voxel boundary, start in the voxel the direction points into
+	if (direction.x < 0 && voxelX == position.x) {
+		--voxelX;
+	}
+
+	if (direction.y < 0 && voxelY == position.y) {
+		--voxelY;
+	}
+
+	return glm::ivec2(glm::clamp(voxelX, 0, _imageWidth - 2), glm::clamp(voxelY, 0, _imageHeight - 2));
+}
@@ -0,0 +1,56 @@
+#ifndef POLYLINE_H
+#define POLYLINE_H
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+
+
+/*********
+Surface distance along a polyline whose vertices are pushed one at a time, e.g. a GPS track read from a stream.
+Vertices are in pixel units and may have fractional coordinates, but must lie inside of the image: x in [0, imageWidth-1], y in [0, imageHeight-1].
+The surface model is the same as in calcSurfaceDistance: every voxel is split into two triangles by the diagonal from (x+1, y) to (x, y+1).
+
+Approach:
+- Every segment walks the voxels it passes through (Amanatides and Woo). Inside a voxel it is split where it crosses the voxel boundary and the diagonal,
+and the heights at those points are interpolated on the triangle they lie on.
+- The voxel and the height of the last vertex are kept, so the next segment starts from there instead of locating the join again.
+- Only the running total is stored, so memory does not depend on the number of vertices.
+**********/
+class PolylineSurfaceDistance {
+public:
+	PolylineSurfaceDistance(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+	/*********
+	Append a vertex and return the surface distance of the segment that ends at it (zero for the first vertex).
+	Throws std::out_of_range if the vertex is outside of the image.
+	**********/
+	float push(glm::vec2 vertex);
+
+	float getTotalDistance() const;
+
+	std::size_t getVertexCount() const;
+
+	void reset();
+
+private:
+	float traverseSegment(glm::vec2 from, glm::vec2 to);
+
+	float interpolateHeight(glm::ivec2 voxel, glm::vec2 position) const;
+
+	glm::ivec2 findStartVoxel(glm::vec2 position, glm::vec2 direction) const;
+
+	const std::vector<unsigned char>& _heightdata;
+	int _imageWidth;
+	int _imageHeight;
+	float _pixelDistance;
+	float _pixelHeight;
+	glm::vec2 _lastVertex;
+	glm::ivec2 _lastVoxel;
+	float _lastHeight;
+	double _totalDistance;
+	std::size_t _vertexCount;
+};
+
+
+#endif // !POLYLINE_H
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include "profile.h"
+#include "distance.h"
+
+
+static const std::size_t SINK_CHUNK_SIZE = 256;
+
+
+static void checkLineInsideImage(glm::ivec2 begin, glm::ivec2 end, int imageWidth, int imageHeight) {
+	auto isInside = [&](glm::ivec2 pixel) {
+		return pixel.x >= 0 && pixel.y >= 0 && pixel.x < imageWidth && pixel.y < imageHeight;
+	};
+
+	if (!isInside(begin) || !isInside(end)) {
+		throw std::out_of_range("the line is outside of the image");
+	}
+}
+
+
+/*********
+Walk the line and call emit(sample) for every sample of the profile.
+**********/
+template<typename Emit>
+static void walkProfile(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float resampleSpacing, Emit&& emit)
+{
+	checkLineInsideImage(begin, end, imageWidth, imageHeight);
+	float lineLength = glm::length(static_cast<glm::vec2>(end - begin)) * pixelDistance;
+	ProfileSample last{ 0.0f, 0.0f, heightdata[begin.y * imageWidth + begin.x] * pixelHeight };
+	emit(last);
+
+	bool resample = resampleSpacing > 0.0f;
+	float nextPlanar = resampleSpacing;
+	float distance = 0.0f;
+	float lastEmittedPlanar = 0.0f;
+	walkSurface(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight,
+		[&](const SurfacePoint& from, const SurfacePoint& to) {
+			float planarFrom = from.ray * lineLength;
+			float planarTo = to.ray * lineLength;
+			float distanceFrom = distance;
+			distance += glm::distance(from.position, to.position);
+
+			if (!resample) {
+				// corners are crossed by several voxel bounds at once, keep one sample for them
+				if (planarTo > lastEmittedPlanar) {
+					emit(ProfileSample{ distance, planarTo, to.position.z });
+					lastEmittedPlanar = planarTo;
+				}
+
+				return true;
+			}
+
+			while (nextPlanar <= planarTo && planarTo > planarFrom) {
+				float t = (nextPlanar - planarFrom) / (planarTo - planarFrom);
+				emit(ProfileSample{
+					distanceFrom + t * (distance - distanceFrom),
+					nextPlanar,
+					from.position.z + t * (to.position.z - from.position.z) });
+				lastEmittedPlanar = nextPlanar;
+				nextPlanar += resampleSpacing;
+			}
+
+			last = ProfileSample{ distance, planarTo, to.position.z };
+			return true;
+		});
+
+	if (resample && last.planarDistance > lastEmittedPlanar) {
+		emit(last);
+	}
+}
+
+
+std::size_t calcSurfaceProfile(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ProfileSample* samples, std::size_t capacity, float resampleSpacing)
+{
+	std::size_t count = 0;
+	walkProfile(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight, resampleSpacing,
+		[&](const ProfileSample& sample) {
+			if (count < capacity) {
+				samples[count] = sample;
+			}
+
+			++count;
+		});
+
+	return count;
+}
+
+
+void calcSurfaceProfile(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ProfileSink& sink, float resampleSpacing)
+{
+	ProfileSample chunk[SINK_CHUNK_SIZE];
+	std::size_t count = 0;
+	walkProfile(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight, resampleSpacing,
+		[&](const ProfileSample& sample) {
+			chunk[count++] = sample;
+			if (count == SINK_CHUNK_SIZE) {
+				sink.consume(chunk, count);
+				count = 0;
+			}
+		});
+
+	if (count > 0) {
+		sink.consume(chunk, count);
+	}
+}
+
+
+SurfaceLocation locateSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, float distance,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight)
+{
+	SurfaceLocation location;
+	locateSurfaceDistances(begin, end, &distance, 1, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight, &location);
+	return location;
+}
+
+
+void locateSurfaceDistances(glm::ivec2 begin, glm::ivec2 end, const float* distances, std::size_t count,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	SurfaceLocation* locations)
+{
+	for (std::size_t i = 0; i < count; ++i) {
+		if (!(distances[i] >= 0.0f)) {
+			throw std::invalid_argument("surface distances to locate must not be negative");
+		}
+
+		if (i > 0 && distances[i] < distances[i - 1]) {
+			throw std::invalid_argument("surface distances to locate must be sorted in ascending order");
+		}
+	}
+
+	checkLineInsideImage(begin, end, imageWidth, imageHeight);
+
+	glm::vec3 last{ glm::vec2(begin) * pixelDistance, heightdata[begin.y * imageWidth + begin.x] * pixelHeight };
+	std::size_t next = 0;
+	for (; next < count && distances[next] == 0.0f; ++next) {
+		locations[next] = SurfaceLocation{ true, glm::vec2(begin), last.z };
+	}
+
+	float walked = 0.0f;
+	if (next < count) {
+		walkSurface(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight,
+			[&](const SurfacePoint& from, const SurfacePoint& to) {
+				float length = glm::distance(from.position, to.position);
+				float after = walked + length;
+				for (; next < count && distances[next] <= after; ++next) {
+					float t = length > 0.0f ? glm::clamp((distances[next] - walked) / length, 0.0f, 1.0f) : 1.0f;
+					glm::vec3 position = from.position + t * (to.position - from.position);
+					locations[next] = SurfaceLocation{ true, glm::vec2(position) / pixelDistance, position.z };
+				}
+
+				walked = after;
+				last = to.position;
+				return next < count;
+			});
+	}
+
+	for (; next < count; ++next) {
+		locations[next] = SurfaceLocation{ false, glm::vec2(last) / pixelDistance, last.z };
+	}
+}
+
+
+glm::ivec2 findHeadingEnd(glm::ivec2 begin, glm::ivec2 direction, int imageWidth, int imageHeight) {
+	if (direction == glm::ivec2(0)) {
+		throw std::invalid_argument("the heading needs a direction");
+	}
+
+	if (begin.x < 0 || begin.y < 0 || begin.x >= imageWidth || begin.y >= imageHeight) {
+		throw std::out_of_range("the begin pixel is outside of the image");
+	}
+
+	// the number of steps each axis allows before it leaves the image
+	int steps = std::numeric_limits<int>::max();
+	if (direction.x != 0) {
+		steps = std::min(steps, (direction.x > 0 ? imageWidth - 1 - begin.x : begin.x) / std::abs(direction.x));
+	}
+
+	if (direction.y != 0) {
+		steps = std::min(steps, (direction.y > 0 ? imageHeight - 1 - begin.y : begin.y) / std::abs(direction.y));
+	}
+
+	return begin + direction * steps;
+}
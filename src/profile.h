@@ -0,0 +1,88 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+
+
+/*********
+One sample of the surface profile along a line, all in unit meter:
+distance is the surface distance from the begin pixel, planarDistance the distance on the map, height the surface height.
+**********/
+struct ProfileSample {
+	float distance;
+	float planarDistance;
+	float height;
+};
+
+
+/*********
+Receives the profile in chunks. The samples pointer is only valid during the call.
+**********/
+class ProfileSink {
+public:
+	virtual ~ProfileSink() = default;
+
+	virtual void consume(const ProfileSample* samples, std::size_t count) = 0;
+};
+
+
+/*********
+Find the surface profile of the line from begin to end in the same walk that calcSurfaceDistance does.
+Without resampling there is one sample at the begin pixel and one at every crossing with a voxel boundary or diagonal,
+and the distance of the last sample is exactly calcSurfaceDistance.
+With resampleSpacing > 0 the samples are placed every resampleSpacing meters of planar distance instead, plus one at the end.
+
+The first version writes at most capacity samples into the caller's buffer and returns the number of samples of the full profile,
+so a return value larger than capacity means the buffer was too small. The second version hands the samples to the sink in chunks.
+Neither allocates memory. Both throw std::out_of_range if begin or end is outside of the image.
+**********/
+std::size_t calcSurfaceProfile(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ProfileSample* samples, std::size_t capacity, float resampleSpacing = 0.0f);
+
+
+void calcSurfaceProfile(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ProfileSink& sink, float resampleSpacing = 0.0f);
+
+
+/*********
+The point on the surface at a given surface distance from the begin pixel of a line.
+pixel is in pixel units and may be fractional, height is in unit meter.
+If the line ends before the distance is covered, reached is false and the point is where the walk ended.
+**********/
+struct SurfaceLocation {
+	bool reached;
+	glm::vec2 pixel;
+	float height;
+};
+
+
+/*********
+Find where the line from begin to end reaches the given surface distance, in the same walk that calcSurfaceDistance does.
+The surface is planar between two crossings, so the point is interpolated linearly on the piece that covers the distance,
+and a distance of exactly calcSurfaceDistance is reached at end. Throws std::invalid_argument for a negative distance,
+and std::out_of_range if begin or end is outside of the image.
+**********/
+SurfaceLocation locateSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, float distance,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight);
+
+
+/*********
+Same as locateSurfaceDistance for many distances along the same line in one walk, e.g. to place a marker every 100 meters.
+The distances must be sorted in ascending order, otherwise std::invalid_argument is thrown. locations[i] receives the point of distances[i].
+Lines outside of the image throw std::out_of_range.
+**********/
+void locateSurfaceDistances(glm::ivec2 begin, glm::ivec2 end, const float* distances, std::size_t count,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	SurfaceLocation* locations);
+
+
+/*********
+The last pixel begin + k * direction, for the largest k, that is still inside the image, e.g. to walk from begin along a heading until the grid ends.
+Throws std::invalid_argument if direction is zero, and std::out_of_range if begin is outside of the image.
+**********/
+glm::ivec2 findHeadingEnd(glm::ivec2 begin, glm::ivec2 direction, int imageWidth, int imageHeight);
+
+
+#endif // !PROFILE_H
@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <stdexcept>
+#include "raster.h"
+#include "distance.h"
+#include "mapped_file.h"
+
+
+static int findGreatestCommonDivisor(int a, int b) {
+	while (b != 0) {
+		int rest = a % b;
+		a = b;
+		b = rest;
+	}
+
+	return a;
+}
+
+
+void calcSurfaceDistanceRaster(glm::ivec2 source, glm::ivec2 windowBegin, int windowWidth, int windowHeight,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool)
+{
+	glm::ivec2 windowEnd = windowBegin + glm::ivec2(windowWidth, windowHeight);
+	if (source.x < 0 || source.y < 0 || source.x >= imageWidth || source.y >= imageHeight) {
+		throw std::out_of_range("the source is outside of the image");
+	}
+
+	if (windowWidth < 0 || windowHeight < 0 || windowBegin.x < 0 || windowBegin.y < 0 || windowEnd.x > imageWidth || windowEnd.y > imageHeight) {
+		throw std::out_of_range("the window is outside of the image");
+	}
+
+	auto isInWindow = [&](glm::ivec2 pixel) {
+		return pixel.x >= windowBegin.x && pixel.y >= windowBegin.y && pixel.x < windowEnd.x && pixel.y < windowEnd.y;
+	};
+
+	auto toWindowIndex = [&](glm::ivec2 pixel) {
+		return static_cast<std::size_t>(pixel.y - windowBegin.y) * windowWidth + (pixel.x - windowBegin.x);
+	};
+
+	// every row walks the rays that end in it
+	pool.parallelFor(static_cast<std::size_t>(windowHeight), [&](std::size_t row) {
+		for (int x = windowBegin.x; x < windowEnd.x; ++x) {
+			glm::ivec2 last{ x, windowBegin.y + static_cast<int>(row) };
+			glm::ivec2 offset = last - source;
+			if (offset == glm::ivec2(0)) {
+				distances[toWindowIndex(last)] = 0.0f;
+				continue;
+			}
+
+			int count = findGreatestCommonDivisor(std::abs(offset.x), std::abs(offset.y));
+			glm::ivec2 step = offset / count;
+			if (isInWindow(last + step)) {
+				continue;
+			}
+
+			// the pixel k of the ray is source + k * step, at the parameter k / count of the line to last
+			int next = count;
+			while (next > 1 && isInWindow(source + step * (next - 1))) {
+				--next;
+			}
+
+			// any other crossing lies at least 1 / (count * (|step.x| + |step.y|)) away from a pixel of the ray
+			float tolerance = 0.5f / (static_cast<float>(count) * (std::abs(step.x) + std::abs(step.y)));
+			float distance = 0.0f;
+			walkSurface(source, last, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight,
+				[&](const SurfacePoint& from, const SurfacePoint& to) {
+					distance += glm::distance(from.position, to.position);
+					while (next <= count && to.ray >= static_cast<float>(next) / count - tolerance) {
+						distances[toWindowIndex(source + step * next)] = distance;
+						++next;
+					}
+
+					return true;
+				});
+
+			// the walk stops early on the last row and column, where calcSurfaceDistance does not count the rest either
+			for (; next <= count; ++next) {
+				distances[toWindowIndex(source + step * next)] = distance;
+			}
+		}
+	});
+}
+
+
+void writeSurfaceDistanceRaster(const std::string& filename, glm::ivec2 source, glm::ivec2 windowBegin, int windowWidth, int windowHeight,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool)
+{
+	if (windowWidth < 0 || windowHeight < 0) {
+		throw std::out_of_range("the window is outside of the image");
+	}
+
+	MappedFile file(filename, static_cast<std::size_t>(windowWidth) * windowHeight * sizeof(float));
+	calcSurfaceDistanceRaster(source, windowBegin, windowWidth, windowHeight, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight,
+		static_cast<float*>(file.getData()), pool);
+	file.flush();
+}
@@ -0,0 +1,37 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "thread_pool.h"
+
+
+/*********
+Surface distance of the straight line from source to every pixel of a window, e.g. to map the change around a crater between two epochs.
+The window starts at windowBegin and is windowWidth x windowHeight pixels, distances receives its pixels row by row.
+The distance at a pixel is calcSurfaceDistance(source, pixel) up to float rounding, and 0 at the source itself.
+
+Approach:
+- The pixels whose offsets from source reduce to the same direction (dx/g, dy/g), with g the greatest common divisor, lie on one ray from source.
+A rectangle cuts a ray in one piece, so the pixels of a ray in the window follow each other and end at the one whose next step leaves the window.
+- Every ray is walked once from source to its last pixel, and the running distance is written at each pixel of the ray on the way,
+so the work is the sum of the ray lengths instead of one line per pixel.
+- The rays are spread over the threads of the pool and every pixel belongs to one ray, so the raster does not depend on the pool.
+Throws std::out_of_range if source or the window is not inside the image.
+**********/
+void calcSurfaceDistanceRaster(glm::ivec2 source, glm::ivec2 windowBegin, int windowWidth, int windowHeight,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool);
+
+
+/*********
+Same as calcSurfaceDistanceRaster, written straight into a file mapped into memory, one file per epoch of the height data.
+The file holds windowWidth * windowHeight floats row by row, in the byte order of the machine, without a header.
+**********/
+void writeSurfaceDistanceRaster(const std::string& filename, glm::ivec2 source, glm::ivec2 windowBegin, int windowWidth, int windowHeight,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ThreadPool& pool);
+
+
+#endif // !RASTER_H
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include "result_cache.h"
+#include "distance.h"
+
+
+static const std::size_t SET_SIZE = 8;
+
+static const std::size_t RESULT_BLOCK_SIZE = 64;
+
+
+static std::uint64_t packPixel(glm::ivec2 pixel) {
+	return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(pixel.x)) << 32) | static_cast<std::uint32_t>(pixel.y);
+}
+
+
+// the smaller endpoint first, by x and then by y
+static void orderEndpoints(glm::ivec2& begin, glm::ivec2& end) {
+	if (end.x < begin.x || (end.x == begin.x && end.y < begin.y)) {
+		std::swap(begin, end);
+	}
+}
+
+
+static std::uint32_t toBits(float value) {
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+
+static float fromBits(std::uint32_t bits) {
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+
+ResultCache::ResultCache(std::size_t byteBudget, std::size_t shardCount)
+	: _shardCount{1}, _setsPerShard{1}
+{
+	while (_shardCount * 2 <= std::max<std::size_t>(shardCount, 1)) {
+		_shardCount *= 2;
+	}
+
+	std::size_t setCount = byteBudget / (sizeof(Entry) * SET_SIZE * _shardCount);
+	while (_setsPerShard * 2 <= setCount) {
+		_setsPerShard *= 2;
+	}
+
+	_shards.reset(new Shard[_shardCount]);
+	for (std::size_t i = 0; i < _shardCount; ++i) {
+		_shards[i].entries.reset(new Entry[_setsPerShard * SET_SIZE]);
+		_shards[i].hands.assign(_setsPerShard, 0);
+	}
+}
+
+
+ResultCache::Key ResultCache::makeKey(DatasetKey dataset, glm::ivec2 begin, glm::ivec2 end) {
+	orderEndpoints(begin, end);
+	return Key{ (static_cast<std::uint64_t>(dataset.id) << 32) | dataset.version, packPixel(begin), packPixel(end) };
+}
+
+
+std::uint64_t ResultCache::hashKey(const Key& key) {
+	// combine the three words, then mix with the splitmix64 finalizer
+	std::uint64_t hash = key.dataset;
+	for (std::uint64_t word : { key.begin, key.end }) {
+		hash ^= word + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+	}
+
+	hash ^= hash >> 30;
+	hash *= 0xBF58476D1CE4E5B9ull;
+	hash ^= hash >> 27;
+	hash *= 0x94D049BB133111EBull;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+
+bool ResultCache::lookup(DatasetKey dataset, glm::ivec2 begin, glm::ivec2 end, float& distance) const {
+	Key key = makeKey(dataset, begin, end);
+	std::uint64_t hash = hashKey(key);
+	Shard& shard = _shards[(hash >> 48) & (_shardCount - 1)];
+	Entry* set = &shard.entries[(hash & (_setsPerShard - 1)) * SET_SIZE];
+	for (std::size_t way = 0; way < SET_SIZE; ++way) {
+		Entry& entry = set[way];
+		std::uint32_t sequence = entry.sequence.load(std::memory_order_acquire);
+		if (sequence & 1) {
+			continue;
+		}
+
+		bool used = entry.used.load(std::memory_order_relaxed) != 0;
+		bool match = entry.dataset.load(std::memory_order_relaxed) == key.dataset &&
+			entry.begin.load(std::memory_order_relaxed) == key.begin &&
+			entry.end.load(std::memory_order_relaxed) == key.end;
+		std::uint32_t bits = entry.distance.load(std::memory_order_relaxed);
+
+		// the fields were read between two equal even sequence numbers, so no writer touched them in between
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (entry.sequence.load(std::memory_order_relaxed) != sequence || !used || !match) {
+			continue;
+		}
+
+		entry.referenced.store(1, std::memory_order_relaxed);
+		shard.hits.fetch_add(1, std::memory_order_relaxed);
+		distance = fromBits(bits);
+		return true;
+	}
+
+	shard.misses.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+
+void ResultCache::writeEntry(Entry& entry, const Key* key, float distance) {
+	std::uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+	entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	entry.used.store(key ? 1 : 0, std::memory_order_relaxed);
+	entry.referenced.store(0, std::memory_order_relaxed);
+	if (key) {
+		entry.dataset.store(key->dataset, std::memory_order_relaxed);
+		entry.begin.store(key->begin, std::memory_order_relaxed);
+		entry.end.store(key->end, std::memory_order_relaxed);
+		entry.distance.store(toBits(distance), std::memory_order_relaxed);
+	}
+
+	entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+
+void ResultCache::insert(DatasetKey dataset, glm::ivec2 begin, glm::ivec2 end, float distance) {
+	Key key = makeKey(dataset, begin, end);
+	std::uint64_t hash = hashKey(key);
+	Shard& shard = _shards[(hash >> 48) & (_shardCount - 1)];
+	std::size_t setIndex = hash & (_setsPerShard - 1);
+	Entry* set = &shard.entries[setIndex * SET_SIZE];
+
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	Entry* target = nullptr;
+	for (std::size_t way = 0; way < SET_SIZE && !target; ++way) {
+		Entry& entry = set[way];
+		bool used = entry.used.load(std::memory_order_relaxed) != 0;
+		if (!used || (entry.dataset.load(std::memory_order_relaxed) == key.dataset &&
+			entry.begin.load(std::memory_order_relaxed) == key.begin && entry.end.load(std::memory_order_relaxed) == key.end))
+		{
+			target = &entry;
+		}
+	}
+
+	if (!target) {
+		// the hand clears the marks it passes, so it stops within one round unless lookups keep marking the set
+		std::uint8_t& hand = shard.hands[setIndex];
+		while (set[hand].referenced.exchange(0, std::memory_order_relaxed)) {
+			hand = static_cast<std::uint8_t>((hand + 1) % SET_SIZE);
+		}
+
+		target = &set[hand];
+		hand = static_cast<std::uint8_t>((hand + 1) % SET_SIZE);
+		shard.evictions.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	writeEntry(*target, &key, distance);
+	shard.insertions.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void ResultCache::invalidate(std::uint32_t datasetId) {
+	for (std::size_t i = 0; i < _shardCount; ++i) {
+		Shard& shard = _shards[i];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (std::size_t j = 0; j < _setsPerShard * SET_SIZE; ++j) {
+			Entry& entry = shard.entries[j];
+			if (entry.used.load(std::memory_order_relaxed) && (entry.dataset.load(std::memory_order_relaxed) >> 32) == datasetId) {
+				writeEntry(entry, nullptr, 0.0f);
+			}
+		}
+	}
+}
+
+
+void ResultCache::clear() {
+	for (std::size_t i = 0; i < _shardCount; ++i) {
+		Shard& shard = _shards[i];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (std::size_t j = 0; j < _setsPerShard * SET_SIZE; ++j) {
+			if (shard.entries[j].used.load(std::memory_order_relaxed)) {
+				writeEntry(shard.entries[j], nullptr, 0.0f);
+			}
+		}
+	}
+}
+
+
+std::size_t ResultCache::getCapacity() const {
+	return _shardCount * _setsPerShard * SET_SIZE;
+}
+
+
+ResultCacheStats ResultCache::getStats() const {
+	ResultCacheStats stats{ 0, 0, 0, 0 };
+	for (std::size_t i = 0; i < _shardCount; ++i) {
+		stats.hits += _shards[i].hits.load(std::memory_order_relaxed);
+		stats.misses += _shards[i].misses.load(std::memory_order_relaxed);
+		stats.insertions += _shards[i].insertions.load(std::memory_order_relaxed);
+		stats.evictions += _shards[i].evictions.load(std::memory_order_relaxed);
+	}
+
+	return stats;
+}
+
+
+float calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ResultCache& cache, DatasetKey dataset)
+{
+	float distance;
+	if (cache.lookup(dataset, begin, end, distance)) {
+		return distance;
+	}
+
+	orderEndpoints(begin, end);
+	distance = calcSurfaceDistance(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight);
+	cache.insert(dataset, begin, end, distance);
+	return distance;
+}
+
+
+void calcSurfaceDistances(const SurfaceQuery* queries, std::size_t count,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool, ResultCache& cache, DatasetKey dataset)
+{
+	std::size_t blockCount = (count + RESULT_BLOCK_SIZE - 1) / RESULT_BLOCK_SIZE;
+	pool.parallelFor(blockCount, [&](std::size_t block) {
+		std::size_t first = block * RESULT_BLOCK_SIZE;
+		std::size_t last = std::min(first + RESULT_BLOCK_SIZE, count);
+		for (std::size_t i = first; i < last; ++i) {
+			distances[i] = calcSurfaceDistance(queries[i].begin, queries[i].end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight, cache, dataset);
+		}
+	});
+}
@@ -0,0 +1,125 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "glm/glm.hpp"
+#include "batch.h"
+#include "thread_pool.h"
+
+
+/*********
+Names the height data a result was computed on. The version must change whenever the heights do,
+so results of an old version are never returned for the new one.
+**********/
+struct DatasetKey {
+	std::uint32_t id;
+	std::uint32_t version;
+};
+
+
+struct ResultCacheStats {
+	std::uint64_t hits;
+	std::uint64_t misses;
+	std::uint64_t insertions;
+	std::uint64_t evictions;
+};
+
+
+/*********
+Concurrent cache of surface distances, keyed by (dataset id, dataset version, smaller endpoint, larger endpoint).
+The endpoints are ordered, so a line and its reverse share one entry. The value stored is the one of the line
+from the smaller to the larger endpoint, which matches the reverse line up to float rounding.
+
+The entries are split into shards by the hash of their key. Every shard is a set-associative table with 8 entries per set,
+and a full set evicts with the CLOCK algorithm: lookups mark the entries they hit, and an insertion moves the hand
+over the set, clearing marks, until it finds an unmarked entry.
+Lookups take no lock. Every entry has a sequence number that writers make odd while they change it,
+and a lookup that sees the number odd or changed counts as a miss. Writers to the same shard take its lock.
+byteBudget bounds the memory of the entries. It is rounded down to a power of two sets per shard, with at least one set per shard.
+**********/
+class ResultCache {
+public:
+	explicit ResultCache(std::size_t byteBudget, std::size_t shardCount = 16);
+
+	ResultCache(const ResultCache&) = delete;
+
+	ResultCache& operator=(const ResultCache&) = delete;
+
+	bool lookup(DatasetKey dataset, glm::ivec2 begin, glm::ivec2 end, float& distance) const;
+
+	void insert(DatasetKey dataset, glm::ivec2 begin, glm::ivec2 end, float distance);
+
+	/*********
+	Drop every entry of the dataset, of all its versions, e.g. when it is unloaded or a new version replaces it.
+	Entries of old versions are never hit again anyway, this only frees their room earlier.
+	**********/
+	void invalidate(std::uint32_t datasetId);
+
+	void clear();
+
+	std::size_t getCapacity() const;
+
+	ResultCacheStats getStats() const;
+
+private:
+	struct Entry {
+		std::atomic<std::uint32_t> sequence{ 0 };
+		std::atomic<std::uint32_t> distance{ 0 };
+		std::atomic<std::uint64_t> dataset{ 0 };
+		std::atomic<std::uint64_t> begin{ 0 };
+		std::atomic<std::uint64_t> end{ 0 };
+		std::atomic<std::uint8_t> used{ 0 };
+		std::atomic<std::uint8_t> referenced{ 0 };
+	};
+
+	struct Shard {
+		std::unique_ptr<Entry[]> entries;
+		std::vector<std::uint8_t> hands;
+		std::mutex mutex;
+		std::atomic<std::uint64_t> hits{ 0 };
+		std::atomic<std::uint64_t> misses{ 0 };
+		std::atomic<std::uint64_t> insertions{ 0 };
+		std::atomic<std::uint64_t> evictions{ 0 };
+	};
+
+	struct Key {
+		std::uint64_t dataset;
+		std::uint64_t begin;
+		std::uint64_t end;
+	};
+
+	static Key makeKey(DatasetKey dataset, glm::ivec2 begin, glm::ivec2 end);
+
+	static std::uint64_t hashKey(const Key& key);
+
+	void writeEntry(Entry& entry, const Key* key, float distance);
+
+	std::unique_ptr<Shard[]> _shards;
+	std::size_t _shardCount;
+	std::size_t _setsPerShard;
+};
+
+
+/*********
+calcSurfaceDistance through the cache: a hit returns the cached value,
+a miss finds the distance from the smaller to the larger endpoint and stores it.
+The dataset key must name the height data passed in.
+**********/
+float calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	ResultCache& cache, DatasetKey dataset);
+
+
+/*********
+calcSurfaceDistances through the cache, with the same values as the single line version above.
+**********/
+void calcSurfaceDistances(const SurfaceQuery* queries, std::size_t count,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	float* distances, ThreadPool& pool, ResultCache& cache, DatasetKey dataset);
+
+
+#endif // !RESULT_CACHE_H
@@ -0,0 +1,341 @@
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include "shard.h"
+#include "io.h"
+
+
+static const char* MANIFEST_HEADER = "surface-distance-shard 1";
+
+
+static std::uint64_t spreadBits(std::uint32_t value) {
+	std::uint64_t x = value;
+	x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+	x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+	x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+	x = (x | (x << 2)) & 0x3333333333333333ull;
+	x = (x | (x << 1)) & 0x5555555555555555ull;
+	return x;
+}
+
+
+std::uint64_t calcMortonCode(glm::ivec2 tile) {
+	return spreadBits(static_cast<std::uint32_t>(tile.x)) | (spreadBits(static_cast<std::uint32_t>(tile.y)) << 1);
+}
+
+
+static bool isPixelInside(glm::ivec2 pixel, int imageWidth, int imageHeight) {
+	return pixel.x >= 0 && pixel.x < imageWidth && pixel.y >= 0 && pixel.y < imageHeight;
+}
+
+
+static void expectToken(std::istream& stream, const std::string& token, const std::string& filename) {
+	std::string word;
+	if (!(stream >> word) || word != token) {
+		throw std::runtime_error(filename + ": expected '" + token + "'");
+	}
+}
+
+
+/*********
+Parse every complete "[query index] [distance]" line of a result file.
+Returns the number of bytes that belong to complete lines, so a torn tail left by a crash can be detected.
+**********/
+template<typename Callback>
+static std::size_t readResultLines(const std::string& filename, std::size_t& fileSize, Callback callback) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		fileSize = 0;
+		return 0;
+	}
+
+	std::string content{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	fileSize = content.size();
+	std::size_t validSize = content.rfind('\n');
+	validSize = validSize == std::string::npos ? 0 : validSize + 1;
+
+	std::istringstream stream(content.substr(0, validSize));
+	std::string line;
+	while (std::getline(stream, line)) {
+		if (line.empty()) {
+			continue;
+		}
+
+		std::istringstream fields(line);
+		std::size_t index;
+		float distance;
+		if (!(fields >> index >> distance)) {
+			throw std::runtime_error(filename + ": malformed result line '" + line + "'");
+		}
+
+		callback(index, distance);
+	}
+
+	return validSize;
+}
+
+
+std::vector<ShardManifest> planShards(const std::vector<SurfaceQuery>& queries, int imageWidth, int imageHeight, int tileSize, int shardCount) {
+	if (tileSize <= 0 || shardCount <= 0) {
+		throw std::invalid_argument("tile size and shard count must be positive");
+	}
+
+	struct PlannedQuery {
+		std::uint64_t key;
+		std::uint64_t cost;
+		std::size_t index;
+	};
+
+	std::vector<PlannedQuery> planned;
+	planned.reserve(queries.size());
+	std::uint64_t totalCost = 0;
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		const SurfaceQuery& query = queries[i];
+		if (!isPixelInside(query.begin, imageWidth, imageHeight) || !isPixelInside(query.end, imageWidth, imageHeight)) {
+			throw std::out_of_range("query " + std::to_string(i) + " has a pixel outside of the image");
+		}
+
+		glm::ivec2 midTile = (query.begin + query.end) / 2 / tileSize;
+		glm::ivec2 extent = glm::abs(query.end - query.begin);
+		std::uint64_t cost = static_cast<std::uint64_t>(extent.x + extent.y + 1);
+		planned.push_back(PlannedQuery{ calcMortonCode(midTile), cost, i });
+		totalCost += cost;
+	}
+
+	std::stable_sort(planned.begin(), planned.end(),
+		[](const PlannedQuery& a, const PlannedQuery& b) { return a.key < b.key; });
+
+	std::vector<ShardManifest> shards(shardCount);
+	for (int s = 0; s < shardCount; ++s) {
+		shards[s].shardIndex = s;
+		shards[s].shardCount = shardCount;
+		shards[s].imageWidth = imageWidth;
+		shards[s].imageHeight = imageHeight;
+		shards[s].tileSize = tileSize;
+		shards[s].tileMin = glm::ivec2(0, 0);
+		shards[s].tileMax = glm::ivec2(-1, -1);
+	}
+
+	int shard = 0;
+	std::uint64_t accumulatedCost = 0;
+	for (const PlannedQuery& query : planned) {
+		// move on once this shard has its share of the total cost
+		while (shard < shardCount - 1 && accumulatedCost * shardCount >= totalCost * (shard + 1)) {
+			++shard;
+		}
+
+		ShardManifest& manifest = shards[shard];
+		const SurfaceQuery& surfaceQuery = queries[query.index];
+		glm::ivec2 tileLow = glm::min(surfaceQuery.begin, surfaceQuery.end) / tileSize;
+		glm::ivec2 tileHigh = glm::max(surfaceQuery.begin, surfaceQuery.end) / tileSize;
+		if (manifest.queries.empty()) {
+			manifest.tileMin = tileLow;
+			manifest.tileMax = tileHigh;
+		}
+		else {
+			manifest.tileMin = glm::min(manifest.tileMin, tileLow);
+			manifest.tileMax = glm::max(manifest.tileMax, tileHigh);
+		}
+
+		manifest.queryIndices.push_back(query.index);
+		manifest.queries.push_back(surfaceQuery);
+		accumulatedCost += query.cost;
+	}
+
+	return shards;
+}
+
+
+void writeShardManifest(const std::string& filename, const ShardManifest& manifest) {
+	std::ofstream file(filename);
+	if (!file) {
+		throw std::runtime_error("cannot open " + filename + " for writing");
+	}
+
+	file << MANIFEST_HEADER << "\n";
+	file << "shard " << manifest.shardIndex << " " << manifest.shardCount << "\n";
+	file << "image " << manifest.imageWidth << " " << manifest.imageHeight << "\n";
+	file << "tiles " << manifest.tileSize << " "
+		<< manifest.tileMin.x << " " << manifest.tileMin.y << " "
+		<< manifest.tileMax.x << " " << manifest.tileMax.y << "\n";
+	file << "queries " << manifest.queries.size() << "\n";
+	for (std::size_t i = 0; i < manifest.queries.size(); ++i) {
+		const SurfaceQuery& query = manifest.queries[i];
+		file << manifest.queryIndices[i] << " "
+			<< query.begin.x << " " << query.begin.y << " " << query.end.x << " " << query.end.y << "\n";
+	}
+
+	if (!file.flush()) {
+		throw std::runtime_error("cannot write " + filename);
+	}
+}
+
+
+ShardManifest readShardManifest(const std::string& filename) {
+	std::ifstream file(filename);
+	if (!file) {
+		throw std::runtime_error("cannot open " + filename);
+	}
+
+	std::string header;
+	std::getline(file, header);
+	if (header != MANIFEST_HEADER) {
+		throw std::runtime_error(filename + ": not a shard manifest");
+	}
+
+	ShardManifest manifest;
+	std::size_t queryCount = 0;
+	expectToken(file, "shard", filename);
+	file >> manifest.shardIndex >> manifest.shardCount;
+	expectToken(file, "image", filename);
+	file >> manifest.imageWidth >> manifest.imageHeight;
+	expectToken(file, "tiles", filename);
+	file >> manifest.tileSize >> manifest.tileMin.x >> manifest.tileMin.y >> manifest.tileMax.x >> manifest.tileMax.y;
+	expectToken(file, "queries", filename);
+	file >> queryCount;
+	if (!file) {
+		throw std::runtime_error(filename + ": malformed manifest header");
+	}
+
+	manifest.queryIndices.resize(queryCount);
+	manifest.queries.resize(queryCount);
+	for (std::size_t i = 0; i < queryCount; ++i) {
+		SurfaceQuery& query = manifest.queries[i];
+		if (!(file >> manifest.queryIndices[i] >> query.begin.x >> query.begin.y >> query.end.x >> query.end.y)) {
+			throw std::runtime_error(filename + ": expected " + std::to_string(queryCount) + " queries");
+		}
+	}
+
+	return manifest;
+}
+
+
+std::vector<unsigned char> readShardHeightData(const std::string& filename, const ShardManifest& manifest) {
+	glm::ivec2 pixelMin = manifest.tileMin * manifest.tileSize - 1;
+	glm::ivec2 pixelMax = (manifest.tileMax + 1) * manifest.tileSize;
+	if (manifest.queries.empty()) {
+		pixelMax = pixelMin - 1;
+	}
+
+	return readHeightData(filename, manifest.imageWidth, manifest.imageHeight, pixelMin, pixelMax);
+}
+
+
+std::size_t runShard(const ShardManifest& manifest, const std::string& resultFile,
+	const std::vector<unsigned char>& heightdata, float pixelDistance, float pixelHeight,
+	ThreadPool& pool, std::size_t checkpointInterval)
+{
+	if (heightdata.size() < static_cast<std::size_t>(manifest.imageWidth) * manifest.imageHeight) {
+		throw std::invalid_argument("height data is smaller than the image of the shard");
+	}
+
+	std::unordered_map<std::size_t, std::size_t> positions;
+	positions.reserve(manifest.queryIndices.size());
+	for (std::size_t i = 0; i < manifest.queryIndices.size(); ++i) {
+		positions[manifest.queryIndices[i]] = i;
+	}
+
+	// pick up the checkpoint of an earlier run
+	std::vector<char> done(manifest.queries.size(), 0);
+	std::size_t fileSize = 0;
+	std::size_t validSize = readResultLines(resultFile, fileSize, [&](std::size_t index, float) {
+		auto position = positions.find(index);
+		if (position == positions.end()) {
+			throw std::runtime_error(resultFile + ": query " + std::to_string(index) + " does not belong to shard " + std::to_string(manifest.shardIndex));
+		}
+
+		done[position->second] = 1;
+	});
+
+	if (validSize != fileSize) {
+		std::ifstream torn(resultFile, std::ios::binary);
+		std::string content(validSize, '\0');
+		torn.read(&content[0], validSize);
+		torn.close();
+
+		std::string temporaryFile = resultFile + ".tmp";
+		{
+			std::ofstream repaired(temporaryFile, std::ios::binary | std::ios::trunc);
+			repaired.write(content.data(), content.size());
+			if (!repaired.flush()) {
+				throw std::runtime_error("cannot write " + temporaryFile);
+			}
+		}
+
+		std::remove(resultFile.c_str());
+		if (std::rename(temporaryFile.c_str(), resultFile.c_str()) != 0) {
+			throw std::runtime_error("cannot replace " + resultFile);
+		}
+	}
+
+	std::vector<std::size_t> pending;
+	for (std::size_t i = 0; i < done.size(); ++i) {
+		if (!done[i]) {
+			pending.push_back(i);
+		}
+	}
+
+	std::ofstream results(resultFile, std::ios::app);
+	if (!results) {
+		throw std::runtime_error("cannot open " + resultFile + " for writing");
+	}
+
+	results.precision(std::numeric_limits<float>::max_digits10);
+	checkpointInterval = std::max<std::size_t>(checkpointInterval, 1);
+	std::vector<SurfaceQuery> chunk;
+	std::vector<float> distances;
+	for (std::size_t first = 0; first < pending.size(); first += checkpointInterval) {
+		std::size_t last = std::min(first + checkpointInterval, pending.size());
+		chunk.clear();
+		for (std::size_t i = first; i < last; ++i) {
+			chunk.push_back(manifest.queries[pending[i]]);
+		}
+
+		distances.resize(chunk.size());
+		calcSurfaceDistances(chunk.data(), chunk.size(), heightdata, manifest.imageWidth, manifest.imageHeight, pixelDistance, pixelHeight, distances.data(), pool);
+
+		for (std::size_t i = first; i < last; ++i) {
+			results << manifest.queryIndices[pending[i]] << " " << distances[i - first] << "\n";
+		}
+
+		if (!results.flush()) {
+			throw std::runtime_error("cannot write " + resultFile);
+		}
+	}
+
+	return pending.size();
+}
+
+
+std::vector<float> mergeShardResults(const std::vector<std::string>& resultFiles, std::size_t queryCount) {
+	std::vector<float> distances(queryCount, 0.0f);
+	std::vector<char> found(queryCount, 0);
+	for (const std::string& resultFile : resultFiles) {
+		std::size_t fileSize = 0;
+		readResultLines(resultFile, fileSize, [&](std::size_t index, float distance) {
+			if (index >= queryCount) {
+				throw std::runtime_error(resultFile + ": query " + std::to_string(index) + " is out of range");
+			}
+
+			if (found[index] && distances[index] != distance) {
+				throw std::runtime_error(resultFile + ": conflicting results for query " + std::to_string(index));
+			}
+
+			distances[index] = distance;
+			found[index] = 1;
+		});
+	}
+
+	auto missing = std::find(found.begin(), found.end(), 0);
+	if (missing != found.end()) {
+		throw std::runtime_error("no result for query " + std::to_string(missing - found.begin()));
+	}
+
+	return distances;
+}
@@ -0,0 +1,79 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "batch.h"
+#include "thread_pool.h"
+
+
+/*********
+One part of a large query file that can be processed on its own by another process or host.
+queryIndices[i] is the position of queries[i] in the original query file.
+tileMin and tileMax (inclusive) bound the DEM tiles of size tileSize x tileSize that the queries touch,
+so a worker only needs that part of the raster.
+**********/
+struct ShardManifest {
+	int shardIndex;
+	int shardCount;
+	int imageWidth;
+	int imageHeight;
+	int tileSize;
+	glm::ivec2 tileMin;
+	glm::ivec2 tileMax;
+	std::vector<std::size_t> queryIndices;
+	std::vector<SurfaceQuery> queries;
+};
+
+
+/*********
+Position of a cell with non-negative coordinates along the Z-order curve, which interleaves the bits of x and y.
+Cells close on the curve are close on the grid, so sorting by the code keeps neighbouring cells together.
+**********/
+std::uint64_t calcMortonCode(glm::ivec2 tile);
+
+
+/*********
+Partition the queries into shards that each cover a compact region of the DEM.
+Every query is keyed by the tile of its midpoint, queries are ordered along a Z-order curve over those tiles,
+and the ordered list is cut into shardCount runs of about the same traversal cost (the number of voxels a line crosses).
+Queries with a pixel outside of the image throw std::out_of_range.
+**********/
+std::vector<ShardManifest> planShards(const std::vector<SurfaceQuery>& queries, int imageWidth, int imageHeight, int tileSize, int shardCount);
+
+
+void writeShardManifest(const std::string& filename, const ShardManifest& manifest);
+
+
+ShardManifest readShardManifest(const std::string& filename);
+
+
+/*********
+Read the part of a raw height map that the queries of the shard walk: its tiles and the one pixel around them
+that the first voxel of a line and the corners of the last one may reach. The other pixels are 0.
+**********/
+std::vector<unsigned char> readShardHeightData(const std::string& filename, const ShardManifest& manifest);
+
+
+/*********
+Process one shard and append "[query index] [distance]" lines to resultFile.
+Results are flushed after every checkpointInterval queries. If resultFile already holds results from an earlier run
+that crashed, those queries are not computed again and a partially written last line is dropped.
+The function returns the number of queries computed by this call.
+**********/
+std::size_t runShard(const ShardManifest& manifest, const std::string& resultFile,
+	const std::vector<unsigned char>& heightdata, float pixelDistance, float pixelHeight,
+	ThreadPool& pool, std::size_t checkpointInterval = 4096);
+
+
+/*********
+Reassemble the results of all shards in the order of the original query file.
+Throws std::runtime_error if a query has no result or two shards disagree on it.
+**********/
+std::vector<float> mergeShardResults(const std::vector<std::string>& resultFiles, std::size_t queryCount);
+
+
+#endif // !SHARD_H
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <exception>
+#include "io.h"
+#include "shard.h"
+
+
+void displayUsage() {
+	std::cout << "Usage:\n";
+	std::cout << "  plan [query_file] [image_width] [image_height] [shard_count] [tile_size] [manifest_prefix]\n";
+	std::cout << "      partition the query file and write [manifest_prefix].[shard].manifest for every shard\n";
+	std::cout << "  work [manifest_file] [height_file] [pixel_distance] [pixel_height] [result_file] [thread_count]\n";
+	std::cout << "      process one shard; rerunning it after a crash resumes from the last checkpoint in result_file\n";
+	std::cout << "  merge [query_file] [output_file] [result_file]...\n";
+	std::cout << "      write the distances of all shards to output_file in the order of the query file\n";
+}
+
+
+int plan(char** args) {
+	std::vector<SurfaceQuery> queries = readQueries(args[2]);
+	int imageWidth = std::stoi(args[3]);
+	int imageHeight = std::stoi(args[4]);
+	int shardCount = std::stoi(args[5]);
+	int tileSize = std::stoi(args[6]);
+	std::string prefix = args[7];
+
+	std::vector<ShardManifest> shards = planShards(queries, imageWidth, imageHeight, tileSize, shardCount);
+	for (const ShardManifest& shard : shards) {
+		std::string filename = prefix + "." + std::to_string(shard.shardIndex) + ".manifest";
+		writeShardManifest(filename, shard);
+		std::cout << filename << ": " << shard.queries.size() << " queries, tiles ("
+			<< shard.tileMin.x << ", " << shard.tileMin.y << ") - (" << shard.tileMax.x << ", " << shard.tileMax.y << ")\n";
+	}
+
+	return 0;
+}
+
+
+int work(int argv, char** args) {
+	ShardManifest manifest = readShardManifest(args[2]);
+	std::vector<unsigned char> heights = readShardHeightData(args[3], manifest);
+	float pixelDistance = std::stof(args[4]);
+	float pixelHeight = std::stof(args[5]);
+	unsigned threadCount = argv == 8 ? static_cast<unsigned>(std::stoul(args[7])) : 0;
+
+	ThreadPool pool(threadCount);
+	std::size_t computed = runShard(manifest, args[6], heights, pixelDistance, pixelHeight, pool);
+	std::cout << "shard " << manifest.shardIndex << ": computed " << computed << " of " << manifest.queries.size() << " queries\n";
+	return 0;
+}
+
+
+int merge(int argv, char** args) {
+	std::size_t queryCount = readQueries(args[2]).size();
+	std::vector<std::string> resultFiles(args + 4, args + argv);
+	writeDistances(args[3], mergeShardResults(resultFiles, queryCount));
+	return 0;
+}
+
+
+int main(int argv, char** args) {
+	std::string command = argv > 1 ? args[1] : "";
+	try {
+		if (command == "plan" && argv == 8) {
+			return plan(args);
+		}
+		else if (command == "work" && (argv == 7 || argv == 8)) {
+			return work(argv, args);
+		}
+		else if (command == "merge" && argv >= 5) {
+			return merge(argv, args);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "error: " << e.what() << "\n";
+		return 1;
+	}
+
+	displayUsage();
+	return 0;
+}
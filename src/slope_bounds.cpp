@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "slope_bounds.h"
+#include "distance.h"
+
+
+static const float BOUND_SLACK = 1e-3f;
+
+// the float voxel traversal of calcSurfaceDistance drifts low on longer lines, by 1.8% at 4096 pixels and more beyond
+static const float VALIDATED_LENGTH = 1024.0f;
+
+
+SlopeBounds::SlopeBounds(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight, int tileSize)
+	: _imageWidth{imageWidth}, _imageHeight{imageHeight}, _pixelDistance{pixelDistance}, _tileSize{tileSize}
+{
+	if (imageWidth < 2 || imageHeight < 2 || tileSize < 1) {
+		throw std::invalid_argument("slope bounds need an image of at least 2x2 pixels and a tile size of at least 1");
+	}
+
+	_tileCount = (glm::ivec2(imageWidth, imageHeight) - 1 + tileSize - 1) / tileSize;
+	_maxSecants.assign(static_cast<std::size_t>(_tileCount.x) * _tileCount.y, 1.0f);
+
+	auto getHeight = [&](int x, int y) {
+		return static_cast<float>(heightdata[static_cast<std::size_t>(y) * imageWidth + x]);
+	};
+
+	// gradient of a triangle in meter per meter, from its heights in pixelHeight units per pixel
+	const float scale = pixelHeight / pixelDistance;
+	for (int y = 0; y < imageHeight - 1; ++y) {
+		for (int x = 0; x < imageWidth - 1; ++x) {
+			glm::vec2 lower = glm::vec2(getHeight(x + 1, y) - getHeight(x, y), getHeight(x, y + 1) - getHeight(x, y)) * scale;
+			glm::vec2 upper = glm::vec2(getHeight(x + 1, y + 1) - getHeight(x, y + 1), getHeight(x + 1, y + 1) - getHeight(x + 1, y)) * scale;
+			float secant = std::sqrt(1.0f + std::max(glm::dot(lower, lower), glm::dot(upper, upper)));
+			float& maxSecant = _maxSecants[static_cast<std::size_t>(y / tileSize) * _tileCount.x + x / tileSize];
+			maxSecant = std::max(maxSecant, secant);
+		}
+	}
+}
+
+
+int SlopeBounds::getTileSize() const {
+	return _tileSize;
+}
+
+
+glm::ivec2 SlopeBounds::getTileCount() const {
+	return _tileCount;
+}
+
+
+float SlopeBounds::getMaxSecant(glm::ivec2 tile) const {
+	return _maxSecants[static_cast<std::size_t>(tile.y) * _tileCount.x + tile.x];
+}
+
+
+float SlopeBounds::getMaxSecant(glm::ivec2 begin, glm::ivec2 end) const {
+	if (begin.x > end.x) {
+		std::swap(begin, end);
+	}
+
+	// a voxel x covers the pixels x to x + 1, and the first voxel of a line may lie one pixel before begin
+	auto toTile = [&](int pixel, int imageSize) {
+		return std::min(std::max(pixel, 0), imageSize - 2) / _tileSize;
+	};
+
+	float maxSecant = 1.0f;
+	int lastColumn = toTile(end.x, _imageWidth);
+	for (int column = toTile(begin.x - 1, _imageWidth); column <= lastColumn; ++column) {
+		float x0 = std::max(static_cast<float>(begin.x), static_cast<float>(column * _tileSize - 1));
+		float x1 = std::min(static_cast<float>(end.x), static_cast<float>((column + 1) * _tileSize + 1));
+		float y0 = static_cast<float>(begin.y);
+		float y1 = static_cast<float>(end.y);
+		if (end.x != begin.x) {
+			float slope = static_cast<float>(end.y - begin.y) / (end.x - begin.x);
+			y0 = begin.y + (x0 - begin.x) * slope;
+			y1 = begin.y + (x1 - begin.x) * slope;
+		}
+
+		if (y0 > y1) {
+			std::swap(y0, y1);
+		}
+
+		int lastRow = toTile(static_cast<int>(std::ceil(y1)) + 1, _imageHeight);
+		for (int row = toTile(static_cast<int>(std::floor(y0)) - 2, _imageHeight); row <= lastRow; ++row) {
+			maxSecant = std::max(maxSecant, getMaxSecant(glm::ivec2(column, row)));
+		}
+	}
+
+	return maxSecant;
+}
+
+
+float SlopeBounds::getLowerBound(glm::ivec2 begin, glm::ivec2 end) const {
+	if (isAlongLastRowOrColumn(begin, end)) {
+		return 0.0f;
+	}
+
+	return getLowerBound(glm::length(static_cast<glm::vec2>(end - begin)));
+}
+
+
+float SlopeBounds::getLowerBound(float pixelLength) const {
+	// longer lines come out at least half their length on grids up to 16384 pixels, far above the bound of a validated line
+	return _pixelDistance * std::min(pixelLength, VALIDATED_LENGTH) * (1.0f - BOUND_SLACK);
+}
+
+
+float SlopeBounds::getUpperBound(glm::ivec2 begin, glm::ivec2 end) const {
+	if (isAlongLastRowOrColumn(begin, end)) {
+		return std::numeric_limits<float>::infinity();
+	}
+
+	float pixelLength = glm::length(static_cast<glm::vec2>(end - begin));
+	if (pixelLength > VALIDATED_LENGTH) {
+		return std::numeric_limits<float>::infinity();
+	}
+
+	return _pixelDistance * pixelLength * getMaxSecant(begin, end) * (1.0f + BOUND_SLACK);
+}
+
+
+bool SlopeBounds::isAlongLastRowOrColumn(glm::ivec2 begin, glm::ivec2 end) const {
+	return begin != end && ((begin.x == _imageWidth - 1 && end.x == _imageWidth - 1) || (begin.y == _imageHeight - 1 && end.y == _imageHeight - 1));
+}
+
+
+bool isSurfaceDistanceWithin(glm::ivec2 begin, glm::ivec2 end, float limit,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const SlopeBounds* bounds)
+{
+	if (bounds && bounds->getUpperBound(begin, end) <= limit) {
+		return true;
+	}
+
+	if (bounds && bounds->getLowerBound(begin, end) > limit) {
+		return false;
+	}
+
+	float distance = 0.0f;
+	return walkSurface(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight,
+		[&](const SurfacePoint& from, const SurfacePoint& to) {
+			distance += glm::distance(from.position, to.position);
+			return distance <= limit;
+		});
+}
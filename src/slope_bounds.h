@@ -0,0 +1,73 @@
+#ifndef SLOPE_BOUNDS_H
+#define SLOPE_BOUNDS_H
+
+#include <vector>
+#include "glm/glm.hpp"
+
+
+/*********
+Bounds on calcSurfaceDistance that need no walk over the surface.
+Inside a triangle of the surface a line of planar length L has a surface length of L * sqrt(1 + s^2), where s is its slope,
+and s is at most the gradient g of the triangle. So the surface distance lies between the planar distance and
+the planar distance times the largest secant factor sqrt(1 + g^2) of the triangles the line passes through.
+The factors are kept per tile of tileSize x tileSize voxels, and a line takes the maximum over the tiles its voxels may lie in.
+
+Both bounds leave a slack of 0.1% for the float rounding of calcSurfaceDistance, which holds for lines up to 1024 pixels.
+Longer lines can come out several percent short, so they get an upper bound of infinity and the lower bound of a line of 1024 pixels,
+which keeps the lower bound growing with the length.
+Lines that run along the last row or column, which calcSurfaceDistance does not walk, get a lower bound of 0 and an upper bound of infinity.
+**********/
+class SlopeBounds {
+public:
+	SlopeBounds(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight, int tileSize = 16);
+
+	int getTileSize() const;
+
+	glm::ivec2 getTileCount() const;
+
+	/*********
+	Largest secant factor sqrt(1 + g^2) of the triangles in a tile, at least 1.
+	**********/
+	float getMaxSecant(glm::ivec2 tile) const;
+
+	/*********
+	Largest secant factor of the tiles that the voxels of the line from begin to end may lie in.
+	**********/
+	float getMaxSecant(glm::ivec2 begin, glm::ivec2 end) const;
+
+	float getLowerBound(glm::ivec2 begin, glm::ivec2 end) const;
+
+	/*********
+	Lower bound of every line calcSurfaceDistance walks whose planar length is at least pixelLength pixels. It never decreases with pixelLength.
+	**********/
+	float getLowerBound(float pixelLength) const;
+
+	float getUpperBound(glm::ivec2 begin, glm::ivec2 end) const;
+
+	/*********
+	Whether begin and end differ and both lie on the last row or both on the last column, where calcSurfaceDistance does not walk.
+	**********/
+	bool isAlongLastRowOrColumn(glm::ivec2 begin, glm::ivec2 end) const;
+
+private:
+	std::vector<float> _maxSecants;
+	int _imageWidth;
+	int _imageHeight;
+	float _pixelDistance;
+	int _tileSize;
+	glm::ivec2 _tileCount;
+};
+
+
+/*********
+Whether calcSurfaceDistance(begin, end) is at most limit, without finding the distance itself.
+With bounds, the answer comes without a walk whenever the upper bound is within limit or the lower bound is beyond it.
+Otherwise the line is walked the same way calcSurfaceDistance does, and the walk stops as soon as the partial distance exceeds limit.
+The answer is the same with or without bounds; lines longer than 1024 pixels are only decided by the bounds when limit is below 1024 pixels.
+**********/
+bool isSurfaceDistanceWithin(glm::ivec2 begin, glm::ivec2 end, float limit,
+	const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const SlopeBounds* bounds = nullptr);
+
+
+#endif // !SLOPE_BOUNDS_H
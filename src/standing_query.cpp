@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "standing_query.h"
+#include "distance.h"
+
+
+StandingQueryRegistry::StandingQueryRegistry(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight, int tileSize)
+	: _heightdata{heightdata}, _imageWidth{imageWidth}, _imageHeight{imageHeight}, _pixelDistance{pixelDistance}, _pixelHeight{pixelHeight},
+	_tileSize{tileSize}, _patchCount{0}, _lastPatchVoxelCount{0}
+{
+	if (imageWidth < 2 || imageHeight < 2 || tileSize < 1) {
+		throw std::invalid_argument("standing queries need an image of at least 2x2 pixels and a tile size of at least 1");
+	}
+
+	_tileCount = (glm::ivec2(imageWidth, imageHeight) - 1 + tileSize - 1) / tileSize;
+	_tileSegments.resize(static_cast<std::size_t>(_tileCount.x) * _tileCount.y);
+}
+
+
+std::size_t StandingQueryRegistry::registerQuery(glm::ivec2 begin, glm::ivec2 end) {
+	if (begin.x < 0 || begin.y < 0 || begin.x >= _imageWidth || begin.y >= _imageHeight ||
+		end.x < 0 || end.y < 0 || end.x >= _imageWidth || end.y >= _imageHeight)
+	{
+		throw std::out_of_range("the line has an endpoint outside of the image");
+	}
+
+	StandingQuery query;
+	query.begin = begin;
+	query.end = end;
+	query.step = glm::ivec2(end.x < begin.x ? -1 : 1, end.y < begin.y ? -1 : 1);
+	query.distance = 0.0;
+
+	// a voxel on the last row or column is only yielded for lines calcSurfaceDistance does not walk, and holds no surface
+	std::vector<glm::ivec2> voxels = traverseRayAndVoxels(begin, end, _imageWidth - 1, _imageHeight - 1);
+	voxels.erase(std::remove_if(voxels.begin(), voxels.end(), [&](glm::ivec2 voxel) {
+		return voxel.x < 0 || voxel.y < 0 || voxel.x >= _imageWidth - 1 || voxel.y >= _imageHeight - 1;
+	}), voxels.end());
+
+	query.stepsInX.assign((voxels.size() + 63) / 64, 0);
+	glm::ivec2 currentTile{ -1 };
+	for (std::size_t i = 0; i < voxels.size(); ++i) {
+		if (i + 1 < voxels.size() && voxels[i + 1].x != voxels[i].x) {
+			query.stepsInX[i / 64] |= std::uint64_t(1) << (i % 64);
+		}
+
+		glm::ivec2 tile = voxels[i] / _tileSize;
+		if (tile != currentTile) {
+			query.segments.push_back(Segment{ voxels[i], static_cast<std::uint32_t>(i), 0, 0.0f });
+			currentTile = tile;
+		}
+
+		++query.segments.back().voxelCount;
+	}
+
+	const std::uint32_t id = static_cast<std::uint32_t>(_queries.size());
+	for (std::size_t i = 0; i < query.segments.size(); ++i) {
+		Segment& segment = query.segments[i];
+		segment.distance = sumSegment(query, segment);
+		query.distance += segment.distance;
+
+		glm::ivec2 tile = segment.firstVoxel / _tileSize;
+		_tileSegments[static_cast<std::size_t>(tile.y) * _tileCount.x + tile.x].push_back(SegmentRef{ id, static_cast<std::uint32_t>(i) });
+	}
+
+	_queries.push_back(std::move(query));
+	_patchStamps.push_back(0);
+	return id;
+}
+
+
+std::size_t StandingQueryRegistry::getQueryCount() const {
+	return _queries.size();
+}
+
+
+float StandingQueryRegistry::getDistance(std::size_t query) const {
+	return static_cast<float>(_queries[query].distance);
+}
+
+
+const std::vector<unsigned char>& StandingQueryRegistry::getHeightData() const {
+	return _heightdata;
+}
+
+
+std::vector<std::size_t> StandingQueryRegistry::applyPatch(glm::ivec2 corner, int patchWidth, int patchHeight, const std::vector<unsigned char>& patch) {
+	if (patchWidth < 0 || patchHeight < 0 || corner.x < 0 || corner.y < 0 || corner.x + patchWidth > _imageWidth || corner.y + patchHeight > _imageHeight) {
+		throw std::out_of_range("the patch does not fit into the image");
+	}
+
+	if (patch.size() != static_cast<std::size_t>(patchWidth) * patchHeight) {
+		throw std::invalid_argument("the patch holds " + std::to_string(patch.size()) + " heights instead of " +
+			std::to_string(static_cast<std::size_t>(patchWidth) * patchHeight));
+	}
+
+	for (int y = 0; y < patchHeight; ++y) {
+		std::copy(patch.begin() + static_cast<std::size_t>(y) * patchWidth, patch.begin() + static_cast<std::size_t>(y + 1) * patchWidth,
+			_heightdata.begin() + static_cast<std::size_t>(corner.y + y) * _imageWidth + corner.x);
+	}
+
+	++_patchCount;
+	_lastPatchVoxelCount = 0;
+	std::vector<std::size_t> affected;
+	if (patchWidth == 0 || patchHeight == 0) {
+		return affected;
+	}
+
+	// a pixel is a corner of the voxels to its upper left, upper right, lower left and lower right
+	glm::ivec2 firstTile = glm::max(corner - 1, glm::ivec2(0)) / _tileSize;
+	glm::ivec2 lastTile = glm::min(corner + glm::ivec2(patchWidth, patchHeight) - 1, glm::ivec2(_imageWidth, _imageHeight) - 2) / _tileSize;
+	for (int tileY = firstTile.y; tileY <= lastTile.y; ++tileY) {
+		for (int tileX = firstTile.x; tileX <= lastTile.x; ++tileX) {
+			for (const SegmentRef& ref : _tileSegments[static_cast<std::size_t>(tileY) * _tileCount.x + tileX]) {
+				StandingQuery& query = _queries[ref.query];
+				Segment& segment = query.segments[ref.segment];
+				float distance = sumSegment(query, segment);
+				query.distance += static_cast<double>(distance) - segment.distance;
+				segment.distance = distance;
+				_lastPatchVoxelCount += segment.voxelCount;
+
+				if (_patchStamps[ref.query] != _patchCount) {
+					_patchStamps[ref.query] = _patchCount;
+					affected.push_back(ref.query);
+				}
+			}
+		}
+	}
+
+	std::sort(affected.begin(), affected.end());
+	return affected;
+}
+
+
+std::size_t StandingQueryRegistry::getLastPatchVoxelCount() const {
+	return _lastPatchVoxelCount;
+}
+
+
+float StandingQueryRegistry::sumSegment(const StandingQuery& query, const Segment& segment) const {
+	SurfacePoint points[5];
+	float distance = 0.0f;
+	glm::ivec2 voxel = segment.firstVoxel;
+	for (std::uint32_t i = 0; i < segment.voxelCount; ++i) {
+		int count = intersectLineAndVoxel(query.begin, query.end, voxel, _heightdata, _imageWidth, _pixelDistance, _pixelHeight, points);
+		for (int j = 0; j < count - 1; ++j) {
+			distance += glm::distance(points[j].position, points[j + 1].position);
+		}
+
+		std::uint32_t step = segment.firstStep + i;
+		if ((query.stepsInX[step / 64] >> (step % 64)) & 1) {
+			voxel.x += query.step.x;
+		}
+		else {
+			voxel.y += query.step.y;
+		}
+	}
+
+	return distance;
+}
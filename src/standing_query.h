@@ -0,0 +1,88 @@
+#ifndef STANDING_QUERY_H
+#define STANDING_QUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+
+/*********
+A fixed set of lines whose surface distances are kept up to date while patches of new survey data replace parts of the height map.
+
+Every registered line is cut into segments, one per tile of tileSize x tileSize voxels that its voxels (from traverseRayAndVoxels) pass through,
+and the registry remembers the surface distance of every segment and, per tile, the segments that lie in it.
+The voxels of a line step monotonically in x and y, so the voxels in a tile follow each other and a segment is a start voxel and a count.
+A patch only changes the voxels that touch its pixels, so only the segments in their tiles are walked again,
+and each line affected swaps the old distance of the segment for the new one. The work of a patch scales with the tiles it touches
+and the segments in them, not with the number of lines.
+
+The distances are sums of the segment distances, so they match calcSurfaceDistance on the current heights up to float rounding.
+**********/
+class StandingQueryRegistry {
+public:
+	StandingQueryRegistry(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight, int tileSize = 32);
+
+	/*********
+	Register a line and return its id, the ids count up from 0. Throws std::out_of_range if an endpoint is outside of the image.
+	**********/
+	std::size_t registerQuery(glm::ivec2 begin, glm::ivec2 end);
+
+	std::size_t getQueryCount() const;
+
+	float getDistance(std::size_t query) const;
+
+	const std::vector<unsigned char>& getHeightData() const;
+
+	/*********
+	Write a patch of patchWidth x patchHeight heights, row by row, into the height map with its first pixel at corner,
+	update the lines it affects and return their ids in ascending order.
+	Throws std::out_of_range if the patch does not fit into the image, and std::invalid_argument if patch has the wrong size.
+	**********/
+	std::vector<std::size_t> applyPatch(glm::ivec2 corner, int patchWidth, int patchHeight, const std::vector<unsigned char>& patch);
+
+	/*********
+	Number of voxels walked again by the last patch.
+	**********/
+	std::size_t getLastPatchVoxelCount() const;
+
+private:
+	struct Segment {
+		glm::ivec2 firstVoxel;
+		std::uint32_t firstStep;
+		std::uint32_t voxelCount;
+		float distance;
+	};
+
+	struct StandingQuery {
+		glm::ivec2 begin;
+		glm::ivec2 end;
+		glm::ivec2 step;
+		std::vector<std::uint64_t> stepsInX;
+		std::vector<Segment> segments;
+		double distance;
+	};
+
+	struct SegmentRef {
+		std::uint32_t query;
+		std::uint32_t segment;
+	};
+
+	float sumSegment(const StandingQuery& query, const Segment& segment) const;
+
+	std::vector<unsigned char> _heightdata;
+	int _imageWidth;
+	int _imageHeight;
+	float _pixelDistance;
+	float _pixelHeight;
+	int _tileSize;
+	glm::ivec2 _tileCount;
+	std::vector<StandingQuery> _queries;
+	std::vector<std::vector<SegmentRef>> _tileSegments;
+	std::vector<std::size_t> _patchStamps;
+	std::size_t _patchCount;
+	std::size_t _lastPatchVoxelCount;
+};
+
+
+#endif // !STANDING_QUERY_H
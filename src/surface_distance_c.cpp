@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <stdexcept>
+#include <vector>
+#include "surface_distance_c.h"
+#include "dataset.h"
+#include "distance.h"
+#include "slope_bounds.h"
+#include "thread_pool.h"
+
+
+static const std::size_t C_BLOCK_SIZE = 64;
+
+static const std::size_t C_MAX_READERS = 64;
+
+
+struct sd_dataset {
+	sd_dataset(std::vector<unsigned char> heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight, unsigned threadCount)
+		: handle(0, std::move(heightdata), imageWidth, imageHeight, pixelDistance, pixelHeight, C_MAX_READERS), pool(threadCount)
+	{
+	}
+
+	DatasetHandle handle;
+	ThreadPool pool;
+	std::mutex poolMutex;
+};
+
+
+// everything a batch task needs, so the task captures a single pointer and std::function keeps it without allocating
+struct BatchContext {
+	const HeightDataset* dataset;
+	const int32_t* endpoints;
+	std::size_t count;
+	float limit;
+	float* distances;
+	unsigned char* within;
+};
+
+
+static bool isInside(const HeightDataset& dataset, int32_t x, int32_t y) {
+	return x >= 0 && y >= 0 && x < dataset.getImageWidth() && y < dataset.getImageHeight();
+}
+
+
+static bool areEndpointsInside(const HeightDataset& dataset, const int32_t* endpoints, std::size_t count) {
+	for (std::size_t i = 0; i < 2 * count; ++i) {
+		if (!isInside(dataset, endpoints[2 * i], endpoints[2 * i + 1])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static std::vector<unsigned char> copyHeightData(const unsigned char* heightdata, int32_t imageWidth, int32_t imageHeight) {
+	if (!heightdata || imageWidth <= 0 || imageHeight <= 0) {
+		throw std::invalid_argument("the height data must cover the image");
+	}
+
+	return std::vector<unsigned char>(heightdata, heightdata + static_cast<std::size_t>(imageWidth) * imageHeight);
+}
+
+
+template<typename Call>
+static sd_status callSafely(Call&& call) {
+	try {
+		return call();
+	}
+	catch (const std::invalid_argument&) {
+		return SD_ERROR_INVALID_ARGUMENT;
+	}
+	catch (const std::out_of_range&) {
+		return SD_ERROR_OUT_OF_RANGE;
+	}
+	catch (const std::bad_alloc&) {
+		return SD_ERROR_OUT_OF_MEMORY;
+	}
+	catch (...) {
+		return SD_ERROR_INTERNAL;
+	}
+}
+
+
+// runs call(pinned dataset) on a reader slot of its own, as the calling thread is not known in advance
+template<typename Call>
+static sd_status callPinned(sd_dataset* dataset, Call&& call) {
+	if (!dataset) {
+		return SD_ERROR_INVALID_ARGUMENT;
+	}
+
+	return callSafely([&]() {
+		bool registered = false;
+		try {
+			DatasetReader reader = dataset->handle.registerReader();
+			registered = true;
+			DatasetPin pin = reader.pin();
+			return call(*pin);
+		}
+		catch (const std::runtime_error&) {
+			if (!registered) {
+				return SD_ERROR_BUSY;
+			}
+
+			throw;
+		}
+	});
+}
+
+
+// batches take turns on the pool, and one that finds it taken walks its blocks on the calling thread instead of waiting for it
+template<typename Task>
+static void runBlocks(sd_dataset* dataset, std::size_t count, const Task& task) {
+	std::size_t blockCount = (count + C_BLOCK_SIZE - 1) / C_BLOCK_SIZE;
+	std::unique_lock<std::mutex> lock(dataset->poolMutex, std::try_to_lock);
+	if (lock.owns_lock()) {
+		dataset->pool.parallelFor(blockCount, task);
+		return;
+	}
+
+	for (std::size_t block = 0; block < blockCount; ++block) {
+		task(block);
+	}
+}
+
+
+extern "C" {
+
+
+const char* sd_status_message(sd_status status) {
+	switch (status) {
+	case SD_OK:
+		return "ok";
+	case SD_ERROR_INVALID_ARGUMENT:
+		return "invalid argument";
+	case SD_ERROR_OUT_OF_RANGE:
+		return "pixel outside the image";
+	case SD_ERROR_OUT_OF_MEMORY:
+		return "out of memory";
+	case SD_ERROR_BUSY:
+		return "too many concurrent calls on the dataset";
+	case SD_ERROR_INTERNAL:
+		return "internal error";
+	}
+
+	return "unknown status";
+}
+
+
+sd_status sd_dataset_create(const unsigned char* heightdata, int32_t imageWidth, int32_t imageHeight, float pixelDistance, float pixelHeight,
+	uint32_t threadCount, sd_dataset** dataset)
+{
+	if (!dataset) {
+		return SD_ERROR_INVALID_ARGUMENT;
+	}
+
+	*dataset = nullptr;
+	return callSafely([&]() {
+		*dataset = new sd_dataset(copyHeightData(heightdata, imageWidth, imageHeight), imageWidth, imageHeight, pixelDistance, pixelHeight, threadCount);
+		return SD_OK;
+	});
+}
+
+
+void sd_dataset_destroy(sd_dataset* dataset) {
+	delete dataset;
+}
+
+
+sd_status sd_dataset_publish(sd_dataset* dataset, const unsigned char* heightdata, int32_t imageWidth, int32_t imageHeight,
+	float pixelDistance, float pixelHeight, uint32_t* version)
+{
+	if (!dataset) {
+		return SD_ERROR_INVALID_ARGUMENT;
+	}
+
+	return callSafely([&]() {
+		uint32_t published = dataset->handle.publish(copyHeightData(heightdata, imageWidth, imageHeight), imageWidth, imageHeight, pixelDistance, pixelHeight);
+		if (version) {
+			*version = published;
+		}
+
+		return SD_OK;
+	});
+}
+
+
+sd_status sd_dataset_version(const sd_dataset* dataset, uint32_t* version) {
+	if (!dataset || !version) {
+		return SD_ERROR_INVALID_ARGUMENT;
+	}
+
+	*version = dataset->handle.getVersion();
+	return SD_OK;
+}
+
+
+sd_status sd_surface_distance(sd_dataset* dataset, int32_t beginX, int32_t beginY, int32_t endX, int32_t endY, float* distance) {
+	if (!distance) {
+		return SD_ERROR_INVALID_ARGUMENT;
+	}
+
+	return callPinned(dataset, [&](const HeightDataset& pinned) {
+		if (!isInside(pinned, beginX, beginY) || !isInside(pinned, endX, endY)) {
+			return SD_ERROR_OUT_OF_RANGE;
+		}
+
+		*distance = pinned.calcSurfaceDistance(glm::ivec2(beginX, beginY), glm::ivec2(endX, endY));
+		return SD_OK;
+	});
+}
+
+
+sd_status sd_surface_distances(sd_dataset* dataset, const int32_t* endpoints, size_t count, float* distances) {
+	if (count > 0 && (!endpoints || !distances)) {
+		return SD_ERROR_INVALID_ARGUMENT;
+	}
+
+	return callPinned(dataset, [&](const HeightDataset& pinned) {
+		if (!areEndpointsInside(pinned, endpoints, count)) {
+			return SD_ERROR_OUT_OF_RANGE;
+		}
+
+		BatchContext context{ &pinned, endpoints, count, 0.0f, distances, nullptr };
+		const BatchContext* shared = &context;
+		runBlocks(dataset, count, [shared](std::size_t block) {
+			const HeightDataset& heights = *shared->dataset;
+			for (std::size_t i = block * C_BLOCK_SIZE; i < std::min((block + 1) * C_BLOCK_SIZE, shared->count); ++i) {
+				const int32_t* line = shared->endpoints + 4 * i;
+				shared->distances[i] = heights.calcSurfaceDistance(glm::ivec2(line[0], line[1]), glm::ivec2(line[2], line[3]));
+			}
+		});
+
+		return SD_OK;
+	});
+}
+
+
+sd_status sd_surface_distances_within(sd_dataset* dataset, const int32_t* endpoints, size_t count, float limit, unsigned char* within) {
+	if (count > 0 && (!endpoints || !within)) {
+		return SD_ERROR_INVALID_ARGUMENT;
+	}
+
+	return callPinned(dataset, [&](const HeightDataset& pinned) {
+		if (!areEndpointsInside(pinned, endpoints, count)) {
+			return SD_ERROR_OUT_OF_RANGE;
+		}
+
+		BatchContext context{ &pinned, endpoints, count, limit, nullptr, within };
+		const BatchContext* shared = &context;
+		runBlocks(dataset, count, [shared](std::size_t block) {
+			const HeightDataset& heights = *shared->dataset;
+			for (std::size_t i = block * C_BLOCK_SIZE; i < std::min((block + 1) * C_BLOCK_SIZE, shared->count); ++i) {
+				const int32_t* line = shared->endpoints + 4 * i;
+				shared->within[i] = isSurfaceDistanceWithin(glm::ivec2(line[0], line[1]), glm::ivec2(line[2], line[3]), shared->limit,
+					heights.getHeightData(), heights.getImageWidth(), heights.getImageHeight(), heights.getPixelDistance(), heights.getPixelHeight()) ? 1 : 0;
+			}
+		});
+
+		return SD_OK;
+	});
+}
+
+
+}
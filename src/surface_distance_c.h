@@ -0,0 +1,96 @@
+#ifndef SURFACE_DISTANCE_C_H
+#define SURFACE_DISTANCE_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(SURFACE_DISTANCE_BUILD_SHARED)
+#define SD_API __declspec(dllexport)
+#elif defined(SURFACE_DISTANCE_USE_SHARED)
+#define SD_API __declspec(dllimport)
+#else
+#define SD_API
+#endif
+#else
+#define SD_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*********
+C interface of the surface distance library, for bindings in other languages.
+All functions return a status instead of throwing, and the batch functions read and write arrays owned by the caller
+without copying or allocating. Endpoints are pixels given as (x, y) pairs of int32_t.
+**********/
+typedef enum sd_status {
+	SD_OK = 0,
+	SD_ERROR_INVALID_ARGUMENT = 1,
+	SD_ERROR_OUT_OF_RANGE = 2,
+	SD_ERROR_OUT_OF_MEMORY = 3,
+	SD_ERROR_BUSY = 4,
+	SD_ERROR_INTERNAL = 5
+} sd_status;
+
+
+/*********
+A height map shared by all threads of the caller. It can be replaced with sd_dataset_publish while queries run;
+every query sees either the old or the new height map as a whole.
+At most 64 calls may run on the same dataset at once, further calls return SD_ERROR_BUSY.
+The threads of the dataset serve one batch call at a time. A batch call that comes while they are taken computes its lines
+on the calling thread instead of waiting, so concurrent batch calls do not queue behind each other.
+**********/
+typedef struct sd_dataset sd_dataset;
+
+
+SD_API const char* sd_status_message(sd_status status);
+
+
+/*********
+Copy imageWidth * imageHeight heights row by row into a new dataset whose batch functions use threadCount threads (0 for one per core).
+**********/
+SD_API sd_status sd_dataset_create(const unsigned char* heightdata, int32_t imageWidth, int32_t imageHeight, float pixelDistance, float pixelHeight,
+	uint32_t threadCount, sd_dataset** dataset);
+
+
+/*********
+Must not be called while another call on the dataset runs.
+**********/
+SD_API void sd_dataset_destroy(sd_dataset* dataset);
+
+
+/*********
+Replace the height map of the dataset. version, if not NULL, receives the version number of the new height map.
+**********/
+SD_API sd_status sd_dataset_publish(sd_dataset* dataset, const unsigned char* heightdata, int32_t imageWidth, int32_t imageHeight,
+	float pixelDistance, float pixelHeight, uint32_t* version);
+
+
+SD_API sd_status sd_dataset_version(const sd_dataset* dataset, uint32_t* version);
+
+
+SD_API sd_status sd_surface_distance(sd_dataset* dataset, int32_t beginX, int32_t beginY, int32_t endX, int32_t endY, float* distance);
+
+
+/*********
+endpoints holds count lines as (beginX, beginY, endX, endY). distances[i] receives the surface distance of line i.
+Nothing is written if an endpoint is outside the image.
+**********/
+SD_API sd_status sd_surface_distances(sd_dataset* dataset, const int32_t* endpoints, size_t count, float* distances);
+
+
+/*********
+Same lines as sd_surface_distances. within[i] receives 1 if the surface distance of line i is at most limit and 0 otherwise.
+Lines stop walking as soon as they exceed limit.
+**********/
+SD_API sd_status sd_surface_distances_within(sd_dataset* dataset, const int32_t* endpoints, size_t count, float limit, unsigned char* within);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !SURFACE_DISTANCE_C_H
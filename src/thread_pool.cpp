@@ -0,0 +1,118 @@
+#include <algorithm>
+#include "thread_pool.h"
+
+
+ThreadPool::ThreadPool(unsigned threadCount)
+	: _task{nullptr}, _count{0}, _next{0}, _active{0}, _generation{0}, _stop{false}
+{
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// the calling thread always takes part in parallelFor, so it counts as one of the threads
+	_workers.reserve(threadCount - 1);
+	for (unsigned i = 1; i < threadCount; ++i) {
+		_workers.emplace_back([this]() { workerLoop(); });
+	}
+}
+
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_wake.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+
+unsigned ThreadPool::getThreadCount() const {
+	return static_cast<unsigned>(_workers.size()) + 1;
+}
+
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& task) {
+	std::lock_guard<std::mutex> submitLock(_submitMutex);
+	if (_workers.empty() || count <= 1) {
+		for (std::size_t i = 0; i < count; ++i) {
+			task(i);
+		}
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_task = &task;
+		_count = count;
+		_next = 0;
+		_active = _workers.size();
+		_error = nullptr;
+		++_generation;
+	}
+
+	_wake.notify_all();
+	runTasks();
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done.wait(lock, [this]() { return _active == 0; });
+		_task = nullptr;
+		std::swap(error, _error);
+	}
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+
+void ThreadPool::workerLoop() {
+	std::uint64_t generation = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wake.wait(lock, [&]() { return _stop || _generation != generation; });
+			if (_stop) {
+				return;
+			}
+
+			generation = _generation;
+		}
+
+		runTasks();
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (--_active == 0) {
+			_done.notify_all();
+		}
+	}
+}
+
+
+void ThreadPool::runTasks() {
+	for (;;) {
+		std::size_t i = _next.fetch_add(1);
+		if (i >= _count) {
+			return;
+		}
+
+		try {
+			(*_task)(i);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_error) {
+				_error = std::current_exception();
+			}
+
+			// skip the remaining indices
+			_next = _count;
+		}
+	}
+}
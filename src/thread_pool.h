@@ -0,0 +1,55 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+
+/*********
+A fixed set of worker threads used by the batch and raster functions.
+parallelFor() hands out the indices [0, count) to the workers and the calling thread, and returns once all of them are done.
+The first exception thrown by a task is rethrown in the calling thread.
+parallelFor() must not be called from inside one of its own tasks.
+**********/
+class ThreadPool {
+public:
+	explicit ThreadPool(unsigned threadCount = 0);
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned getThreadCount() const;
+
+	void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task);
+
+private:
+	void workerLoop();
+
+	void runTasks();
+
+	std::vector<std::thread> _workers;
+	std::mutex _submitMutex;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _done;
+	const std::function<void(std::size_t)>* _task;
+	std::size_t _count;
+	std::atomic<std::size_t> _next;
+	std::size_t _active;
+	std::uint64_t _generation;
+	bool _stop;
+	std::exception_ptr _error;
+};
+
+
+#endif // !THREAD_POOL_H
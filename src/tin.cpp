@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include "tin.h"
+
+
+/*********
+Height of a point of the square (in pixel units) on its lower (u + v <= 1) or upper triangle, not scaled by pixelHeight.
+**********/
+static float interpolateSquare(glm::vec2 point, const TinSquare& square, bool lower, const std::vector<unsigned char>& heightdata, int imageWidth) {
+	glm::ivec2 corner = square.corner;
+	float h00 = heightdata[corner.y * imageWidth + corner.x];
+	float h10 = heightdata[corner.y * imageWidth + corner.x + square.size];
+	float h01 = heightdata[(corner.y + square.size) * imageWidth + corner.x];
+	float h11 = heightdata[(corner.y + square.size) * imageWidth + corner.x + square.size];
+	float u = (point.x - corner.x) / square.size;
+	float v = (point.y - corner.y) / square.size;
+	if (lower) {
+		return h00 + u * (h10 - h00) + v * (h01 - h00);
+	}
+
+	return h11 + (1.0f - u) * (h01 - h11) + (1.0f - v) * (h10 - h11);
+}
+
+
+/*********
+Split the part [enterRay, exitRay] of the line that lies in the square at the square's diagonal,
+and call visitor(fromRay, toRay, lower) for the part in each triangle.
+**********/
+template<typename Visitor>
+static void splitAtDiagonal(glm::ivec2 begin, glm::vec2 lineVector, const TinSquare& square, float enterRay, float exitRay, Visitor&& visitor) {
+	// signed offset from the diagonal, negative on the lower triangle
+	auto diagonalOffset = [&](float ray) {
+		glm::vec2 point = static_cast<glm::vec2>(begin) + ray * lineVector - static_cast<glm::vec2>(square.corner);
+		return point.x + point.y - square.size;
+	};
+
+	float enterOffset = diagonalOffset(enterRay);
+	float exitOffset = diagonalOffset(exitRay);
+	if ((enterOffset < 0.0f && exitOffset > 0.0f) || (enterOffset > 0.0f && exitOffset < 0.0f)) {
+		float splitRay = enterRay + (exitRay - enterRay) * enterOffset / (enterOffset - exitOffset);
+		visitor(enterRay, splitRay, enterOffset < 0.0f);
+		visitor(splitRay, exitRay, exitOffset < 0.0f);
+		return;
+	}
+
+	visitor(enterRay, exitRay, enterOffset + exitOffset <= 0.0f);
+}
+
+
+/*********
+Walk the line through the squares of the network and call visitor(square, enterRay, exitRay) for every square it passes.
+It starts in the voxel calcSurfaceDistance starts in and leaves the grid the same way.
+Where the line leaves a square and which voxel is next is found exactly with integers:
+the line reaches the side at coordinate c of an axis at ray (c - begin) / (end - begin).
+**********/
+template<typename Visitor>
+static void walkTin(glm::ivec2 begin, glm::ivec2 end, const SimplifiedTin& tin, Visitor&& visitor) {
+	glm::ivec2 delta = end - begin;
+	if (delta.x == 0 && delta.y == 0) {
+		return;
+	}
+
+	glm::ivec2 step{ delta.x < 0 ? -1 : 1, delta.y < 0 ? -1 : 1 };
+	long long length[] = { std::abs(delta.x), std::abs(delta.y) };
+	glm::ivec2 voxel{ delta.x < 0 ? begin.x - 1 : begin.x, delta.y < 0 ? begin.y - 1 : begin.y };
+	float enterRay = 0.0f;
+	while (voxel.x >= 0 && voxel.x < tin.getImageWidth() - 1 && voxel.y >= 0 && voxel.y < tin.getImageHeight() - 1) {
+		TinSquare square = tin.findSquare(voxel);
+
+		// for each axis the side the line leaves through and how far ahead it is, the ray being ahead / length
+		int side[2];
+		long long ahead[2];
+		for (int axis = 0; axis < 2; ++axis) {
+			side[axis] = step[axis] > 0 ? square.corner[axis] + square.size : square.corner[axis];
+			ahead[axis] = static_cast<long long>(side[axis] - begin[axis]) * step[axis];
+		}
+
+		int exitAxis;
+		bool exitsBoth = false;
+		if (delta.x == 0) {
+			exitAxis = 1;
+		}
+		else if (delta.y == 0) {
+			exitAxis = 0;
+		}
+		else {
+			long long order = ahead[0] * length[1] - ahead[1] * length[0];
+			exitAxis = order <= 0 ? 0 : 1;
+			exitsBoth = order == 0;
+		}
+
+		bool reachesEnd = ahead[exitAxis] >= length[exitAxis];
+		float exitRay = reachesEnd ? 1.0f : static_cast<float>(ahead[exitAxis]) / static_cast<float>(length[exitAxis]);
+		visitor(square, enterRay, exitRay);
+		if (reachesEnd) {
+			return;
+		}
+
+		for (int axis = 0; axis < 2; ++axis) {
+			if (axis == exitAxis || exitsBoth) {
+				voxel[axis] = step[axis] > 0 ? side[axis] : side[axis] - 1;
+				continue;
+			}
+
+			// the coordinate where the line leaves, as numerator / length[exitAxis], rounded down to the voxel it continues in
+			long long numerator = static_cast<long long>(begin[axis]) * length[exitAxis] + static_cast<long long>(delta[axis]) * ahead[exitAxis];
+			long long coordinate = numerator / length[exitAxis];
+			if (numerator % length[exitAxis] == 0 && delta[axis] < 0) {
+				--coordinate;
+			}
+
+			voxel[axis] = static_cast<int>(coordinate);
+		}
+
+		enterRay = exitRay;
+	}
+}
+
+
+SimplifiedTin::SimplifiedTin(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelHeight, float tolerance, ThreadPool& pool)
+	: _imageWidth{imageWidth}, _imageHeight{imageHeight}, _triangleCount{0}
+{
+	int voxelWidth = std::max(imageWidth - 1, 0);
+	int voxelHeight = std::max(imageHeight - 1, 0);
+	_voxelLevels.assign(voxelWidth * voxelHeight, 0);
+
+	// levels go from small to large blocks, so the largest accepted block is written last
+	for (int level = 1; (1 << level) <= std::min(voxelWidth, voxelHeight); ++level) {
+		int size = 1 << level;
+		int blockWidth = voxelWidth >> level;
+		int blockHeight = voxelHeight >> level;
+		pool.parallelFor(blockHeight, [&](std::size_t blockY) {
+			for (int blockX = 0; blockX < blockWidth; ++blockX) {
+				glm::ivec2 corner = glm::ivec2(blockX, static_cast<int>(blockY)) * size;
+				int h00 = heightdata[corner.y * imageWidth + corner.x];
+				int h10 = heightdata[corner.y * imageWidth + corner.x + size];
+				int h01 = heightdata[(corner.y + size) * imageWidth + corner.x];
+				int h11 = heightdata[(corner.y + size) * imageWidth + corner.x + size];
+
+				// heights scaled by size keep the triangles in integers, so tolerance 0 is checked exactly
+				int maxDeviation = 0;
+				for (int v = 0; v <= size; ++v) {
+					for (int u = 0; u <= size; ++u) {
+						int triangle = u + v <= size ?
+							size * h00 + u * (h10 - h00) + v * (h01 - h00) :
+							size * h11 + (size - u) * (h01 - h11) + (size - v) * (h10 - h11);
+						int sample = size * heightdata[(corner.y + v) * imageWidth + corner.x + u];
+						maxDeviation = std::max(maxDeviation, std::abs(sample - triangle));
+					}
+				}
+
+				if (maxDeviation * pixelHeight > tolerance * size) {
+					continue;
+				}
+
+				for (int y = corner.y; y < corner.y + size; ++y) {
+					std::fill_n(&_voxelLevels[y * voxelWidth + corner.x], size, static_cast<unsigned char>(level));
+				}
+			}
+		});
+	}
+
+	for (int y = 0; y < voxelHeight; ++y) {
+		for (int x = 0; x < voxelWidth; ++x) {
+			if (findSquare(glm::ivec2(x, y)).corner == glm::ivec2(x, y)) {
+				_triangleCount += 2;
+			}
+		}
+	}
+}
+
+
+TinSquare SimplifiedTin::findSquare(glm::ivec2 voxel) const {
+	int level = _voxelLevels[voxel.y * (_imageWidth - 1) + voxel.x];
+	return TinSquare{ (voxel >> level) << level, 1 << level };
+}
+
+
+std::size_t SimplifiedTin::getTriangleCount() const {
+	return _triangleCount;
+}
+
+
+int SimplifiedTin::getImageWidth() const {
+	return _imageWidth;
+}
+
+
+int SimplifiedTin::getImageHeight() const {
+	return _imageHeight;
+}
+
+
+float calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const SimplifiedTin& tin)
+{
+	auto isInside = [&](glm::ivec2 pixel) {
+		return pixel.x >= 0 && pixel.y >= 0 && pixel.x < imageWidth && pixel.y < imageHeight;
+	};
+
+	if (!isInside(begin) || !isInside(end)) {
+		throw std::out_of_range("the line is outside of the image");
+	}
+
+	glm::vec2 lineVector = static_cast<glm::vec2>(end - begin);
+	float distance = 0.0f;
+	walkTin(begin, end, tin, [&](const TinSquare& square, float enterRay, float exitRay) {
+		splitAtDiagonal(begin, lineVector, square, enterRay, exitRay, [&](float fromRay, float toRay, bool lower) {
+			glm::vec2 from = static_cast<glm::vec2>(begin) + fromRay * lineVector;
+			glm::vec2 to = static_cast<glm::vec2>(begin) + toRay * lineVector;
+			glm::vec3 fromPosition(from * pixelDistance, interpolateSquare(from, square, lower, heightdata, imageWidth) * pixelHeight);
+			glm::vec3 toPosition(to * pixelDistance, interpolateSquare(to, square, lower, heightdata, imageWidth) * pixelHeight);
+			distance += glm::distance(fromPosition, toPosition);
+		});
+	});
+
+	return distance;
+}
+
+
+std::size_t countCrossedTriangles(glm::ivec2 begin, glm::ivec2 end, const SimplifiedTin& tin) {
+	glm::vec2 lineVector = static_cast<glm::vec2>(end - begin);
+	std::size_t count = 0;
+	walkTin(begin, end, tin, [&](const TinSquare& square, float enterRay, float exitRay) {
+		splitAtDiagonal(begin, lineVector, square, enterRay, exitRay, [&](float fromRay, float toRay, bool) {
+			count += toRay > fromRay ? 1 : 0;
+		});
+	});
+
+	return count;
+}
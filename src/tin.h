@@ -0,0 +1,68 @@
+#ifndef TIN_H
+#define TIN_H
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+#include "thread_pool.h"
+
+
+/*********
+A square of the network, split into two triangles by its diagonal from (corner.x + size, corner.y) to (corner.x, corner.y + size),
+the same way every voxel of the height map is split.
+**********/
+struct TinSquare {
+	glm::ivec2 corner;
+	int size;
+};
+
+
+/*********
+Triangulated irregular network that replaces blocks of 2^k x 2^k voxels by the two triangles of the block.
+A block is used when no height sample inside it is more than tolerance meters above or below its two triangles,
+and the largest such block is kept for every voxel. Both surfaces are linear on the voxel triangles, so checking the samples bounds the whole block.
+With tolerance 0 only blocks on which the surface is exactly the two triangles are merged, which keeps the surface of calcSurfaceDistance.
+Blocks have to lie fully inside the grid. Neighbouring blocks of different size can leave a crack of at most tolerance where they meet.
+The blocks of every level are checked in parallel over the pool.
+**********/
+class SimplifiedTin {
+public:
+	SimplifiedTin(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelHeight, float tolerance, ThreadPool& pool);
+
+	/*********
+	The square of the network that contains the voxel.
+	**********/
+	TinSquare findSquare(glm::ivec2 voxel) const;
+
+	std::size_t getTriangleCount() const;
+
+	int getImageWidth() const;
+
+	int getImageHeight() const;
+
+private:
+	int _imageWidth;
+	int _imageHeight;
+	std::vector<unsigned char> _voxelLevels;
+	std::size_t _triangleCount;
+};
+
+
+/*********
+Find the surface distance by walking the line through the squares of the network, one square at a time.
+The next square is found with integer arithmetic from where the line leaves the current one, and each triangle adds one straight piece.
+Lines on the last row or column give 0 like calcSurfaceDistance. With tolerance 0 the result matches calcSurfaceDistance up to float rounding,
+otherwise it is the length of the line over a surface that is never more than tolerance above or below the original one.
+The network must have been built from the same height data. Throws std::out_of_range if an endpoint is outside of the image.
+**********/
+float calcSurfaceDistance(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelDistance, float pixelHeight,
+	const SimplifiedTin& tin);
+
+
+/*********
+Number of triangles the walk of the line crosses with a positive length.
+**********/
+std::size_t countCrossedTriangles(glm::ivec2 begin, glm::ivec2 end, const SimplifiedTin& tin);
+
+
+#endif // !TIN_H
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <stdexcept>
+#include "visibility.h"
+#include "distance.h"
+
+
+// the surface has to rise this many meters above the sight line to block it, so a flat surface does not block itself through rounding
+static const float SIGHT_EPSILON = 1e-3f;
+
+
+struct SightLine {
+	float eye;
+	float rise;
+
+	float height(float ray) const {
+		return eye + ray * rise;
+	}
+};
+
+
+static SightLine makeSightLine(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight, float pixelHeight,
+	float observerHeight, float targetHeight)
+{
+	auto isInside = [&](glm::ivec2 pixel) {
+		return pixel.x >= 0 && pixel.y >= 0 && pixel.x < imageWidth && pixel.y < imageHeight;
+	};
+
+	if (!isInside(begin) || !isInside(end)) {
+		throw std::out_of_range("the line is outside of the image");
+	}
+
+	float eye = heightdata[begin.y * imageWidth + begin.x] * pixelHeight + observerHeight;
+	float target = heightdata[end.y * imageWidth + end.x] * pixelHeight + targetHeight;
+	return SightLine{ eye, target - eye };
+}
+
+
+/*********
+Check whether the surface between two consecutive crossings rises above the sight line.
+If it does, ray receives the parameter where it first does.
+**********/
+static bool blocksSightLine(const SightLine& sight, const SurfacePoint& from, const SurfacePoint& to, float& ray) {
+	float aboveFrom = from.position.z - sight.height(from.ray);
+	float aboveTo = to.position.z - sight.height(to.ray);
+	if (aboveFrom > SIGHT_EPSILON) {
+		ray = from.ray;
+		return true;
+	}
+
+	if (aboveTo > SIGHT_EPSILON) {
+		ray = from.ray + (to.ray - from.ray) * (-aboveFrom / (aboveTo - aboveFrom));
+		return true;
+	}
+
+	return false;
+}
+
+
+/*********
+Find the coarsest pyramid level whose block around the voxel stays below the sight line, or -1 if there is none.
+The block can only be seen from the part of the line its corners project on, so the lowest sight height over that part bounds it.
+**********/
+static int findSkippableLevel(const MaxHeightPyramid& pyramid, glm::ivec2 voxel, glm::ivec2 begin, glm::vec2 lineVector, float lineLengthSquared,
+	const SightLine& sight, float pixelHeight)
+{
+	for (int level = pyramid.getLevelCount() - 1; level >= 0; --level) {
+		int size = 1 << level;
+		glm::ivec2 low = (voxel >> level) * size;
+		glm::ivec2 corners[] = { low, low + glm::ivec2(size, 0), low + glm::ivec2(0, size), low + glm::ivec2(size, size) };
+
+		float rayMin = 1.0f;
+		float rayMax = 0.0f;
+		for (glm::ivec2 corner : corners) {
+			float ray = glm::dot(static_cast<glm::vec2>(corner - begin), lineVector) / lineLengthSquared;
+			rayMin = std::min(rayMin, ray);
+			rayMax = std::max(rayMax, ray);
+		}
+
+		rayMin = glm::clamp(rayMin, 0.0f, 1.0f);
+		rayMax = glm::clamp(rayMax, 0.0f, 1.0f);
+		float lowestSight = std::min(sight.height(rayMin), sight.height(rayMax));
+		if (pyramid.getMaxHeight(level, voxel) * pixelHeight <= lowestSight) {
+			return level;
+		}
+	}
+
+	return -1;
+}
+
+
+MaxHeightPyramid::MaxHeightPyramid(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight) {
+	glm::ivec2 size{ std::max(imageWidth - 1, 1), std::max(imageHeight - 1, 1) };
+	std::vector<unsigned char> level(size.x * size.y);
+	for (int y = 0; y < size.y; ++y) {
+		for (int x = 0; x < size.x; ++x) {
+			int x1 = std::min(x + 1, imageWidth - 1);
+			int y1 = std::min(y + 1, imageHeight - 1);
+			level[y * size.x + x] = std::max(
+				std::max(heightdata[y * imageWidth + x], heightdata[y * imageWidth + x1]),
+				std::max(heightdata[y1 * imageWidth + x], heightdata[y1 * imageWidth + x1]));
+		}
+	}
+
+	_levels.push_back(std::move(level));
+	_sizes.push_back(size);
+	while (size.x > 1 || size.y > 1) {
+		glm::ivec2 coarseSize = (size + 1) / 2;
+		const std::vector<unsigned char>& fine = _levels.back();
+		std::vector<unsigned char> coarse(coarseSize.x * coarseSize.y, 0);
+		for (int y = 0; y < size.y; ++y) {
+			for (int x = 0; x < size.x; ++x) {
+				unsigned char& maxHeight = coarse[(y / 2) * coarseSize.x + x / 2];
+				maxHeight = std::max(maxHeight, fine[y * size.x + x]);
+			}
+		}
+
+		_levels.push_back(std::move(coarse));
+		_sizes.push_back(coarseSize);
+		size = coarseSize;
+	}
+}
+
+
+int MaxHeightPyramid::getLevelCount() const {
+	return static_cast<int>(_levels.size());
+}
+
+
+unsigned char MaxHeightPyramid::getMaxHeight(int level, glm::ivec2 voxel) const {
+	glm::ivec2 size = _sizes[level];
+	glm::ivec2 block = glm::clamp(voxel >> level, glm::ivec2(0), size - 1);
+	return _levels[level][block.y * size.x + block.x];
+}
+
+
+VisibilityResult calcSurfaceDistanceAndVisibility(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight,
+	float pixelDistance, float pixelHeight, float observerHeight, float targetHeight)
+{
+	SightLine sight = makeSightLine(begin, end, heightdata, imageWidth, imageHeight, pixelHeight, observerHeight, targetHeight);
+	VisibilityResult result{ 0.0f, true, glm::vec2(0.0f), 0.0f };
+	walkSurface(begin, end, heightdata, imageWidth, imageHeight, pixelDistance, pixelHeight,
+		[&](const SurfacePoint& from, const SurfacePoint& to) {
+			result.distance += glm::distance(from.position, to.position);
+
+			float ray;
+			if (result.visible && blocksSightLine(sight, from, to, ray)) {
+				result.visible = false;
+				result.blockedAt = static_cast<glm::vec2>(begin) + ray * static_cast<glm::vec2>(end - begin);
+				result.blockedPlanarDistance = ray * glm::length(static_cast<glm::vec2>(end - begin)) * pixelDistance;
+			}
+
+			return true;
+		});
+
+	return result;
+}
+
+
+bool isVisible(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight,
+	float pixelDistance, float pixelHeight, float observerHeight, float targetHeight, const MaxHeightPyramid* pyramid, std::size_t* voxelCount)
+{
+	SightLine sight = makeSightLine(begin, end, heightdata, imageWidth, imageHeight, pixelHeight, observerHeight, targetHeight);
+	glm::vec2 lineVector = static_cast<glm::vec2>(end - begin);
+	float lineLengthSquared = glm::dot(lineVector, lineVector);
+	if (lineLengthSquared == 0.0f) {
+		return true;
+	}
+
+	VoxelTraversal traversal(begin, end, imageWidth - 1, imageHeight - 1);
+	SurfacePoint points[5];
+	glm::ivec2 voxel;
+	while (traversal.next(voxel)) {
+		if (voxelCount) {
+			++*voxelCount;
+		}
+
+		int level = pyramid ? findSkippableLevel(*pyramid, voxel, begin, lineVector, lineLengthSquared, sight, pixelHeight) : -1;
+		if (level >= 0) {
+			// the traversal goes on right after the block, so none of its other voxels is visited
+			int size = 1 << level;
+			glm::ivec2 next;
+			if (!findVoxelAfterBlock(begin, end, (voxel >> level) * size, glm::ivec2(size), next)) {
+				break;
+			}
+
+			traversal = VoxelTraversal(begin, end, imageWidth - 1, imageHeight - 1, next);
+			continue;
+		}
+
+		int count = intersectLineAndVoxel(begin, end, voxel, heightdata, imageWidth, pixelDistance, pixelHeight, points);
+		for (int i = 0; i < count - 1; ++i) {
+			float ray;
+			if (blocksSightLine(sight, points[i], points[i + 1], ray)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
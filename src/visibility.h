@@ -0,0 +1,64 @@
+#ifndef VISIBILITY_H
+#define VISIBILITY_H
+
+#include <cstddef>
+#include <vector>
+#include "glm/glm.hpp"
+
+
+/*********
+Maximum height of the voxel blocks of a height map, one level per power of two.
+Level 0 holds the maximum of the 4 corners of every voxel, level k the maximum over blocks of 2^k x 2^k voxels.
+**********/
+class MaxHeightPyramid {
+public:
+	MaxHeightPyramid(const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight);
+
+	int getLevelCount() const;
+
+	/*********
+	Maximum height (not scaled by pixelHeight) of the block at the given level that contains the voxel.
+	**********/
+	unsigned char getMaxHeight(int level, glm::ivec2 voxel) const;
+
+private:
+	std::vector<std::vector<unsigned char>> _levels;
+	std::vector<glm::ivec2> _sizes;
+};
+
+
+/*********
+Result of a line-of-sight query. If the endpoints cannot see each other, blockedAt is the first point (in pixel units)
+where the surface rises above the sight line and blockedPlanarDistance its distance from begin in meter.
+**********/
+struct VisibilityResult {
+	float distance;
+	bool visible;
+	glm::vec2 blockedAt;
+	float blockedPlanarDistance;
+};
+
+
+/*********
+Find the surface distance and whether the endpoints can see each other in one walk over the surface.
+The sight line runs from observerHeight meters above the surface at begin to targetHeight meters above the surface at end,
+and the surface is the same triangulated surface calcSurfaceDistance walks. The surface is linear between two crossings,
+so comparing it with the sight line at the crossings is exact. distance is exactly calcSurfaceDistance.
+Throws std::out_of_range if begin or end is outside of the image.
+**********/
+VisibilityResult calcSurfaceDistanceAndVisibility(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight,
+	float pixelDistance, float pixelHeight, float observerHeight = 0.0f, float targetHeight = 0.0f);
+
+
+/*********
+Only find out whether the endpoints can see each other. The walk stops at the first crossing that blocks the sight line.
+With a pyramid, the traversal jumps past blocks of voxels whose maximum height stays below the sight line over their whole extent,
+so none of their other voxels is visited. voxelCount, if given, is increased by the number of voxels visited.
+Throws std::out_of_range if begin or end is outside of the image.
+**********/
+bool isVisible(glm::ivec2 begin, glm::ivec2 end, const std::vector<unsigned char>& heightdata, int imageWidth, int imageHeight,
+	float pixelDistance, float pixelHeight, float observerHeight = 0.0f, float targetHeight = 0.0f, const MaxHeightPyramid* pyramid = nullptr,
+	std::size_t* voxelCount = nullptr);
+
+
+#endif // !VISIBILITY_H
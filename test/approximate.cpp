@@ -0,0 +1,53 @@
+#include <cmath>
+#include "catch.hpp"
+#include "distance.h"
+#include "approximate.h"
+
+
+TEST_CASE("Test approximate distance on a height pyramid", "[approximate]") {
+	const int size = 129;
+	std::vector<unsigned char> heights(size * size);
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			float wave = std::sin(x * 0.07f) * std::cos(y * 0.05f) * 40.0f + std::sin((x + y) * 0.31f) * 3.0f;
+			heights[y * size + x] = static_cast<unsigned char>(100.0f + wave);
+		}
+	}
+
+	HeightPyramid pyramid(heights, size, size, 30.0f, 1.0f);
+
+	SECTION("Levels halve the resolution") {
+		REQUIRE(pyramid.getLevelCount() == 8);
+		REQUIRE(pyramid.getLevel(1).imageWidth == 65);
+		REQUIRE(pyramid.getLevel(1).pixelDistance == 60.0f);
+		REQUIRE(pyramid.getLevel(7).imageWidth == 2);
+		REQUIRE(pyramid.getLevel(2).heightdata[3 * 33 + 5] == heights[12 * size + 20]);
+	}
+
+	SECTION("Zero tolerance is exact") {
+		glm::ivec2 begin{ 3, 7 };
+		glm::ivec2 end{ 120, 101 };
+		ApproximateDistance result = calcApproximateSurfaceDistance(begin, end, pyramid, 0.0f);
+		REQUIRE(result.level == 0);
+		REQUIRE(result.errorBound == 0.0f);
+		REQUIRE(result.distance == calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 1.0f));
+	}
+
+	SECTION("Error stays within the reported bound") {
+		const float tolerances[] = { 10.0f, 50.0f, 200.0f, 1000.0f };
+		int coarseCount = 0;
+		for (int i = 0; i < 300; ++i) {
+			glm::ivec2 begin{ (i * 37) % size, (i * 11) % size };
+			glm::ivec2 end{ (i * 71 + 13) % size, (i * 53 + 29) % size };
+			float exact = calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 1.0f);
+			for (float tolerance : tolerances) {
+				ApproximateDistance result = calcApproximateSurfaceDistance(begin, end, pyramid, tolerance);
+				REQUIRE(result.errorBound <= tolerance);
+				REQUIRE(std::abs(result.distance - exact) <= result.errorBound + exact * 1e-5f);
+				coarseCount += result.level > 0 ? 1 : 0;
+			}
+		}
+
+		REQUIRE(coarseCount > 0);
+	}
+}
@@ -0,0 +1,133 @@
+#include "catch.hpp"
+#include "distance.h"
+#include "batch.h"
+#include "axis_tables.h"
+
+
+TEST_CASE("Test axis and diagonal prefix tables", "[axis_tables]") {
+	const int width = 23;
+	const int height = 17;
+	std::vector<unsigned char> heights(width * height);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			heights[y * width + x] = static_cast<unsigned char>((x * 53 + y * 31 + x * y * 17) % 97);
+		}
+	}
+
+	ThreadPool pool(3);
+	AxisDistanceTables tables(heights, width, height, 30.0f, 11.0f, pool);
+
+	SECTION("Covered lines match calcSurfaceDistance") {
+		const glm::ivec2 directions[] = {
+			glm::ivec2(1, 0), glm::ivec2(-1, 0), glm::ivec2(0, 1), glm::ivec2(0, -1),
+			glm::ivec2(1, 1), glm::ivec2(-1, -1), glm::ivec2(1, -1), glm::ivec2(-1, 1)
+		};
+
+		int covered = 0;
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				for (glm::ivec2 direction : directions) {
+					for (int length = 1; length < 20; length += 3) {
+						glm::ivec2 begin{ x, y };
+						glm::ivec2 end = begin + direction * length;
+						if (end.x < 0 || end.x >= width || end.y < 0 || end.y >= height) {
+							continue;
+						}
+
+						float expect = calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f);
+						float distance = -1.0f;
+						if (tables.lookupSurfaceDistance(begin, end, distance)) {
+							REQUIRE(distance == Approx(expect).epsilon(1e-5));
+							++covered;
+						}
+						else {
+							REQUIRE(distance == -1.0f);
+						}
+
+						REQUIRE(calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f, tables) == Approx(expect).epsilon(1e-5));
+					}
+				}
+			}
+		}
+
+		REQUIRE(covered > 0);
+	}
+
+	SECTION("Other lines are not covered") {
+		float distance = -1.0f;
+		REQUIRE(!tables.lookupSurfaceDistance(glm::ivec2(0, 0), glm::ivec2(5, 3), distance));
+		REQUIRE(!tables.lookupSurfaceDistance(glm::ivec2(4, 4), glm::ivec2(4, 4), distance));
+		REQUIRE(!tables.lookupSurfaceDistance(glm::ivec2(2, height - 1), glm::ivec2(9, height - 1), distance));
+		REQUIRE(!tables.lookupSurfaceDistance(glm::ivec2(width - 1, 3), glm::ivec2(width - 1, 0), distance));
+		REQUIRE(!tables.lookupSurfaceDistance(glm::ivec2(-5, 3), glm::ivec2(10, 3), distance));
+		REQUIRE(!tables.lookupSurfaceDistance(glm::ivec2(3, 3), glm::ivec2(3, height + 4), distance));
+		REQUIRE(!tables.lookupSurfaceDistance(glm::ivec2(width, 0), glm::ivec2(0, width), distance));
+		REQUIRE(distance == -1.0f);
+
+		glm::ivec2 begin{ 0, 0 };
+		glm::ivec2 end{ 5, 3 };
+		REQUIRE(calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f, tables) == calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f));
+
+		// lines leaving the image fall back to calcSurfaceDistance
+		begin = glm::ivec2(-5, 3);
+		end = glm::ivec2(10, 3);
+		REQUIRE(calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f, tables) == calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f));
+	}
+
+	SECTION("Long lines cross the blocks of the tables") {
+		const int longWidth = 300;
+		const int longHeight = 170;
+		std::vector<unsigned char> longHeights(longWidth * longHeight);
+		for (int y = 0; y < longHeight; ++y) {
+			for (int x = 0; x < longWidth; ++x) {
+				longHeights[y * longWidth + x] = static_cast<unsigned char>((x * 53 + y * 31 + x * y * 17) % 97);
+			}
+		}
+
+		AxisDistanceTables longTables(longHeights, longWidth, longHeight, 30.0f, 11.0f, pool);
+		const glm::ivec2 lines[][2] = {
+			{ glm::ivec2(0, 7), glm::ivec2(299, 7) }, { glm::ivec2(250, 100), glm::ivec2(3, 100) },
+			{ glm::ivec2(5, 0), glm::ivec2(5, 169) }, { glm::ivec2(120, 150), glm::ivec2(120, 10) },
+			{ glm::ivec2(0, 0), glm::ivec2(169, 169) }, { glm::ivec2(290, 160), glm::ivec2(140, 10) },
+			{ glm::ivec2(10, 60), glm::ivec2(109, 159) }, { glm::ivec2(0, 169), glm::ivec2(169, 0) },
+			{ glm::ivec2(280, 20), glm::ivec2(131, 169) }, { glm::ivec2(63, 64), glm::ivec2(65, 62) }
+		};
+
+		for (const auto& line : lines) {
+			float distance = -1.0f;
+			REQUIRE(longTables.lookupSurfaceDistance(line[0], line[1], distance));
+			REQUIRE(distance == Approx(calcSurfaceDistance(line[0], line[1], longHeights, longWidth, longHeight, 30.0f, 11.0f)).epsilon(1e-5));
+		}
+	}
+
+	SECTION("Only the chosen directions are built") {
+		AxisDistanceTables rowTables(heights, width, height, 30.0f, 11.0f, pool, AxisDistanceTables::ROWS | AxisDistanceTables::ANTI_DIAGONALS);
+		float distance = -1.0f;
+		REQUIRE(!rowTables.lookupSurfaceDistance(glm::ivec2(3, 2), glm::ivec2(3, 12), distance));
+		REQUIRE(!rowTables.lookupSurfaceDistance(glm::ivec2(3, 2), glm::ivec2(13, 12), distance));
+		REQUIRE(distance == -1.0f);
+
+		REQUIRE(rowTables.lookupSurfaceDistance(glm::ivec2(3, 2), glm::ivec2(20, 2), distance));
+		REQUIRE(distance == Approx(calcSurfaceDistance(glm::ivec2(3, 2), glm::ivec2(20, 2), heights, width, height, 30.0f, 11.0f)).epsilon(1e-5));
+		REQUIRE(rowTables.lookupSurfaceDistance(glm::ivec2(3, 12), glm::ivec2(13, 2), distance));
+		REQUIRE(distance == Approx(calcSurfaceDistance(glm::ivec2(3, 12), glm::ivec2(13, 2), heights, width, height, 30.0f, 11.0f)).epsilon(1e-5));
+
+		glm::ivec2 begin{ 3, 2 };
+		glm::ivec2 end{ 3, 12 };
+		REQUIRE(calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f, rowTables) == calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f));
+	}
+
+	SECTION("Batch uses the tables") {
+		std::vector<SurfaceQuery> queries = {
+			SurfaceQuery{ glm::ivec2(0, 3), glm::ivec2(22, 3) },
+			SurfaceQuery{ glm::ivec2(1, 1), glm::ivec2(14, 14) },
+			SurfaceQuery{ glm::ivec2(2, 5), glm::ivec2(19, 11) }
+		};
+
+		std::vector<float> distances(queries.size());
+		calcSurfaceDistances(queries.data(), queries.size(), heights, width, height, 30.0f, 11.0f, distances.data(), pool, &tables);
+		for (std::size_t i = 0; i < queries.size(); ++i) {
+			REQUIRE(distances[i] == Approx(calcSurfaceDistance(queries[i].begin, queries[i].end, heights, width, height, 30.0f, 11.0f)).epsilon(1e-5));
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#include <cstring>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "batch.h"
+#include "distance.h"
+
+
+static bool isBitIdentical(float a, float b) {
+	return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+
+TEST_CASE("Test surface distance of batches and split lines", "[batch]") {
+	const int width = 1500;
+	const int height = 1100;
+	std::vector<unsigned char> heights = makeTestTerrain(width, height, 0, 0, 0);
+
+	// terraces, so long lines climb up and down many times
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			heights[y * width + x] = static_cast<unsigned char>(heights[y * width + x] + (x / 50 + y / 70) % 9 * 20);
+		}
+	}
+
+	const std::vector<SurfaceQuery> queries = {
+		{ { 3, 5 }, { 1490, 1001 } },
+		{ { 1499, 1099 }, { 0, 0 } },
+		{ { 20, 1090 }, { 700, 4 } },
+		{ { 100, 7 }, { 163, 1098 } },
+		{ { 0, 500 }, { 1499, 500 } },
+		{ { 900, 1099 }, { 900, 0 } },
+		{ { 0, 0 }, { 1099, 1099 } },
+		{ { 1200, 40 }, { 10, 1080 } },
+		{ { 0, 1099 }, { 1499, 1099 } },
+		{ { 10, 10 }, { 300, 200 } }
+	};
+
+	ThreadPool pool(2);
+
+	SECTION("Batches match calcSurfaceDistance exactly") {
+		std::vector<float> distances = calcSurfaceDistances(queries, heights, width, height, 30.0f, 11.0f, pool);
+		for (std::size_t i = 0; i < queries.size(); ++i) {
+			REQUIRE(isBitIdentical(distances[i], calcSurfaceDistance(queries[i].begin, queries[i].end, heights, width, height, 30.0f, 11.0f)));
+		}
+	}
+
+	SECTION("Threshold batches match calcSurfaceDistance") {
+		SlopeBounds bounds(heights, width, height, 30.0f, 11.0f);
+		std::vector<SurfaceQuery> many;
+		for (int i = 0; i < 300; ++i) {
+			many.push_back(SurfaceQuery{ glm::ivec2((i * 53) % width, (i * 29) % height), glm::ivec2((i * 17 + 31) % width, (i * 61 + 5) % height) });
+		}
+
+		for (float limit : { 0.0f, 3000.0f, 20000.0f, 1e6f }) {
+			std::vector<unsigned char> within(many.size(), 2);
+			std::vector<unsigned char> withinBounded(many.size(), 2);
+			areSurfaceDistancesWithin(many.data(), many.size(), limit, heights, width, height, 30.0f, 11.0f, within.data(), pool);
+			areSurfaceDistancesWithin(many.data(), many.size(), limit, heights, width, height, 30.0f, 11.0f, withinBounded.data(), pool, &bounds);
+			for (std::size_t i = 0; i < many.size(); ++i) {
+				unsigned char expect = calcSurfaceDistance(many[i].begin, many[i].end, heights, width, height, 30.0f, 11.0f) <= limit ? 1 : 0;
+				REQUIRE(within[i] == expect);
+				REQUIRE(withinBounded[i] == expect);
+			}
+		}
+	}
+
+	SECTION("Split lines match calcSurfaceDistance on a grid too small for its drift") {
+		for (const SurfaceQuery& query : queries) {
+			float expect = calcSurfaceDistance(query.begin, query.end, heights, width, height, 30.0f, 11.0f);
+			REQUIRE(calcSurfaceDistanceSplit(query.begin, query.end, heights, width, height, 30.0f, 11.0f, pool) == Approx(expect).epsilon(1e-4));
+		}
+
+		// the last row is not walked, and a single piece is calcSurfaceDistance itself
+		REQUIRE(calcSurfaceDistanceSplit(queries[8].begin, queries[8].end, heights, width, height, 30.0f, 11.0f, pool) == 0.0f);
+		REQUIRE(isBitIdentical(calcSurfaceDistanceSplit(queries[9].begin, queries[9].end, heights, width, height, 30.0f, 11.0f, pool),
+			calcSurfaceDistance(queries[9].begin, queries[9].end, heights, width, height, 30.0f, 11.0f)));
+	}
+
+	SECTION("Split lines do not depend on the number of threads") {
+		ThreadPool single(1);
+		ThreadPool many(5);
+		for (const SurfaceQuery& query : queries) {
+			float expect = calcSurfaceDistanceSplit(query.begin, query.end, heights, width, height, 30.0f, 11.0f, single);
+			REQUIRE(isBitIdentical(calcSurfaceDistanceSplit(query.begin, query.end, heights, width, height, 30.0f, 11.0f, pool), expect));
+			REQUIRE(isBitIdentical(calcSurfaceDistanceSplit(query.begin, query.end, heights, width, height, 30.0f, 11.0f, many), expect));
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "compare.h"
+#include "distance.h"
+
+
+TEST_CASE("Test the change mask comparison", "[compare]") {
+	const int width = 203;
+	const int height = 150;
+	std::vector<unsigned char> before = makeTestTerrain(width, height, 60, 66, height);
+
+	// a crater and a pixel in the last column change
+	std::vector<unsigned char> after = before;
+	for (int y = 40; y < 70; ++y) {
+		for (int x = 130; x < 170; ++x) {
+			after[y * width + x] = static_cast<unsigned char>(after[y * width + x] / 2);
+		}
+	}
+
+	after[100 * width + width - 1] += 5;
+	ChangeMask mask(before, after, width, height);
+
+	SECTION("A voxel changed if any of its corners changed") {
+		std::size_t changed = 0;
+		for (int y = 0; y < height - 1; ++y) {
+			for (int x = 0; x < width - 1; ++x) {
+				bool expect = false;
+				for (int corner = 0; corner < 4; ++corner) {
+					std::size_t index = static_cast<std::size_t>(y + corner / 2) * width + x + corner % 2;
+					expect |= before[index] != after[index];
+				}
+
+				REQUIRE(mask.isVoxelChanged(glm::ivec2(x, y)) == expect);
+				changed += expect ? 1 : 0;
+			}
+		}
+
+		REQUIRE(mask.getChangedVoxelCount() == changed);
+		REQUIRE(mask.getTileCount() == glm::ivec2(4, 3));
+		REQUIRE(mask.getChangedTileCount() == 3);
+		REQUIRE(mask.isTileChanged(glm::ivec2(2, 0)));
+		REQUIRE(mask.isTileChanged(glm::ivec2(3, 1)));
+		REQUIRE_FALSE(mask.isTileChanged(glm::ivec2(0, 0)));
+		REQUIRE_FALSE(mask.isVoxelChanged(glm::ivec2(-1, 50)));
+		REQUIRE_FALSE(mask.isVoxelChanged(glm::ivec2(width - 1, 50)));
+	}
+
+	SECTION("Both distances are exactly those of calcSurfaceDistance") {
+		std::vector<SurfaceQuery> queries;
+		for (int i = 0; i < 300; ++i) {
+			queries.push_back({ glm::ivec2((i * 53) % (width - 1), (i * 29) % (height - 1)), glm::ivec2((i * 17 + 31) % (width - 1), (i * 61 + 5) % (height - 1)) });
+		}
+
+		queries.push_back({ glm::ivec2(0, 0), glm::ivec2(100, 140) });
+		queries.push_back({ glm::ivec2(5, 55), glm::ivec2(200, 55) });
+		ThreadPool pool(3);
+		std::vector<SurfaceComparison> comparisons(queries.size());
+		compareSurfaceDistances(queries.data(), queries.size(), before, after, width, height, 30.0f, 11.0f, mask, comparisons.data(), pool);
+
+		std::size_t unchanged = 0;
+		for (std::size_t i = 0; i < queries.size(); ++i) {
+			float expectBefore = calcSurfaceDistance(queries[i].begin, queries[i].end, before, width, height, 30.0f, 11.0f);
+			float expectAfter = calcSurfaceDistance(queries[i].begin, queries[i].end, after, width, height, 30.0f, 11.0f);
+			REQUIRE(comparisons[i].before == expectBefore);
+			REQUIRE(comparisons[i].after == expectAfter);
+			REQUIRE(comparisons[i].difference == expectAfter - expectBefore);
+			unchanged += comparisons[i].difference == 0.0f ? 1 : 0;
+		}
+
+		REQUIRE(unchanged > 0);
+		REQUIRE(unchanged < queries.size());
+		REQUIRE(comparisons.back().difference != 0.0f);
+		REQUIRE(comparisons[queries.size() - 2].difference == 0.0f);
+	}
+
+	SECTION("Lines that cross no changed voxel never read the after heights") {
+		std::vector<unsigned char> empty;
+		SurfaceComparison comparison = compareSurfaceDistance(glm::ivec2(0, 0), glm::ivec2(120, 30), before, empty, width, height, 30.0f, 11.0f, mask);
+		REQUIRE(comparison.difference == 0.0f);
+		REQUIRE(comparison.after == comparison.before);
+		REQUIRE(comparison.before == calcSurfaceDistance(glm::ivec2(0, 0), glm::ivec2(120, 30), before, width, height, 30.0f, 11.0f));
+	}
+
+	SECTION("Height maps must match the image") {
+		REQUIRE_THROWS_AS(ChangeMask(before, std::vector<unsigned char>(10), width, height), std::invalid_argument);
+		REQUIRE_THROWS_AS(ChangeMask(before, after, 1, height), std::invalid_argument);
+	}
+}
@@ -0,0 +1,135 @@
+#include <atomic>
+#include <thread>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "dataset.h"
+#include "distance.h"
+
+
+// every version moves the wall one column and shifts the noise
+static std::vector<unsigned char> makeHeights(int width, int height, int version) {
+	return makeTestTerrain(width, height, 10 + version, 16 + version, height, version * 13);
+}
+
+
+TEST_CASE("Test hot swapping height datasets", "[dataset]") {
+	const int width = 64;
+	const int height = 48;
+	const int versionCount = 40;
+	const glm::ivec2 begin(2, 3);
+	const glm::ivec2 end(60, 40);
+	std::vector<float> expect;
+	for (int version = 0; version < versionCount; ++version) {
+		expect.push_back(calcSurfaceDistance(begin, end, makeHeights(width, height, version), width, height, 30.0f, 11.0f));
+	}
+
+	DatasetHandle handle(7, makeHeights(width, height, 0), width, height, 30.0f, 11.0f, 4);
+
+	SECTION("Pins keep their version alive across publishes") {
+		DatasetReader reader = handle.registerReader();
+		{
+			DatasetPin pin = reader.pin();
+			REQUIRE(pin->getKey().id == 7);
+			REQUIRE(pin->getKey().version == 0);
+			REQUIRE(handle.publish(makeHeights(width, height, 1), width, height, 30.0f, 11.0f) == 1);
+			REQUIRE(handle.getVersion() == 1);
+			REQUIRE(handle.getRetiredCount() == 1);
+			REQUIRE(pin->calcSurfaceDistance(begin, end) == expect[0]);
+		}
+
+		REQUIRE(handle.reclaim() == 0);
+		DatasetPin pin = reader.pin();
+		REQUIRE(pin->getKey().version == 1);
+		REQUIRE((*pin).calcSurfaceDistance(begin, end) == expect[1]);
+
+		// a version published while nothing is pinned on the old one is freed right away
+		DatasetReader idle = handle.registerReader();
+		handle.publish(makeHeights(width, height, 2), width, height, 30.0f, 11.0f);
+		REQUIRE(handle.getRetiredCount() == 1);
+	}
+
+	SECTION("Readers are limited to the slots of the handle") {
+		std::vector<DatasetReader> readers;
+		for (int i = 0; i < 4; ++i) {
+			readers.push_back(handle.registerReader());
+		}
+
+		REQUIRE_THROWS_AS(handle.registerReader(), std::runtime_error);
+		readers.pop_back();
+		REQUIRE_NOTHROW(handle.registerReader());
+		REQUIRE_THROWS_AS(handle.publish(std::vector<unsigned char>(10), width, height, 30.0f, 11.0f), std::invalid_argument);
+		REQUIRE(handle.getVersion() == 0);
+	}
+
+	SECTION("Queries running during publishes always see a whole version") {
+		std::atomic<bool> done{ false };
+		std::atomic<int> mismatches{ 0 };
+		std::atomic<int> queries{ 0 };
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 3; ++i) {
+			threads.emplace_back([&]() {
+				DatasetReader reader = handle.registerReader();
+				std::uint32_t lastVersion = 0;
+				while (!done.load()) {
+					DatasetPin pin = reader.pin();
+					std::uint32_t version = pin->getKey().version;
+					if (version < lastVersion || pin->calcSurfaceDistance(begin, end) != expect[version]) {
+						++mismatches;
+					}
+
+					lastVersion = version;
+					++queries;
+				}
+			});
+		}
+
+		for (int version = 1; version < versionCount; ++version) {
+			handle.publish(makeHeights(width, height, version), width, height, 30.0f, 11.0f);
+			std::this_thread::yield();
+		}
+
+		done.store(true);
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		REQUIRE(mismatches.load() == 0);
+		REQUIRE(queries.load() > 0);
+		REQUIRE(handle.getVersion() == versionCount - 1);
+		REQUIRE(handle.reclaim() == 0);
+	}
+
+	SECTION("Versions can be read without a pin during publishes") {
+		std::atomic<bool> done{ false };
+		std::atomic<int> mismatches{ 0 };
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 3; ++i) {
+			threads.emplace_back([&]() {
+				std::uint32_t lastVersion = 0;
+				while (!done.load()) {
+					std::uint32_t version = handle.getVersion();
+					if (version < lastVersion || version >= versionCount) {
+						++mismatches;
+					}
+
+					lastVersion = version;
+				}
+			});
+		}
+
+		// nothing is pinned, so every publish frees the version it replaces
+		for (int version = 1; version < versionCount; ++version) {
+			REQUIRE(handle.publish(makeHeights(width, height, version), width, height, 30.0f, 11.0f) == static_cast<std::uint32_t>(version));
+			REQUIRE(handle.getRetiredCount() == 0);
+			std::this_thread::yield();
+		}
+
+		done.store(true);
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		REQUIRE(mismatches.load() == 0);
+		REQUIRE(handle.getVersion() == versionCount - 1);
+	}
+}
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "distance_transform.h"
+#include "mapped_file.h"
+
+
+static std::vector<float> findReferenceTransform(const SurfaceGraph& graph, const std::vector<unsigned char>& seedMask) {
+	int width = graph.getImageWidth();
+	std::vector<float> distances(graph.getNodeCount(), std::numeric_limits<float>::infinity());
+	std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, std::greater<std::pair<float, int>>> queue;
+	for (std::size_t node = 0; node < graph.getNodeCount(); ++node) {
+		if (seedMask[node]) {
+			distances[node] = 0.0f;
+			queue.push(std::make_pair(0.0f, static_cast<int>(node)));
+		}
+	}
+
+	while (!queue.empty()) {
+		std::pair<float, int> entry = queue.top();
+		queue.pop();
+		if (entry.first > distances[entry.second]) {
+			continue;
+		}
+
+		glm::ivec2 pixel{ entry.second % width, entry.second / width };
+		for (int neighbour = 0; neighbour < graph.getNeighbourCount(); ++neighbour) {
+			float weight = graph.getEdgeWeight(entry.second, neighbour);
+			glm::ivec2 next = pixel + graph.getNeighbourOffset(neighbour);
+			if (weight != std::numeric_limits<float>::infinity() && entry.first + weight < distances[next.y * width + next.x]) {
+				distances[next.y * width + next.x] = entry.first + weight;
+				queue.push(std::make_pair(entry.first + weight, next.y * width + next.x));
+			}
+		}
+	}
+
+	return distances;
+}
+
+
+TEST_CASE("Test the surface distance transform", "[distance_transform]") {
+	const int width = 150;
+	const int height = 131;
+	std::vector<unsigned char> heights = makeTestTerrain(width, height, 60, 66, 100);
+	std::vector<unsigned char> seeds(width * height, 0);
+
+	// a river along a column and a single vent
+	for (int y = 0; y < height; ++y) {
+		seeds[y * width + 20] = 1;
+	}
+
+	seeds[110 * width + 140] = 1;
+	ThreadPool pool(3);
+
+	for (GraphConnectivity connectivity : { GraphConnectivity::Eight, GraphConnectivity::Sixteen }) {
+		SECTION("Tiles agree with Dijkstra over the whole graph, connectivity " + std::to_string(static_cast<int>(connectivity))) {
+			SurfaceGraph graph(heights, width, height, 30.0f, 11.0f, connectivity, pool);
+			std::vector<float> expect = findReferenceTransform(graph, seeds);
+			std::vector<float> distances(width * height);
+			calcSurfaceDistanceTransform(seeds, heights, width, height, 30.0f, 11.0f, distances.data(), pool, connectivity);
+			for (int i = 0; i < width * height; ++i) {
+				REQUIRE(distances[i] == Approx(expect[i]).epsilon(1e-5));
+			}
+		}
+	}
+
+	SECTION("The transform is written through a mapped file") {
+		const std::string filename = "test_transform.raw";
+		writeSurfaceDistanceTransform(filename, seeds, heights, width, height, 30.0f, 11.0f, pool);
+		std::vector<float> distances(width * height);
+		calcSurfaceDistanceTransform(seeds, heights, width, height, 30.0f, 11.0f, distances.data(), pool);
+
+		std::vector<float> written(width * height);
+		std::ifstream file(filename, std::ios::binary);
+		file.read(reinterpret_cast<char*>(written.data()), written.size() * sizeof(float));
+		REQUIRE(file.gcount() == static_cast<std::streamsize>(written.size() * sizeof(float)));
+		file.close();
+		REQUIRE(written == distances);
+		std::remove(filename.c_str());
+	}
+
+	SECTION("Pixels without seeds stay unreachable") {
+		std::vector<unsigned char> noSeeds(width * height, 0);
+		std::vector<float> distances(width * height);
+		calcSurfaceDistanceTransform(noSeeds, heights, width, height, 30.0f, 11.0f, distances.data(), pool);
+		REQUIRE(std::all_of(distances.begin(), distances.end(), [](float distance) { return distance == std::numeric_limits<float>::infinity(); }));
+
+		REQUIRE_THROWS_AS(calcSurfaceDistanceTransform(std::vector<unsigned char>(10), heights, width, height, 30.0f, 11.0f, distances.data(), pool),
+			std::invalid_argument);
+	}
+
+	SECTION("Mapped files start as zeros of the requested size") {
+		const std::string filename = "test_mapped.raw";
+		{
+			MappedFile file(filename, 1000);
+			REQUIRE(file.getSize() == 1000);
+			const unsigned char* data = static_cast<const unsigned char*>(file.getData());
+			REQUIRE(std::all_of(data, data + 1000, [](unsigned char value) { return value == 0; }));
+			static_cast<unsigned char*>(file.getData())[999] = 7;
+		}
+
+		std::ifstream file(filename, std::ios::binary | std::ios::ate);
+		REQUIRE(file.tellg() == 1000);
+		file.seekg(999);
+		REQUIRE(file.get() == 7);
+		file.close();
+		std::remove(filename.c_str());
+
+		REQUIRE_THROWS_AS(MappedFile("missing_directory/test_mapped.raw", 10), std::runtime_error);
+	}
+}
@@ -0,0 +1,158 @@
+#include <cmath>
+#include <limits>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "distance.h"
+#include "geodesic.h"
+#include "graph.h"
+
+
+TEST_CASE("Test geodesic distances on the triangulated surface", "[geodesic]") {
+	SECTION("Geodesics on a flat surface are straight") {
+		const int size = 20;
+		std::vector<unsigned char> heights(size * size, 40);
+		GeodesicSolver solver(heights, size, size, 30.0f, 11.0f);
+		const glm::ivec2 pairs[][2] = {
+			{ glm::ivec2(0, 0), glm::ivec2(19, 19) },
+			{ glm::ivec2(2, 3), glm::ivec2(17, 9) },
+			{ glm::ivec2(15, 1), glm::ivec2(3, 18) },
+			{ glm::ivec2(4, 4), glm::ivec2(4, 4) }
+		};
+
+		for (const auto& pair : pairs) {
+			float expect = 30.0f * glm::distance(static_cast<glm::vec2>(pair[0]), static_cast<glm::vec2>(pair[1]));
+			REQUIRE(solver.findGeodesicDistance(pair[0], pair[1]) == Approx(expect).epsilon(1e-4).margin(1e-3));
+			REQUIRE(solver.findGeodesicDistance(pair[0], pair[1], GeodesicMode::FastMarching) == Approx(expect).epsilon(0.02).margin(1e-3));
+		}
+	}
+
+	SECTION("Exact geodesics across a ridge match the unfolded straight line") {
+		// two planes of different slope meet at a ridge, along a column or along the voxel diagonals;
+		// the roof unfolds into a rectangle without stretching, so geodesics are straight in the unfolded plane
+		const int roofSize = 25;
+		const float pixelDistance = 30.0f;
+		const float pixelHeight = 11.0f;
+		for (int diagonal = 0; diagonal < 2; ++diagonal) {
+			// across the ridge, in pixels: x - 12 along a column, (x + y - 24) / sqrt(2) along the diagonals
+			auto across = [&](glm::vec2 pixel) {
+				return diagonal ? (pixel.x + pixel.y - 24.0f) / std::sqrt(2.0f) : pixel.x - 12.0f;
+			};
+
+			auto along = [&](glm::vec2 pixel) {
+				return diagonal ? (pixel.x - pixel.y) / std::sqrt(2.0f) : pixel.y;
+			};
+
+			// height units per pixel across the ridge, on the near and the far side
+			const int nearSlope = 3;
+			const int farSlope = 2;
+			std::vector<unsigned char> roof(roofSize * roofSize);
+			for (int y = 0; y < roofSize; ++y) {
+				for (int x = 0; x < roofSize; ++x) {
+					int offset = diagonal ? x + y - 24 : x - 12;
+					roof[y * roofSize + x] = static_cast<unsigned char>(offset < 0 ? 150 + nearSlope * offset : 150 - farSlope * offset);
+				}
+			}
+
+			auto unfold = [&](glm::ivec2 pixel) {
+				float distance = across(static_cast<glm::vec2>(pixel));
+				float slope = (distance < 0.0f ? nearSlope : farSlope) * (diagonal ? std::sqrt(2.0f) : 1.0f) * pixelHeight;
+				return glm::vec2(distance * std::sqrt(pixelDistance * pixelDistance + slope * slope), along(static_cast<glm::vec2>(pixel)) * pixelDistance);
+			};
+
+			GeodesicSolver roofSolver(roof, roofSize, roofSize, pixelDistance, pixelHeight);
+			const glm::ivec2 pairs[][2] = {
+				{ glm::ivec2(2, 3), glm::ivec2(22, 20) },
+				{ glm::ivec2(0, 20), glm::ivec2(24, 1) },
+				{ glm::ivec2(5, 12), glm::ivec2(19, 13) },
+				{ glm::ivec2(11, 0), glm::ivec2(13, 24) },
+				{ glm::ivec2(3, 9), glm::ivec2(8, 2) },
+				{ glm::ivec2(24, 24), glm::ivec2(1, 4) }
+			};
+
+			for (const auto& pair : pairs) {
+				float expect = glm::distance(unfold(pair[0]), unfold(pair[1]));
+				REQUIRE(roofSolver.findGeodesicDistance(pair[0], pair[1]) == Approx(expect).epsilon(1e-5));
+			}
+		}
+	}
+
+	const int size = 24;
+	std::vector<unsigned char> heights = makeTestTerrain(size, size, 8, 12, 18);
+
+	GeodesicSolver solver(heights, size, size, 30.0f, 11.0f);
+
+	SECTION("Exact geodesics are bounded by straight lines, pixel paths and chords") {
+		ThreadPool pool(2);
+		SurfaceGraph graph(heights, size, size, 30.0f, 11.0f, GraphConnectivity::Sixteen, pool);
+		BidirectionalSearch search(graph);
+		for (int i = 0; i < 30; ++i) {
+			glm::ivec2 begin{ (i * 7) % (size - 1), (i * 13) % (size - 1) };
+			glm::ivec2 end{ (i * 29 + 5) % (size - 1), (i * 17 + 11) % (size - 1) };
+			float geodesic = solver.findGeodesicDistance(begin, end);
+			glm::vec3 beginPosition(static_cast<glm::vec2>(begin) * 30.0f, heights[begin.y * size + begin.x] * 11.0f);
+			glm::vec3 endPosition(static_cast<glm::vec2>(end) * 30.0f, heights[end.y * size + end.x] * 11.0f);
+
+			REQUIRE(geodesic >= glm::distance(beginPosition, endPosition) * (1.0f - 1e-5f));
+			REQUIRE(geodesic <= calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 11.0f) * (1.0f + 1e-5f));
+			REQUIRE(geodesic <= search.findShortestPath(begin, end) * (1.0f + 1e-5f));
+			REQUIRE(solver.findGeodesicDistance(end, begin) == Approx(geodesic).epsilon(1e-4));
+		}
+	}
+
+	SECTION("Fast marching stays close to the exact distances on smooth ground") {
+		std::vector<unsigned char> smooth(size * size);
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				smooth[y * size + x] = static_cast<unsigned char>(100.0 + 40.0 * std::sin(x / 5.0) * std::cos(y / 7.0));
+			}
+		}
+
+		GeodesicSolver smoothSolver(smooth, size, size, 30.0f, 11.0f);
+		smoothSolver.findGeodesicDistances(glm::ivec2(5, 7));
+		std::vector<float> exact;
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				exact.push_back(smoothSolver.getDistance(glm::ivec2(x, y)));
+			}
+		}
+
+		smoothSolver.findGeodesicDistances(glm::ivec2(5, 7), GeodesicMode::FastMarching);
+		double errorSum = 0.0;
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				if (x != 5 || y != 7) {
+					float expect = exact[y * size + x];
+					REQUIRE(smoothSolver.getDistance(glm::ivec2(x, y)) == Approx(expect).epsilon(0.2));
+					errorSum += std::abs(smoothSolver.getDistance(glm::ivec2(x, y)) - expect) / expect;
+				}
+			}
+		}
+
+		REQUIRE(errorSum / (size * size - 1) < 0.01);
+	}
+
+	SECTION("Queries stop early at the target") {
+		glm::ivec2 source{ 3, 4 };
+		solver.findGeodesicDistances(source);
+		std::size_t allEvents = solver.getEventCount();
+		std::vector<float> distances;
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				distances.push_back(solver.getDistance(glm::ivec2(x, y)));
+			}
+		}
+
+		REQUIRE(solver.findGeodesicDistance(source, glm::ivec2(5, 5)) == Approx(distances[5 * size + 5]).epsilon(1e-5));
+		REQUIRE(solver.getEventCount() < allEvents);
+		REQUIRE(solver.findGeodesicDistance(source, glm::ivec2(20, 22)) == Approx(distances[22 * size + 20]).epsilon(1e-5));
+
+		// the solver forgets everything the previous query reached
+		solver.findGeodesicDistance(glm::ivec2(0, 0), glm::ivec2(1, 0));
+		REQUIRE(solver.getDistance(glm::ivec2(20, 22)) == std::numeric_limits<float>::infinity());
+	}
+
+	SECTION("Pixels outside of the image are rejected") {
+		REQUIRE_THROWS_AS(solver.findGeodesicDistance(glm::ivec2(-1, 0), glm::ivec2(1, 1)), std::out_of_range);
+		REQUIRE_THROWS_AS(solver.findGeodesicDistance(glm::ivec2(0, 0), glm::ivec2(size, 1)), std::out_of_range);
+	}
+}
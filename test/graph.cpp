@@ -0,0 +1,134 @@
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <queue>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "distance.h"
+#include "graph.h"
+#include "hierarchy.h"
+
+
+static float findReferenceDistance(const SurfaceGraph& graph, glm::ivec2 begin, glm::ivec2 end) {
+	int width = graph.getImageWidth();
+	std::vector<float> distances(graph.getNodeCount(), std::numeric_limits<float>::infinity());
+	std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, std::greater<std::pair<float, int>>> queue;
+	distances[begin.y * width + begin.x] = 0.0f;
+	queue.push(std::make_pair(0.0f, begin.y * width + begin.x));
+	while (!queue.empty()) {
+		std::pair<float, int> entry = queue.top();
+		queue.pop();
+		if (entry.first > distances[entry.second]) {
+			continue;
+		}
+
+		glm::ivec2 pixel{ entry.second % width, entry.second / width };
+		for (int neighbour = 0; neighbour < graph.getNeighbourCount(); ++neighbour) {
+			float weight = graph.getEdgeWeight(entry.second, neighbour);
+			glm::ivec2 next = pixel + graph.getNeighbourOffset(neighbour);
+			if (weight != std::numeric_limits<float>::infinity() && entry.first + weight < distances[next.y * width + next.x]) {
+				distances[next.y * width + next.x] = entry.first + weight;
+				queue.push(std::make_pair(entry.first + weight, next.y * width + next.x));
+			}
+		}
+	}
+
+	return distances[end.y * width + end.x];
+}
+
+
+static float measurePath(const SurfaceGraph& graph, const std::vector<glm::ivec2>& path) {
+	float length = 0.0f;
+	for (std::size_t i = 0; i + 1 < path.size(); ++i) {
+		bool adjacent = false;
+		for (int neighbour = 0; neighbour < graph.getNeighbourCount(); ++neighbour) {
+			if (path[i] + graph.getNeighbourOffset(neighbour) == path[i + 1]) {
+				length += graph.getEdgeWeight(path[i].y * graph.getImageWidth() + path[i].x, neighbour);
+				adjacent = true;
+			}
+		}
+
+		REQUIRE(adjacent);
+	}
+
+	return length;
+}
+
+
+TEST_CASE("Test shortest paths on the surface graph", "[graph]") {
+	const int size = 24;
+	std::vector<unsigned char> heights = makeTestTerrain(size, size, 8, 12, 18);
+
+	ThreadPool pool(2);
+
+	SECTION("Edge weights follow the surface") {
+		SurfaceGraph graph(heights, size, size, 30.0f, 11.0f, GraphConnectivity::Sixteen, pool);
+		REQUIRE(graph.getNeighbourCount() == 16);
+		REQUIRE(graph.getEdgeWeight(0, 0) == Approx(calcSurfaceDistance(glm::ivec2(0, 0), glm::ivec2(1, 0), heights, size, size, 30.0f, 11.0f)));
+		REQUIRE(graph.getEdgeWeight(3 * size + 4, 8) == calcSurfaceDistance(glm::ivec2(4, 3), glm::ivec2(6, 4), heights, size, size, 30.0f, 11.0f));
+		REQUIRE(graph.getEdgeWeight(0, 4) == std::numeric_limits<float>::infinity());
+
+		// axis edges on the last row weigh the pixel edge, not the 0 calcSurfaceDistance gives there
+		REQUIRE(graph.getEdgeWeight((size - 1) * size, 0) >= 30.0f);
+	}
+
+	for (GraphConnectivity connectivity : { GraphConnectivity::Eight, GraphConnectivity::Sixteen }) {
+		SECTION("Bidirectional A* and contraction hierarchy find the shortest path, connectivity " + std::to_string(static_cast<int>(connectivity))) {
+			SurfaceGraph graph(heights, size, size, 30.0f, 11.0f, connectivity, pool);
+			BidirectionalSearch search(graph);
+			ContractionHierarchy hierarchy(graph, pool);
+			for (int i = 0; i < 40; ++i) {
+				glm::ivec2 begin{ (i * 7) % size, (i * 13) % size };
+				glm::ivec2 end{ (i * 29 + 5) % size, (i * 17 + 11) % size };
+				float expect = findReferenceDistance(graph, begin, end);
+
+				std::vector<glm::ivec2> path;
+				REQUIRE(search.findShortestPath(begin, end, &path) == Approx(expect).epsilon(1e-5));
+				REQUIRE(path.front() == begin);
+				REQUIRE(path.back() == end);
+				REQUIRE(measurePath(graph, path) == Approx(expect).epsilon(1e-5));
+
+				REQUIRE(hierarchy.findShortestPath(begin, end, &path) == Approx(expect).epsilon(1e-5));
+				REQUIRE(path.front() == begin);
+				REQUIRE(path.back() == end);
+				REQUIRE(measurePath(graph, path) == Approx(expect).epsilon(1e-5));
+			}
+		}
+	}
+
+	SECTION("Hierarchy queries reuse the search state of their thread") {
+		SurfaceGraph graph(heights, size, size, 30.0f, 11.0f, GraphConnectivity::Eight, pool);
+		ContractionHierarchy hierarchy(graph, pool);
+		const int queryCount = 60;
+		std::vector<float> expect(queryCount);
+		for (int i = 0; i < queryCount; ++i) {
+			expect[i] = findReferenceDistance(graph, glm::ivec2((i * 5) % size, (i * 11) % size), glm::ivec2((i * 19 + 3) % size, (i * 23 + 7) % size));
+		}
+
+		std::vector<float> distances(queryCount * 3);
+		pool.parallelFor(distances.size(), [&](std::size_t index) {
+			int i = static_cast<int>(index % queryCount);
+			distances[index] = hierarchy.findShortestPath(glm::ivec2((i * 5) % size, (i * 11) % size), glm::ivec2((i * 19 + 3) % size, (i * 23 + 7) % size));
+		});
+
+		for (std::size_t index = 0; index < distances.size(); ++index) {
+			REQUIRE(distances[index] == Approx(expect[index % queryCount]).epsilon(1e-5));
+		}
+
+		REQUIRE(hierarchy.findShortestPath(glm::ivec2(4, 9), glm::ivec2(4, 9)) == 0.0f);
+	}
+
+	SECTION("Hierarchy survives a round trip through a file") {
+		SurfaceGraph graph(heights, size, size, 30.0f, 11.0f, GraphConnectivity::Eight, pool);
+		ContractionHierarchy hierarchy(graph, pool);
+		const std::string filename = "test_hierarchy.sdch";
+		writeContractionHierarchy(filename, hierarchy);
+		ContractionHierarchy loaded = readContractionHierarchy(filename);
+		REQUIRE(loaded.getNodeCount() == hierarchy.getNodeCount());
+		REQUIRE(loaded.getEdgeCount() == hierarchy.getEdgeCount());
+		REQUIRE(loaded.findShortestPath(glm::ivec2(1, 2), glm::ivec2(20, 21)) == hierarchy.findShortestPath(glm::ivec2(1, 2), glm::ivec2(20, 21)));
+		std::remove(filename.c_str());
+
+		REQUIRE_THROWS_AS(readContractionHierarchy("missing_hierarchy.sdch"), std::runtime_error);
+	}
+}
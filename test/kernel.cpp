@@ -0,0 +1,79 @@
+#include <cstdlib>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "kernel.h"
+#include "dataset.h"
+#include "distance.h"
+
+
+static void setIsaVariable(const char* value) {
+#ifdef _WIN32
+	_putenv_s("SURFACE_DISTANCE_ISA", value ? value : "");
+#else
+	if (value) {
+		setenv("SURFACE_DISTANCE_ISA", value, 1);
+	}
+	else {
+		unsetenv("SURFACE_DISTANCE_ISA");
+	}
+#endif
+}
+
+
+TEST_CASE("Test the kernel variants", "[kernel]") {
+	const int width = 300;
+	const int height = 220;
+	std::vector<unsigned char> heights = makeTestTerrain(width, height, 60, 66, height);
+
+	SECTION("Every supported variant matches calcSurfaceDistance bit for bit") {
+		REQUIRE(isKernelIsaSupported(KernelIsa::Baseline));
+		REQUIRE(isKernelIsaSupported(detectKernelIsa()));
+		for (KernelIsa isa : { KernelIsa::Baseline, KernelIsa::Sse42, KernelIsa::Avx2, KernelIsa::Avx512 }) {
+			if (!isKernelIsaSupported(isa)) {
+				REQUIRE_THROWS_AS(getSurfaceDistanceKernel(isa), std::runtime_error);
+				continue;
+			}
+
+			SurfaceDistanceKernel kernel = getSurfaceDistanceKernel(isa);
+			for (int i = 0; i < 500; ++i) {
+				glm::ivec2 begin((i * 53) % width, (i * 29) % height);
+				glm::ivec2 end((i * 17 + 31) % width, (i * 61 + 5) % height);
+				REQUIRE(kernel(begin, end, heights, width, height, 30.0f, 11.0f) == calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f));
+			}
+
+			// axis aligned and diagonal lines run into the colinear cases
+			REQUIRE(kernel(glm::ivec2(3, 7), glm::ivec2(250, 7), heights, width, height, 30.0f, 11.0f)
+				== calcSurfaceDistance(glm::ivec2(3, 7), glm::ivec2(250, 7), heights, width, height, 30.0f, 11.0f));
+			REQUIRE(kernel(glm::ivec2(200, 10), glm::ivec2(10, 200), heights, width, height, 30.0f, 11.0f)
+				== calcSurfaceDistance(glm::ivec2(200, 10), glm::ivec2(10, 200), heights, width, height, 30.0f, 11.0f));
+		}
+	}
+
+	SECTION("The environment picks the variant of a dataset") {
+		setIsaVariable("baseline");
+		REQUIRE(selectKernelIsa() == KernelIsa::Baseline);
+		HeightDataset dataset(heights, width, height, 30.0f, 11.0f);
+		REQUIRE(dataset.getKernelIsa() == KernelIsa::Baseline);
+
+		setIsaVariable("avx1024");
+		REQUIRE_THROWS_AS(selectKernelIsa(), std::invalid_argument);
+		REQUIRE_THROWS_AS(HeightDataset(heights, width, height, 30.0f, 11.0f), std::invalid_argument);
+
+		setIsaVariable(nullptr);
+		REQUIRE(selectKernelIsa() == detectKernelIsa());
+		REQUIRE(std::string(getKernelIsaName(KernelIsa::Avx2)) == "avx2");
+
+		std::vector<SurfaceQuery> queries;
+		for (int i = 0; i < 300; ++i) {
+			queries.push_back({ glm::ivec2((i * 53) % width, (i * 29) % height), glm::ivec2((i * 17 + 31) % width, (i * 61 + 5) % height) });
+		}
+
+		HeightDataset detected(heights, width, height, 30.0f, 11.0f);
+		ThreadPool pool(2);
+		std::vector<float> distances(queries.size());
+		calcSurfaceDistances(queries.data(), queries.size(), detected, distances.data(), pool);
+		for (std::size_t i = 0; i < queries.size(); ++i) {
+			REQUIRE(distances[i] == calcSurfaceDistance(queries[i].begin, queries[i].end, heights, width, height, 30.0f, 11.0f));
+		}
+	}
+}
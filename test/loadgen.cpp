@@ -0,0 +1,98 @@
+#include <atomic>
+#include "catch.hpp"
+#include "loadgen.h"
+
+
+TEST_CASE("Test synthesized workloads", "[loadgen]") {
+	WorkloadOptions options{ 64, 48, 500, 2.0f, 30.0f, LengthDistribution::Uniform, OrientationDistribution::Uniform, 0, 4.0f, 0.0f, 7 };
+
+	SECTION("Lines stay inside of the image") {
+		auto queries = synthesizeWorkload(options);
+		REQUIRE(queries.size() == 500);
+		for (const SurfaceQuery& query : queries) {
+			REQUIRE(query.begin.x >= 0);
+			REQUIRE(query.begin.x < 64);
+			REQUIRE(query.end.y >= 0);
+			REQUIRE(query.end.y < 48);
+			REQUIRE(glm::length(glm::vec2(query.end - query.begin)) <= 31.0f);
+			REQUIRE(query.begin != query.end);
+		}
+	}
+
+	SECTION("Lines from the border are never empty") {
+		// every pixel of a 2x2 image is on the border, and most directions leave it at once
+		options.imageWidth = 2;
+		options.imageHeight = 2;
+		options.minLength = 0.0f;
+		for (OrientationDistribution orientation : { OrientationDistribution::Uniform, OrientationDistribution::AxisAligned, OrientationDistribution::Octilinear }) {
+			options.orientationDistribution = orientation;
+			for (const SurfaceQuery& query : synthesizeWorkload(options)) {
+				REQUIRE(query.begin != query.end);
+				REQUIRE(glm::all(glm::lessThan(glm::max(query.begin, query.end), glm::ivec2(2, 2))));
+			}
+		}
+	}
+
+	SECTION("Same seed gives the same workload") {
+		auto first = synthesizeWorkload(options);
+		auto second = synthesizeWorkload(options);
+		for (std::size_t i = 0; i < first.size(); ++i) {
+			REQUIRE(first[i].begin == second[i].begin);
+			REQUIRE(first[i].end == second[i].end);
+		}
+	}
+
+	SECTION("Octilinear lines run along the axes or diagonals") {
+		options.orientationDistribution = OrientationDistribution::Octilinear;
+		for (const SurfaceQuery& query : synthesizeWorkload(options)) {
+			glm::ivec2 delta = glm::abs(query.end - query.begin);
+			REQUIRE((delta.x == 0 || delta.y == 0 || delta.x == delta.y));
+		}
+	}
+
+	SECTION("Hotspots keep the lines local") {
+		options.hotspotCount = 1;
+		options.hotspotRadius = 0.0f;
+		options.hotspotFraction = 1.0f;
+		auto queries = synthesizeWorkload(options);
+		for (const SurfaceQuery& query : queries) {
+			REQUIRE(query.begin == queries[0].begin);
+		}
+	}
+}
+
+
+TEST_CASE("Test load runs", "[loadgen]") {
+	std::vector<SurfaceQuery> queries(100, SurfaceQuery{ glm::ivec2(0, 0), glm::ivec2(1, 1) });
+	std::atomic<std::size_t> executed{ 0 };
+	RequestExecutor executor = [&](const SurfaceQuery*, std::size_t count) { executed += count; };
+
+	SECTION("Closed loop runs every query once") {
+		LoadResult result = runClosedLoop(queries, 8, 3, executor);
+		REQUIRE(executed == 100);
+		REQUIRE(result.latencies.size() == 13);
+		REQUIRE(result.queryCount == 100);
+	}
+
+	SECTION("Open loop follows the arrival times") {
+		LoadResult result = runOpenLoop(queries, 1, fixedRateArrivals(100, 20000.0), 2, executor);
+		REQUIRE(executed == 100);
+		REQUIRE(result.elapsedSeconds >= 99 / 20000.0);
+	}
+
+	SECTION("Percentiles use the nearest rank") {
+		LoadResult result;
+		for (int i = 1; i <= 1000; ++i) {
+			result.latencies.push_back(static_cast<double>(i));
+		}
+
+		result.elapsedSeconds = 2.0;
+		result.queryCount = 1000;
+		LatencySummary summary = summarizeLatencies(result);
+		REQUIRE(summary.p50 == 500.0);
+		REQUIRE(summary.p99 == 990.0);
+		REQUIRE(summary.p999 == 999.0);
+		REQUIRE(summary.max == 1000.0);
+		REQUIRE(summary.throughput == 500.0);
+	}
+}
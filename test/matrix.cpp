@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "matrix.h"
+#include "distance.h"
+#include "shard.h"
+
+
+TEST_CASE("Test the symmetric surface distance matrix", "[matrix]") {
+	const int width = 120;
+	const int height = 90;
+	std::vector<unsigned char> heights = makeTestTerrain(width, height, 40, 46, height);
+
+	// more than two blocks, scattered over the image, with one landmark listed twice
+	std::vector<glm::ivec2> landmarks;
+	for (int i = 0; i < 75; ++i) {
+		landmarks.emplace_back((i * 53 + 7) % (width - 1), (i * 29 + 3) % (height - 1));
+	}
+
+	landmarks.push_back(landmarks[10]);
+	const std::size_t count = landmarks.size();
+
+	ThreadPool pool(3);
+
+	SECTION("Every pair gets calcSurfaceDistance from the landmark listed first") {
+		std::vector<float> distances(count * count, -1.0f);
+		calcSurfaceDistanceMatrix(landmarks, heights, width, height, 30.0f, 11.0f, distances.data(), pool);
+		for (std::size_t i = 0; i < count; ++i) {
+			REQUIRE(distances[i * count + i] == 0.0f);
+			for (std::size_t j = i + 1; j < count; ++j) {
+				float expect = landmarks[i] == landmarks[j] ? 0.0f : calcSurfaceDistance(landmarks[i], landmarks[j], heights, width, height, 30.0f, 11.0f);
+				REQUIRE(distances[i * count + j] == expect);
+				REQUIRE(distances[j * count + i] == expect);
+			}
+		}
+
+		REQUIRE(distances[10 * count + count - 1] == 0.0f);
+	}
+
+	SECTION("The matrix does not depend on the number of threads") {
+		ThreadPool single(1);
+		std::vector<float> expect(count * count);
+		std::vector<float> distances(count * count);
+		calcSurfaceDistanceMatrix(landmarks, heights, width, height, 30.0f, 11.0f, expect.data(), single);
+		calcSurfaceDistanceMatrix(landmarks, heights, width, height, 30.0f, 11.0f, distances.data(), pool);
+		REQUIRE(std::memcmp(expect.data(), distances.data(), expect.size() * sizeof(float)) == 0);
+	}
+
+	SECTION("The matrix is written through a mapped file") {
+		const std::string filename = "test_matrix.raw";
+		writeSurfaceDistanceMatrix(filename, landmarks, heights, width, height, 30.0f, 11.0f, pool);
+		std::vector<float> distances(count * count);
+		calcSurfaceDistanceMatrix(landmarks, heights, width, height, 30.0f, 11.0f, distances.data(), pool);
+
+		std::vector<float> written(distances.size());
+		std::ifstream file(filename, std::ios::binary);
+		file.read(reinterpret_cast<char*>(written.data()), written.size() * sizeof(float));
+		REQUIRE(file.gcount() == static_cast<std::streamsize>(written.size() * sizeof(float)));
+		file.close();
+		REQUIRE(written == distances);
+		std::remove(filename.c_str());
+	}
+
+	SECTION("Landmarks outside of the image throw") {
+		std::vector<float> distances(4);
+		REQUIRE_THROWS_AS(calcSurfaceDistanceMatrix({ glm::ivec2(0, 0), glm::ivec2(width, 0) }, heights, width, height, 30.0f, 11.0f, distances.data(), pool),
+			std::out_of_range);
+	}
+
+	SECTION("Morton codes interleave the bits of x and y") {
+		REQUIRE(calcMortonCode(glm::ivec2(0, 0)) == 0);
+		REQUIRE(calcMortonCode(glm::ivec2(1, 0)) == 1);
+		REQUIRE(calcMortonCode(glm::ivec2(0, 1)) == 2);
+		REQUIRE(calcMortonCode(glm::ivec2(3, 5)) == 39);
+	}
+}
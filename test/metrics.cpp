@@ -0,0 +1,52 @@
+#include "catch.hpp"
+#include "distance.h"
+#include "metrics.h"
+
+
+TEST_CASE("Test metrics accumulated along a line", "[metrics]") {
+	std::vector<unsigned char> heights = {
+		1, 5, 3, 1, 5,
+		1, 2, 1, 2, 6,
+		5, 1, 8, 1, 7,
+		1, 8, 1, 9, 8,
+		4, 4, 6, 7, 8
+	};
+
+	glm::ivec2 begin{ 1, 0 };
+	glm::ivec2 end(3, 4);
+
+	SECTION("All metrics in one pass") {
+		SurfaceMetrics metrics = calcSurfaceMetrics<SurfaceMetric::All>(begin, end, heights, 5, 5, 1.0f, 1.0f);
+		REQUIRE(metrics.distance == calcSurfaceDistance(begin, end, heights, 5, 5, 1.0f, 1.0f));
+
+		// the line starts at height 5 and ends at height 7
+		REQUIRE(metrics.ascent - metrics.descent == Approx(2.0f));
+		REQUIRE(metrics.ascent > 2.0f);
+		REQUIRE(metrics.maxSlope >= metrics.meanSlope);
+		REQUIRE(metrics.meanSlope == Approx((metrics.ascent + metrics.descent) / glm::length(glm::vec2(2.0f, 4.0f))));
+		REQUIRE(metrics.travelTime > glm::length(glm::vec2(2.0f, 4.0f)) / ToblerHikingSpeed()(-0.05f));
+	}
+
+	SECTION("Metrics that are not selected stay zero") {
+		SurfaceMetrics metrics = calcSurfaceMetrics<SurfaceMetric::Ascent>(begin, end, heights, 5, 5, 1.0f, 1.0f);
+		REQUIRE(metrics.ascent > 0.0f);
+		REQUIRE(metrics.descent == 0.0f);
+		REQUIRE(metrics.maxSlope == 0.0f);
+		REQUIRE(metrics.meanSlope == 0.0f);
+		REQUIRE(metrics.travelTime == 0.0f);
+	}
+
+	SECTION("Travel time on flat ground") {
+		std::vector<unsigned char> flat(25, 3);
+		SurfaceMetrics metrics = calcSurfaceMetrics<SurfaceMetric::TravelTime | SurfaceMetric::MaxSlope>(glm::ivec2(0, 0), glm::ivec2(3, 2), flat, 5, 5, 30.0f, 11.0f);
+		float length = glm::length(glm::vec2(3.0f, 2.0f)) * 30.0f;
+		REQUIRE(metrics.maxSlope == 0.0f);
+		REQUIRE(metrics.travelTime == Approx(length / (6000.0f / 3600.0f * std::exp(-0.175f))));
+	}
+
+	SECTION("Custom speed function") {
+		auto constantSpeed = [](float) { return 2.0f; };
+		SurfaceMetrics metrics = calcSurfaceMetrics<SurfaceMetric::TravelTime>(begin, end, heights, 5, 5, 1.0f, 1.0f, constantSpeed);
+		REQUIRE(metrics.travelTime == Approx(glm::length(glm::vec2(2.0f, 4.0f)) / 2.0f));
+	}
+}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "nearest.h"
+#include "distance.h"
+
+
+static std::vector<SurfaceNeighbour> findNearestByAllLines(glm::ivec2 query, std::size_t k, const std::vector<glm::ivec2>& candidates,
+	const std::vector<unsigned char>& heights, int width, int height)
+{
+	std::vector<std::pair<float, std::size_t>> all;
+	for (std::size_t i = 0; i < candidates.size(); ++i) {
+		all.emplace_back(calcSurfaceDistance(query, candidates[i], heights, width, height, 30.0f, 11.0f), i);
+	}
+
+	std::sort(all.begin(), all.end());
+	std::vector<SurfaceNeighbour> neighbours;
+	for (std::size_t i = 0; i < std::min(k, all.size()); ++i) {
+		neighbours.push_back(SurfaceNeighbour{ all[i].second, all[i].first });
+	}
+
+	return neighbours;
+}
+
+
+TEST_CASE("Test nearest candidates by surface distance", "[nearest]") {
+	const int width = 160;
+	const int height = 130;
+	std::vector<unsigned char> heights = makeTestTerrain(width, height, 60, 66, 100);
+
+	std::vector<glm::ivec2> candidates;
+	for (int i = 0; i < 3000; ++i) {
+		candidates.emplace_back((i * 53 + i / 7) % width, (i * 29 + i / 3) % height);
+	}
+
+	// a duplicate and points on the last row and column
+	candidates.push_back(candidates[100]);
+	candidates.emplace_back(0, height - 1);
+	candidates.emplace_back(width - 1, 0);
+	candidates.emplace_back(width - 1, height - 1);
+
+	SlopeBounds bounds(heights, width, height, 30.0f, 11.0f);
+	CandidateIndex index(candidates, width, height, 16);
+	REQUIRE(index.getCandidateCount() == candidates.size());
+
+	SECTION("The k nearest match all lines sorted by distance and index") {
+		const glm::ivec2 queries[] = {
+			glm::ivec2(80, 60), glm::ivec2(0, 0), glm::ivec2(62, 20), candidates[100],
+			glm::ivec2(30, height - 1), glm::ivec2(width - 1, 70), glm::ivec2(width - 1, height - 1)
+		};
+
+		for (glm::ivec2 query : queries) {
+			for (std::size_t k : { std::size_t(1), std::size_t(7), std::size_t(40) }) {
+				std::vector<SurfaceNeighbour> expect = findNearestByAllLines(query, k, candidates, heights, width, height);
+				std::vector<SurfaceNeighbour> neighbours = index.findNearest(query, k, heights, 30.0f, 11.0f, bounds);
+				REQUIRE(neighbours.size() == expect.size());
+				for (std::size_t i = 0; i < expect.size(); ++i) {
+					REQUIRE(neighbours[i].index == expect[i].index);
+					REQUIRE(neighbours[i].distance == expect[i].distance);
+				}
+			}
+		}
+	}
+
+	SECTION("Most candidates are never walked") {
+		std::size_t walkCount = 0;
+		index.findNearest(glm::ivec2(80, 60), 10, heights, 30.0f, 11.0f, bounds, &walkCount);
+		REQUIRE(walkCount > 0);
+		REQUIRE(walkCount < candidates.size() / 20);
+	}
+
+	SECTION("Small and empty requests") {
+		REQUIRE(index.findNearest(glm::ivec2(5, 5), 0, heights, 30.0f, 11.0f, bounds).empty());
+		CandidateIndex few({ glm::ivec2(1, 1), glm::ivec2(100, 100) }, width, height);
+		REQUIRE(few.findNearest(glm::ivec2(5, 5), 5, heights, 30.0f, 11.0f, bounds).size() == 2);
+		REQUIRE_THROWS_AS(index.findNearest(glm::ivec2(width, 0), 1, heights, 30.0f, 11.0f, bounds), std::out_of_range);
+		REQUIRE_THROWS_AS(CandidateIndex({ glm::ivec2(-1, 0) }, width, height), std::out_of_range);
+	}
+}
+
+
+TEST_CASE("Test nearest candidates on a large sparse grid", "[nearest]") {
+	// calcSurfaceDistance comes out short on lines of thousands of pixels, which the bounds must not prune
+	const int size = 4096;
+	std::vector<unsigned char> heights(static_cast<std::size_t>(size) * size, 40);
+
+	// the candidates lie on an arc around the corner, so the drift decides which of them are nearest
+	std::vector<glm::ivec2> candidates;
+	for (int x = 1000; x < 3500; x += 7) {
+		candidates.emplace_back(x, static_cast<int>(std::sqrt(3500.0 * 3500.0 - static_cast<double>(x) * x)));
+	}
+
+	// lines along the axes do not drift, so they come out between the shortened arc lines and their planar length
+	for (int radius = 3493; radius < 3500; ++radius) {
+		candidates.emplace_back(radius, 0);
+		candidates.emplace_back(0, radius);
+	}
+
+	SlopeBounds bounds(heights, size, size, 30.0f, 11.0f, 64);
+	CandidateIndex index(candidates, size, size, 128);
+	const glm::ivec2 queries[] = { glm::ivec2(0, 0), glm::ivec2(1, 0), glm::ivec2(0, 2), glm::ivec2(4000, 4000) };
+	for (glm::ivec2 query : queries) {
+		for (std::size_t k : { std::size_t(1), std::size_t(5) }) {
+			std::vector<SurfaceNeighbour> expect = findNearestByAllLines(query, k, candidates, heights, size, size);
+			std::vector<SurfaceNeighbour> neighbours = index.findNearest(query, k, heights, 30.0f, 11.0f, bounds);
+			REQUIRE(neighbours.size() == expect.size());
+			for (std::size_t i = 0; i < expect.size(); ++i) {
+				REQUIRE(neighbours[i].index == expect[i].index);
+				REQUIRE(neighbours[i].distance == expect[i].distance);
+			}
+		}
+	}
+}
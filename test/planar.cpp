@@ -0,0 +1,128 @@
+#include "catch.hpp"
+#include "distance.h"
+#include "planar.h"
+
+
+TEST_CASE("Test planar quadtree", "[planar]") {
+	SECTION("Flat and sloped blocks") {
+		std::vector<unsigned char> flat(17 * 17, 9);
+		PlanarQuadtree flatQuadtree(flat, 17, 17);
+		PlanarBlock block;
+		REQUIRE(flatQuadtree.findPlanarBlock(glm::ivec2(7, 12), block));
+		REQUIRE(block.corner == glm::ivec2(0, 0));
+		REQUIRE(block.size == glm::ivec2(16, 16));
+		REQUIRE(block.slope == glm::ivec2(0, 0));
+
+		std::vector<unsigned char> ramp(6 * 5);
+		for (int y = 0; y < 5; ++y) {
+			for (int x = 0; x < 6; ++x) {
+				ramp[y * 6 + x] = static_cast<unsigned char>(50 + 3 * x - 2 * y);
+			}
+		}
+
+		ramp[4 * 6 + 5] = 0;
+		PlanarQuadtree rampQuadtree(ramp, 6, 5);
+		REQUIRE(!rampQuadtree.findPlanarBlock(glm::ivec2(4, 3), block));
+		REQUIRE(rampQuadtree.findPlanarBlock(glm::ivec2(1, 1), block));
+		REQUIRE(block.corner == glm::ivec2(0, 0));
+		REQUIRE(block.size == glm::ivec2(4, 4));
+		REQUIRE(block.slope == glm::ivec2(3, -2));
+		REQUIRE(rampQuadtree.findPlanarBlock(glm::ivec2(4, 1), block));
+		REQUIRE(block.corner == glm::ivec2(4, 0));
+		REQUIRE(block.size == glm::ivec2(1, 2));
+	}
+
+	SECTION("Surface without planar voxels gives exactly calcSurfaceDistance") {
+		std::vector<unsigned char> heights(15 * 15);
+		for (int y = 0; y < 15; ++y) {
+			for (int x = 0; x < 15; ++x) {
+				heights[y * 15 + x] = static_cast<unsigned char>(x * y + 7);
+			}
+		}
+
+		PlanarQuadtree quadtree(heights, 15, 15);
+		for (int i = 0; i < 200; ++i) {
+			glm::ivec2 begin{ (i * 7) % 15, (i * 3) % 15 };
+			glm::ivec2 end{ (i * 11 + 4) % 15, (i * 5 + 9) % 15 };
+			if (begin == end) {
+				continue;
+			}
+
+			REQUIRE(calcSurfaceDistance(begin, end, heights, 15, 15, 30.0f, 11.0f, quadtree) == calcSurfaceDistance(begin, end, heights, 15, 15, 30.0f, 11.0f));
+		}
+	}
+
+	SECTION("Mixed surface matches calcSurfaceDistance") {
+		const int size = 40;
+		std::vector<unsigned char> heights(size * size);
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				unsigned char height = 20;
+				if (x >= 24) {
+					height = static_cast<unsigned char>(20 + 2 * (x - 24) + (y / 2));
+				}
+				else if (y >= 20) {
+					height = static_cast<unsigned char>(20 + (x * 13 + y * 7) % 5);
+				}
+
+				heights[y * size + x] = height;
+			}
+		}
+
+		PlanarQuadtree quadtree(heights, size, size);
+		for (int i = 0; i < 500; ++i) {
+			glm::ivec2 begin{ (i * 7) % size, (i * 13) % size };
+			glm::ivec2 end{ (i * 29 + 5) % size, (i * 17 + 11) % size };
+			if (i % 5 == 0) {
+				end.y = begin.y;
+			}
+			else if (i % 5 == 1) {
+				end = begin + glm::ivec2(glm::min(size - 1 - begin.x, size - 1 - begin.y));
+			}
+
+			if (begin == end) {
+				continue;
+			}
+
+			float expect = calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 11.0f);
+			REQUIRE(calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 11.0f, quadtree) == Approx(expect).epsilon(1e-5));
+		}
+	}
+
+	SECTION("Planar blocks are crossed without visiting their voxels") {
+		const int size = 129;
+		std::vector<unsigned char> heights(size * size, 40);
+		// a few bumps split the flat surface into planar blocks of all sizes
+		const glm::ivec2 bumps[] = { glm::ivec2(40, 90), glm::ivec2(100, 21), glm::ivec2(64, 64), glm::ivec2(13, 17), glm::ivec2(90, 110) };
+		for (glm::ivec2 bump : bumps) {
+			heights[bump.y * size + bump.x] = static_cast<unsigned char>(60 + bump.x % 7);
+		}
+
+		PlanarQuadtree quadtree(heights, size, size);
+		std::size_t voxelCount = 0;
+		glm::ivec2 begin{ 1, 3 };
+		glm::ivec2 end{ 126, 120 };
+		float distance = calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 11.0f, quadtree, &voxelCount);
+		REQUIRE(distance == Approx(calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 11.0f)).epsilon(1e-6));
+		std::size_t allVoxels = traverseRayAndVoxels(begin, end, size - 1, size - 1).size();
+		REQUIRE(voxelCount > 0);
+		REQUIRE(voxelCount * 5 < allVoxels);
+
+		for (int i = 0; i < 400; ++i) {
+			begin = glm::ivec2((i * 37) % size, (i * 53) % size);
+			end = glm::ivec2((i * 71 + 19) % size, (i * 23 + 64) % size);
+			if (i % 4 == 0) {
+				end.x = begin.x;
+			}
+
+			if (begin == end) {
+				continue;
+			}
+
+			voxelCount = 0;
+			float expect = calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 11.0f);
+			REQUIRE(calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 11.0f, quadtree, &voxelCount) == Approx(expect).epsilon(1e-6));
+			REQUIRE(voxelCount <= traverseRayAndVoxels(begin, end, size - 1, size - 1).size());
+		}
+	}
+}
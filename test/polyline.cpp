@@ -0,0 +1,66 @@
+#include "catch.hpp"
+#include "distance.h"
+#include "polyline.h"
+
+
+TEST_CASE("Test surface distance along a polyline", "[polyline]") {
+	std::vector<unsigned char> heights = {
+		1, 5, 3, 1, 5,
+		1, 2, 1, 2, 6,
+		5, 1, 8, 1, 7,
+		1, 8, 1, 9, 8,
+		4, 4, 6, 7, 8
+	};
+
+	SECTION("Integer segments match calcSurfaceDistance") {
+		PolylineSurfaceDistance polyline(heights, 5, 5, 1.0f, 1.0f);
+		glm::ivec2 vertices[] = { glm::ivec2(1, 0), glm::ivec2(3, 4), glm::ivec2(0, 2), glm::ivec2(4, 1), glm::ivec2(1, 3) };
+		float expectTotal = 0.0f;
+		REQUIRE(polyline.push(vertices[0]) == 0.0f);
+		for (int i = 1; i < 5; ++i) {
+			float expectDistance = calcSurfaceDistance(vertices[i - 1], vertices[i], heights, 5, 5, 1.0f, 1.0f);
+			REQUIRE(polyline.push(vertices[i]) == Approx(expectDistance));
+			expectTotal += expectDistance;
+		}
+
+		REQUIRE(polyline.getVertexCount() == 5);
+		REQUIRE(polyline.getTotalDistance() == Approx(expectTotal));
+	}
+
+	SECTION("Sub-pixel vertices on a tilted plane") {
+		std::vector<unsigned char> plane(6 * 6);
+		for (int y = 0; y < 6; ++y) {
+			for (int x = 0; x < 6; ++x) {
+				plane[y * 6 + x] = static_cast<unsigned char>(2 * x + y);
+			}
+		}
+
+		PolylineSurfaceDistance polyline(plane, 6, 6, 2.0f, 0.5f);
+		glm::vec2 vertices[] = { glm::vec2(0.25f, 0.5f), glm::vec2(3.75f, 1.1f), glm::vec2(3.75f, 4.9f), glm::vec2(0.0f, 5.0f) };
+		polyline.push(vertices[0]);
+		for (int i = 1; i < 4; ++i) {
+			glm::vec2 delta = vertices[i] - vertices[i - 1];
+			glm::vec3 surfaceDelta{ delta * 2.0f, (2.0f * delta.x + delta.y) * 0.5f };
+			REQUIRE(polyline.push(vertices[i]) == Approx(glm::length(surfaceDelta)));
+		}
+	}
+
+	SECTION("Splitting a segment does not change the distance") {
+		PolylineSurfaceDistance whole(heights, 5, 5, 1.0f, 1.0f);
+		whole.push(glm::vec2(0.3f, 0.2f));
+		whole.push(glm::vec2(3.9f, 3.4f));
+
+		PolylineSurfaceDistance split(heights, 5, 5, 1.0f, 1.0f);
+		for (int i = 0; i <= 10; ++i) {
+			split.push(glm::mix(glm::vec2(0.3f, 0.2f), glm::vec2(3.9f, 3.4f), i / 10.0f));
+		}
+
+		REQUIRE(split.getTotalDistance() == Approx(whole.getTotalDistance()));
+	}
+
+	SECTION("Vertex outside of the image") {
+		PolylineSurfaceDistance polyline(heights, 5, 5, 1.0f, 1.0f);
+		polyline.push(glm::vec2(1.0f, 1.0f));
+		REQUIRE_THROWS_AS(polyline.push(glm::vec2(4.5f, 1.0f)), std::out_of_range);
+	}
+}
@@ -0,0 +1,177 @@
+#include "catch.hpp"
+#include "distance.h"
+#include "profile.h"
+
+
+class CollectingSink : public ProfileSink {
+public:
+	void consume(const ProfileSample* samples, std::size_t count) override {
+		chunks.push_back(count);
+		collected.insert(collected.end(), samples, samples + count);
+	}
+
+	std::vector<std::size_t> chunks;
+	std::vector<ProfileSample> collected;
+};
+
+
+TEST_CASE("Test surface profile along a line", "[profile]") {
+	std::vector<unsigned char> heights = {
+		1, 5, 3, 1, 5,
+		1, 2, 1, 2, 6,
+		5, 1, 8, 1, 7,
+		1, 8, 1, 9, 8,
+		4, 4, 6, 7, 8
+	};
+
+	glm::ivec2 begin{ 1, 0 };
+	glm::ivec2 end(3, 4);
+
+	SECTION("Samples at every crossing end with calcSurfaceDistance") {
+		ProfileSample samples[32];
+		std::size_t count = calcSurfaceProfile(begin, end, heights, 5, 5, 2.0f, 0.5f, samples, 32);
+		REQUIRE(count == 9);
+
+		REQUIRE(samples[0].distance == 0.0f);
+		REQUIRE(samples[0].height == 2.5f);
+		REQUIRE(samples[count - 1].distance == calcSurfaceDistance(begin, end, heights, 5, 5, 2.0f, 0.5f));
+		REQUIRE(samples[count - 1].planarDistance == Approx(glm::length(glm::vec2(2.0f, 4.0f)) * 2.0f));
+		REQUIRE(samples[count - 1].height == 3.5f);
+		for (std::size_t i = 1; i < count; ++i) {
+			REQUIRE(samples[i].planarDistance > samples[i - 1].planarDistance);
+			REQUIRE(samples[i].distance >= samples[i - 1].distance);
+		}
+	}
+
+	SECTION("Buffer too small") {
+		ProfileSample samples[4];
+		REQUIRE(calcSurfaceProfile(begin, end, heights, 5, 5, 2.0f, 0.5f, samples, 4) == 9);
+	}
+
+	SECTION("Resampled at a fixed planar spacing") {
+		ProfileSample samples[64];
+		std::size_t count = calcSurfaceProfile(begin, end, heights, 5, 5, 2.0f, 0.5f, samples, 64, 0.25f);
+		float planarLength = glm::length(glm::vec2(2.0f, 4.0f)) * 2.0f;
+		REQUIRE(count == static_cast<std::size_t>(planarLength / 0.25f) + 2);
+		for (std::size_t i = 0; i < count - 1; ++i) {
+			REQUIRE(samples[i].planarDistance == Approx(i * 0.25f));
+		}
+
+		REQUIRE(samples[count - 1].planarDistance == Approx(planarLength));
+		REQUIRE(samples[count - 1].distance == calcSurfaceDistance(begin, end, heights, 5, 5, 2.0f, 0.5f));
+	}
+
+	SECTION("Sink receives the same samples in chunks") {
+		ProfileSample samples[512];
+		std::size_t count = calcSurfaceProfile(begin, end, heights, 5, 5, 2.0f, 0.5f, samples, 512, 0.02f);
+
+		CollectingSink sink;
+		calcSurfaceProfile(begin, end, heights, 5, 5, 2.0f, 0.5f, sink, 0.02f);
+		REQUIRE(sink.chunks.size() == 2);
+		REQUIRE(sink.collected.size() == count);
+		for (std::size_t i = 0; i < count; ++i) {
+			REQUIRE(sink.collected[i].distance == samples[i].distance);
+			REQUIRE(sink.collected[i].height == samples[i].height);
+		}
+	}
+
+	SECTION("Lines outside of the image") {
+		ProfileSample samples[32];
+		CollectingSink sink;
+		REQUIRE_THROWS_AS(calcSurfaceProfile(glm::ivec2(-1, 2), end, heights, 5, 5, 2.0f, 0.5f, samples, 32), std::out_of_range);
+		REQUIRE_THROWS_AS(calcSurfaceProfile(begin, glm::ivec2(3, 5), heights, 5, 5, 2.0f, 0.5f, samples, 32), std::out_of_range);
+		REQUIRE_THROWS_AS(calcSurfaceProfile(glm::ivec2(5, 0), end, heights, 5, 5, 2.0f, 0.5f, sink), std::out_of_range);
+		REQUIRE(sink.collected.empty());
+	}
+}
+
+
+TEST_CASE("Test locating a surface distance along a line", "[profile]") {
+	std::vector<unsigned char> heights = {
+		1, 5, 3, 1, 5,
+		1, 2, 1, 2, 6,
+		5, 1, 8, 1, 7,
+		1, 8, 1, 9, 8,
+		4, 4, 6, 7, 8
+	};
+
+	glm::ivec2 begin{ 1, 0 };
+	glm::ivec2 end(3, 4);
+	float total = calcSurfaceDistance(begin, end, heights, 5, 5, 2.0f, 0.5f);
+
+	SECTION("Every crossing of the profile is found again from its distance") {
+		ProfileSample samples[32];
+		std::size_t count = calcSurfaceProfile(begin, end, heights, 5, 5, 2.0f, 0.5f, samples, 32);
+		float planarLength = glm::length(glm::vec2(end - begin)) * 2.0f;
+		for (std::size_t i = 0; i < count; ++i) {
+			SurfaceLocation location = locateSurfaceDistance(begin, end, samples[i].distance, heights, 5, 5, 2.0f, 0.5f);
+			REQUIRE(location.reached);
+			REQUIRE(location.height == Approx(samples[i].height).margin(1e-5));
+			REQUIRE(glm::length(location.pixel - glm::vec2(begin)) * 2.0f == Approx(samples[i].planarDistance).margin(1e-5));
+
+			// on the line from begin to end
+			glm::vec2 offset = location.pixel - glm::vec2(begin);
+			REQUIRE(offset.x * (end - begin).y - offset.y * (end - begin).x == Approx(0.0f).margin(1e-5));
+			REQUIRE(glm::length(offset) * 2.0f <= planarLength + 1e-5f);
+		}
+
+		SurfaceLocation last = locateSurfaceDistance(begin, end, total, heights, 5, 5, 2.0f, 0.5f);
+		REQUIRE(last.reached);
+		REQUIRE(last.pixel.x == Approx(3.0f));
+		REQUIRE(last.pixel.y == Approx(4.0f));
+		REQUIRE(last.height == Approx(3.5f));
+	}
+
+	SECTION("Distances past the end of the line are not reached") {
+		SurfaceLocation location = locateSurfaceDistance(begin, end, total * 1.01f, heights, 5, 5, 2.0f, 0.5f);
+		REQUIRE_FALSE(location.reached);
+		REQUIRE(location.pixel.x == Approx(3.0f));
+		REQUIRE(location.pixel.y == Approx(4.0f));
+
+		SurfaceLocation start = locateSurfaceDistance(begin, end, 0.0f, heights, 5, 5, 2.0f, 0.5f);
+		REQUIRE(start.reached);
+		REQUIRE(start.pixel == glm::vec2(begin));
+		REQUIRE(start.height == 2.5f);
+	}
+
+	SECTION("Checkpoints in one walk match single queries") {
+		std::vector<float> distances;
+		for (float distance = 0.0f; distance < total * 1.2f; distance += 0.7f) {
+			distances.push_back(distance);
+		}
+
+		std::vector<SurfaceLocation> locations(distances.size());
+		locateSurfaceDistances(begin, end, distances.data(), distances.size(), heights, 5, 5, 2.0f, 0.5f, locations.data());
+		for (std::size_t i = 0; i < distances.size(); ++i) {
+			SurfaceLocation expect = locateSurfaceDistance(begin, end, distances[i], heights, 5, 5, 2.0f, 0.5f);
+			REQUIRE(locations[i].reached == (distances[i] <= total));
+			REQUIRE(locations[i].reached == expect.reached);
+			REQUIRE(locations[i].pixel == expect.pixel);
+			REQUIRE(locations[i].height == expect.height);
+		}
+
+		float unsorted[] = { 1.0f, 0.5f };
+		REQUIRE_THROWS_AS(locateSurfaceDistances(begin, end, unsorted, 2, heights, 5, 5, 2.0f, 0.5f, locations.data()), std::invalid_argument);
+		REQUIRE_THROWS_AS(locateSurfaceDistance(begin, end, -1.0f, heights, 5, 5, 2.0f, 0.5f), std::invalid_argument);
+		REQUIRE_THROWS_AS(locateSurfaceDistance(glm::ivec2(2, -1), end, 1.0f, heights, 5, 5, 2.0f, 0.5f), std::out_of_range);
+		REQUIRE_THROWS_AS(locateSurfaceDistances(begin, glm::ivec2(5, 4), distances.data(), 2, heights, 5, 5, 2.0f, 0.5f, locations.data()), std::out_of_range);
+	}
+
+	SECTION("Flat surfaces reach the planar distance") {
+		std::vector<unsigned char> flat(25, 3);
+		SurfaceLocation location = locateSurfaceDistance(glm::ivec2(0, 1), glm::ivec2(4, 1), 5.0f, flat, 5, 5, 2.0f, 0.5f);
+		REQUIRE(location.reached);
+		REQUIRE(location.pixel.x == Approx(2.5f));
+		REQUIRE(location.pixel.y == Approx(1.0f));
+		REQUIRE(location.height == Approx(1.5f));
+	}
+
+	SECTION("Headings run to the last pixel inside of the image") {
+		REQUIRE(findHeadingEnd(glm::ivec2(1, 0), glm::ivec2(1, 2), 5, 5) == glm::ivec2(3, 4));
+		REQUIRE(findHeadingEnd(glm::ivec2(4, 4), glm::ivec2(-3, -1), 5, 5) == glm::ivec2(1, 3));
+		REQUIRE(findHeadingEnd(glm::ivec2(2, 2), glm::ivec2(0, 1), 5, 5) == glm::ivec2(2, 4));
+		REQUIRE(findHeadingEnd(glm::ivec2(2, 2), glm::ivec2(5, 0), 5, 5) == glm::ivec2(2, 2));
+		REQUIRE_THROWS_AS(findHeadingEnd(glm::ivec2(2, 2), glm::ivec2(0, 0), 5, 5), std::invalid_argument);
+		REQUIRE_THROWS_AS(findHeadingEnd(glm::ivec2(5, 2), glm::ivec2(1, 0), 5, 5), std::out_of_range);
+	}
+}
@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <fstream>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "raster.h"
+#include "distance.h"
+
+
+TEST_CASE("Test the one to all surface distance raster", "[raster]") {
+	const int width = 97;
+	const int height = 83;
+	std::vector<unsigned char> heights = makeTestTerrain(width, height, 40, 46, height);
+
+	ThreadPool pool(3);
+	auto requireLines = [&](glm::ivec2 source, glm::ivec2 windowBegin, int windowWidth, int windowHeight) {
+		std::vector<float> distances(windowWidth * windowHeight, -1.0f);
+		calcSurfaceDistanceRaster(source, windowBegin, windowWidth, windowHeight, heights, width, height, 30.0f, 11.0f, distances.data(), pool);
+		for (int y = 0; y < windowHeight; ++y) {
+			for (int x = 0; x < windowWidth; ++x) {
+				glm::ivec2 pixel = windowBegin + glm::ivec2(x, y);
+				float expect = pixel == source ? 0.0f : calcSurfaceDistance(source, pixel, heights, width, height, 30.0f, 11.0f);
+				REQUIRE(distances[y * windowWidth + x] == Approx(expect).epsilon(1e-5).margin(1e-2));
+			}
+		}
+	};
+
+	SECTION("Every pixel gets the distance of its line, the source inside of the window") {
+		requireLines(glm::ivec2(48, 30), glm::ivec2(0, 0), width, height);
+		requireLines(glm::ivec2(0, 0), glm::ivec2(0, 0), width, height);
+		requireLines(glm::ivec2(width - 2, height - 2), glm::ivec2(60, 50), width - 60, height - 50);
+	}
+
+	SECTION("Every pixel gets the distance of its line, the source outside of the window") {
+		requireLines(glm::ivec2(5, 70), glm::ivec2(50, 10), 30, 25);
+		requireLines(glm::ivec2(90, 2), glm::ivec2(0, 40), 20, 1);
+	}
+
+	SECTION("The raster is written through a mapped file") {
+		const std::string filename = "test_raster.raw";
+		writeSurfaceDistanceRaster(filename, glm::ivec2(20, 20), glm::ivec2(10, 5), 40, 30, heights, width, height, 30.0f, 11.0f, pool);
+		std::vector<float> distances(40 * 30);
+		calcSurfaceDistanceRaster(glm::ivec2(20, 20), glm::ivec2(10, 5), 40, 30, heights, width, height, 30.0f, 11.0f, distances.data(), pool);
+
+		std::vector<float> written(distances.size());
+		std::ifstream file(filename, std::ios::binary);
+		file.read(reinterpret_cast<char*>(written.data()), written.size() * sizeof(float));
+		REQUIRE(file.gcount() == static_cast<std::streamsize>(written.size() * sizeof(float)));
+		file.close();
+		REQUIRE(written == distances);
+		std::remove(filename.c_str());
+	}
+
+	SECTION("Sources and windows outside of the image throw") {
+		std::vector<float> distances(100);
+		REQUIRE_THROWS_AS(calcSurfaceDistanceRaster(glm::ivec2(width, 0), glm::ivec2(0, 0), 10, 10, heights, width, height, 30.0f, 11.0f, distances.data(), pool),
+			std::out_of_range);
+		REQUIRE_THROWS_AS(calcSurfaceDistanceRaster(glm::ivec2(0, 0), glm::ivec2(90, 0), 10, 10, heights, width, height, 30.0f, 11.0f, distances.data(), pool),
+			std::out_of_range);
+	}
+}
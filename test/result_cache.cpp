@@ -0,0 +1,123 @@
+#include <atomic>
+#include "catch.hpp"
+#include "result_cache.h"
+#include "distance.h"
+
+
+TEST_CASE("Test the surface distance result cache", "[result_cache]") {
+	const int width = 60;
+	const int height = 50;
+	std::vector<unsigned char> heights(width * height);
+	for (int i = 0; i < width * height; ++i) {
+		heights[i] = static_cast<unsigned char>((i * 37 + i / width * 91) % 41);
+	}
+
+	const DatasetKey dataset{ 7, 1 };
+
+	SECTION("Keys ignore the direction of the line and include the dataset version") {
+		ResultCache cache(1 << 16);
+		float distance = -1.0f;
+		REQUIRE_FALSE(cache.lookup(dataset, glm::ivec2(3, 4), glm::ivec2(20, 9), distance));
+		cache.insert(dataset, glm::ivec2(3, 4), glm::ivec2(20, 9), 12.5f);
+		REQUIRE(cache.lookup(dataset, glm::ivec2(3, 4), glm::ivec2(20, 9), distance));
+		REQUIRE(distance == 12.5f);
+		REQUIRE(cache.lookup(dataset, glm::ivec2(20, 9), glm::ivec2(3, 4), distance));
+		REQUIRE(distance == 12.5f);
+		REQUIRE_FALSE(cache.lookup(DatasetKey{ 7, 2 }, glm::ivec2(3, 4), glm::ivec2(20, 9), distance));
+		REQUIRE_FALSE(cache.lookup(DatasetKey{ 8, 1 }, glm::ivec2(3, 4), glm::ivec2(20, 9), distance));
+
+		cache.insert(dataset, glm::ivec2(20, 9), glm::ivec2(3, 4), 13.0f);
+		REQUIRE(cache.lookup(dataset, glm::ivec2(3, 4), glm::ivec2(20, 9), distance));
+		REQUIRE(distance == 13.0f);
+
+		ResultCacheStats stats = cache.getStats();
+		REQUIRE(stats.hits == 3);
+		REQUIRE(stats.misses == 3);
+		REQUIRE(stats.insertions == 2);
+		REQUIRE(stats.evictions == 0);
+	}
+
+	SECTION("Invalidating a dataset drops all its versions") {
+		ResultCache cache(1 << 16);
+		cache.insert(DatasetKey{ 7, 1 }, glm::ivec2(1, 1), glm::ivec2(2, 2), 1.0f);
+		cache.insert(DatasetKey{ 7, 2 }, glm::ivec2(1, 1), glm::ivec2(2, 2), 2.0f);
+		cache.insert(DatasetKey{ 9, 1 }, glm::ivec2(1, 1), glm::ivec2(2, 2), 3.0f);
+		cache.invalidate(7);
+
+		float distance;
+		REQUIRE_FALSE(cache.lookup(DatasetKey{ 7, 1 }, glm::ivec2(1, 1), glm::ivec2(2, 2), distance));
+		REQUIRE_FALSE(cache.lookup(DatasetKey{ 7, 2 }, glm::ivec2(1, 1), glm::ivec2(2, 2), distance));
+		REQUIRE(cache.lookup(DatasetKey{ 9, 1 }, glm::ivec2(1, 1), glm::ivec2(2, 2), distance));
+		REQUIRE(distance == 3.0f);
+
+		cache.clear();
+		REQUIRE_FALSE(cache.lookup(DatasetKey{ 9, 1 }, glm::ivec2(1, 1), glm::ivec2(2, 2), distance));
+	}
+
+	SECTION("A full set evicts the entries that were not hit since the hand passed") {
+		// the smallest cache is a single set of 8 entries
+		ResultCache cache(1, 1);
+		REQUIRE(cache.getCapacity() == 8);
+		for (int i = 0; i < 8; ++i) {
+			cache.insert(dataset, glm::ivec2(0, 0), glm::ivec2(i, 1), static_cast<float>(i));
+		}
+
+		float distance;
+		for (int i = 0; i < 4; ++i) {
+			REQUIRE(cache.lookup(dataset, glm::ivec2(0, 0), glm::ivec2(i, 1), distance));
+		}
+
+		for (int i = 8; i < 12; ++i) {
+			cache.insert(dataset, glm::ivec2(0, 0), glm::ivec2(i, 1), static_cast<float>(i));
+		}
+
+		REQUIRE(cache.getStats().evictions == 4);
+		for (int i = 0; i < 12; ++i) {
+			bool kept = i < 4 || i >= 8;
+			REQUIRE(cache.lookup(dataset, glm::ivec2(0, 0), glm::ivec2(i, 1), distance) == kept);
+			if (kept) {
+				REQUIRE(distance == static_cast<float>(i));
+			}
+		}
+	}
+
+	SECTION("Cached distances are those of the line from the smaller endpoint") {
+		ResultCache cache(1 << 20);
+		glm::ivec2 a{ 40, 3 };
+		glm::ivec2 b{ 5, 44 };
+		float expect = calcSurfaceDistance(b, a, heights, width, height, 30.0f, 11.0f);
+		REQUIRE(calcSurfaceDistance(a, b, heights, width, height, 30.0f, 11.0f, cache, dataset) == expect);
+		REQUIRE(calcSurfaceDistance(b, a, heights, width, height, 30.0f, 11.0f, cache, dataset) == expect);
+		REQUIRE(cache.getStats().hits == 1);
+		REQUIRE(cache.getStats().misses == 1);
+	}
+
+	SECTION("Batches through the cache from many threads") {
+		ResultCache cache(1 << 20);
+		ThreadPool pool(4);
+		std::vector<SurfaceQuery> queries;
+		for (int i = 0; i < 2000; ++i) {
+			glm::ivec2 begin{ (i * 7) % 13, (i * 3) % 11 };
+			glm::ivec2 end{ width - 1 - (i * 5) % 17, height - 1 - (i * 11) % 7 };
+			queries.push_back(i % 2 ? SurfaceQuery{ begin, end } : SurfaceQuery{ end, begin });
+		}
+
+		std::vector<float> distances(queries.size());
+		for (int round = 0; round < 3; ++round) {
+			calcSurfaceDistances(queries.data(), queries.size(), heights, width, height, 30.0f, 11.0f, distances.data(), pool, cache, dataset);
+			for (std::size_t i = 0; i < queries.size(); ++i) {
+				glm::ivec2 begin = queries[i].begin;
+				glm::ivec2 end = queries[i].end;
+				if (end.x < begin.x || (end.x == begin.x && end.y < begin.y)) {
+					std::swap(begin, end);
+				}
+
+				REQUIRE(distances[i] == calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f));
+			}
+		}
+
+		ResultCacheStats stats = cache.getStats();
+		REQUIRE(stats.hits + stats.misses == 3 * queries.size());
+		REQUIRE(stats.hits >= 2 * queries.size());
+	}
+}
@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include "catch.hpp"
+#include "distance.h"
+#include "io.h"
+#include "shard.h"
+
+
+static std::vector<unsigned char> makeHeights(int imageWidth, int imageHeight) {
+	std::vector<unsigned char> heights(imageWidth * imageHeight);
+	for (int y = 0; y < imageHeight; ++y) {
+		for (int x = 0; x < imageWidth; ++x) {
+			heights[y * imageWidth + x] = static_cast<unsigned char>((x * 7 + y * 13 + x * y) % 23);
+		}
+	}
+
+	return heights;
+}
+
+
+static std::vector<SurfaceQuery> makeQueries(int imageWidth, int imageHeight, int count) {
+	std::vector<SurfaceQuery> queries;
+	for (int i = 0; i < count; ++i) {
+		glm::ivec2 begin{ (i * 5) % imageWidth, (i * 11) % imageHeight };
+		glm::ivec2 end{ (i * 17 + 3) % imageWidth, (i * 3 + 7) % imageHeight };
+		queries.push_back(SurfaceQuery{ begin, end });
+	}
+
+	return queries;
+}
+
+
+TEST_CASE("Test planning shards", "[shard]") {
+	const int imageWidth = 40;
+	const int imageHeight = 30;
+	std::vector<SurfaceQuery> queries = makeQueries(imageWidth, imageHeight, 200);
+
+	SECTION("Every query is assigned to exactly one shard") {
+		auto shards = planShards(queries, imageWidth, imageHeight, 8, 4);
+		REQUIRE(shards.size() == 4);
+
+		std::vector<int> assigned(queries.size(), 0);
+		for (const ShardManifest& shard : shards) {
+			REQUIRE(!shard.queries.empty());
+			for (std::size_t i = 0; i < shard.queries.size(); ++i) {
+				const SurfaceQuery& query = queries[shard.queryIndices[i]];
+				REQUIRE(shard.queries[i].begin == query.begin);
+				REQUIRE(shard.queries[i].end == query.end);
+				REQUIRE(glm::all(glm::greaterThanEqual(glm::min(query.begin, query.end) / 8, shard.tileMin)));
+				REQUIRE(glm::all(glm::lessThanEqual(glm::max(query.begin, query.end) / 8, shard.tileMax)));
+				++assigned[shard.queryIndices[i]];
+			}
+		}
+
+		REQUIRE(std::all_of(assigned.begin(), assigned.end(), [](int count) { return count == 1; }));
+	}
+
+	SECTION("Manifest survives a round trip through a file") {
+		auto shards = planShards(queries, imageWidth, imageHeight, 8, 3);
+		writeShardManifest("test_shard.manifest", shards[1]);
+		ShardManifest manifest = readShardManifest("test_shard.manifest");
+		std::remove("test_shard.manifest");
+
+		REQUIRE(manifest.shardIndex == 1);
+		REQUIRE(manifest.shardCount == 3);
+		REQUIRE(manifest.tileMin == shards[1].tileMin);
+		REQUIRE(manifest.tileMax == shards[1].tileMax);
+		REQUIRE(manifest.queryIndices == shards[1].queryIndices);
+	}
+
+	SECTION("Query outside of the image") {
+		queries.push_back(SurfaceQuery{ glm::ivec2(0, 0), glm::ivec2(imageWidth, 0) });
+		REQUIRE_THROWS_AS(planShards(queries, imageWidth, imageHeight, 8, 2), std::out_of_range);
+	}
+}
+
+
+TEST_CASE("Test running and merging shards", "[shard]") {
+	const int imageWidth = 40;
+	const int imageHeight = 30;
+	std::vector<unsigned char> heights = makeHeights(imageWidth, imageHeight);
+	std::vector<SurfaceQuery> queries = makeQueries(imageWidth, imageHeight, 120);
+	auto shards = planShards(queries, imageWidth, imageHeight, 16, 3);
+	ThreadPool pool(2);
+
+	SECTION("Merged results are in query order") {
+		std::vector<std::string> resultFiles;
+		for (const ShardManifest& shard : shards) {
+			resultFiles.push_back("test_shard." + std::to_string(shard.shardIndex) + ".results");
+			std::remove(resultFiles.back().c_str());
+			REQUIRE(runShard(shard, resultFiles.back(), heights, 2.0f, 0.5f, pool, 7) == shard.queries.size());
+		}
+
+		std::vector<float> distances = mergeShardResults(resultFiles, queries.size());
+		for (const std::string& resultFile : resultFiles) {
+			std::remove(resultFile.c_str());
+		}
+
+		for (std::size_t i = 0; i < queries.size(); ++i) {
+			REQUIRE(distances[i] == calcSurfaceDistance(queries[i].begin, queries[i].end, heights, imageWidth, imageHeight, 2.0f, 0.5f));
+		}
+	}
+
+	SECTION("Resume after a crash in the middle of a line") {
+		const ShardManifest& shard = shards[0];
+		std::string resultFile = "test_shard.resume.results";
+		{
+			std::ofstream partial(resultFile, std::ios::trunc);
+			partial << shard.queryIndices[0] << " 1.5\n" << shard.queryIndices[1] << " 2.";
+		}
+
+		REQUIRE(runShard(shard, resultFile, heights, 2.0f, 0.5f, pool) == shard.queries.size() - 1);
+		REQUIRE(runShard(shard, resultFile, heights, 2.0f, 0.5f, pool) == 0);
+
+		std::vector<std::string> resultFiles = { resultFile };
+		REQUIRE_THROWS_AS(mergeShardResults(resultFiles, queries.size()), std::runtime_error);
+		std::remove(resultFile.c_str());
+	}
+
+	SECTION("Workers read only the tiles of their shard") {
+		{
+			std::ofstream file("test_shard.heights", std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(heights.data()), heights.size());
+		}
+
+		// the tiles (0, 0) - (1, 1) of 8 pixels, and one pixel around them
+		std::vector<SurfaceQuery> local = {
+			SurfaceQuery{ glm::ivec2(1, 2), glm::ivec2(12, 9) },
+			SurfaceQuery{ glm::ivec2(12, 0), glm::ivec2(0, 10) },
+			SurfaceQuery{ glm::ivec2(5, 15), glm::ivec2(15, 1) }
+		};
+
+		ShardManifest shard = planShards(local, imageWidth, imageHeight, 8, 1)[0];
+		std::vector<unsigned char> window = readShardHeightData("test_shard.heights", shard);
+		REQUIRE(window.size() == heights.size());
+		for (int y = 0; y < imageHeight; ++y) {
+			for (int x = 0; x < imageWidth; ++x) {
+				REQUIRE(window[y * imageWidth + x] == (x <= 16 && y <= 16 ? heights[y * imageWidth + x] : 0));
+			}
+		}
+
+		std::string resultFile = "test_shard.window.results";
+		std::remove(resultFile.c_str());
+		REQUIRE(runShard(shard, resultFile, window, 2.0f, 0.5f, pool) == local.size());
+		std::vector<float> distances = mergeShardResults({ resultFile }, local.size());
+		std::remove(resultFile.c_str());
+		for (std::size_t i = 0; i < local.size(); ++i) {
+			REQUIRE(distances[i] == calcSurfaceDistance(local[i].begin, local[i].end, heights, imageWidth, imageHeight, 2.0f, 0.5f));
+		}
+
+		REQUIRE_THROWS_AS(readHeightData("test_shard.heights", imageWidth, imageHeight + 1, glm::ivec2(0, 0), glm::ivec2(3, imageHeight)), std::runtime_error);
+		std::remove("test_shard.heights");
+	}
+}
@@ -0,0 +1,96 @@
+#include <cmath>
+#include <limits>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "slope_bounds.h"
+#include "distance.h"
+
+
+TEST_CASE("Test slope bounds of the surface distance", "[slope_bounds]") {
+	const int width = 101;
+	const int height = 77;
+	std::vector<unsigned char> heights = makeTestTerrain(width, height, 60, 66, height);
+
+	SlopeBounds bounds(heights, width, height, 30.0f, 11.0f, 8);
+
+	SECTION("Tiles cover the voxels") {
+		REQUIRE(bounds.getTileSize() == 8);
+		REQUIRE(bounds.getTileCount() == glm::ivec2(13, 10));
+		REQUIRE(bounds.getMaxSecant(glm::ivec2(0, 0)) >= 1.0f);
+
+		// the wall between x = 60 and x = 66 rises at least 97 * 11 meters over one pixel of 30 meters
+		REQUIRE(bounds.getMaxSecant(glm::ivec2(7, 3)) >= std::sqrt(1.0f + 35.0f * 35.0f));
+	}
+
+	SECTION("Lines lie between their bounds") {
+		for (int i = 0; i < 2000; ++i) {
+			glm::ivec2 begin{ (i * 53) % width, (i * 29) % height };
+			glm::ivec2 end{ (i * 17 + 31) % width, (i * 61 + 5) % height };
+			float distance = calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f);
+			REQUIRE(bounds.getLowerBound(begin, end) <= distance);
+			REQUIRE(bounds.getUpperBound(begin, end) >= distance);
+		}
+	}
+
+	SECTION("Flat surfaces are bound by the planar distance") {
+		std::vector<unsigned char> flat(width * height, 40);
+		SlopeBounds flatBounds(flat, width, height, 30.0f, 11.0f);
+		REQUIRE(flatBounds.getMaxSecant(glm::ivec2(3, 3), glm::ivec2(90, 70)) == 1.0f);
+		REQUIRE(flatBounds.getUpperBound(glm::ivec2(0, 0), glm::ivec2(3, 4)) == Approx(150.0f).epsilon(2e-3));
+		REQUIRE(flatBounds.getLowerBound(glm::ivec2(0, 0), glm::ivec2(3, 4)) == Approx(150.0f).epsilon(2e-3));
+	}
+
+	SECTION("Threshold queries agree with calcSurfaceDistance") {
+		for (int i = 0; i < 500; ++i) {
+			glm::ivec2 begin{ (i * 53) % width, (i * 29) % height };
+			glm::ivec2 end{ (i * 17 + 31) % width, (i * 61 + 5) % height };
+			float distance = calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f);
+			for (const SlopeBounds* withBounds : { static_cast<const SlopeBounds*>(nullptr), static_cast<const SlopeBounds*>(&bounds) }) {
+				REQUIRE(isSurfaceDistanceWithin(begin, end, distance, heights, width, height, 30.0f, 11.0f, withBounds));
+				REQUIRE(isSurfaceDistanceWithin(begin, end, distance * 1.5f + 1.0f, heights, width, height, 30.0f, 11.0f, withBounds));
+				REQUIRE(isSurfaceDistanceWithin(begin, end, distance * 0.99f, heights, width, height, 30.0f, 11.0f, withBounds) == (distance == 0.0f));
+			}
+		}
+
+		// the bounds answer without the height data
+		std::vector<unsigned char> noHeights;
+		REQUIRE(isSurfaceDistanceWithin(glm::ivec2(0, 0), glm::ivec2(50, 0), 1000.0f, noHeights, width, height, 30.0f, 11.0f, &bounds) == false);
+		float upper = bounds.getUpperBound(glm::ivec2(0, 0), glm::ivec2(10, 5));
+		REQUIRE(isSurfaceDistanceWithin(glm::ivec2(0, 0), glm::ivec2(10, 5), upper, noHeights, width, height, 30.0f, 11.0f, &bounds));
+	}
+
+	SECTION("Lines along the last row or column are not bound") {
+		REQUIRE(bounds.isAlongLastRowOrColumn(glm::ivec2(0, height - 1), glm::ivec2(40, height - 1)));
+		REQUIRE(bounds.isAlongLastRowOrColumn(glm::ivec2(width - 1, 3), glm::ivec2(width - 1, 50)));
+		REQUIRE_FALSE(bounds.isAlongLastRowOrColumn(glm::ivec2(width - 1, height - 1), glm::ivec2(width - 1, height - 1)));
+		REQUIRE(bounds.getLowerBound(glm::ivec2(0, height - 1), glm::ivec2(40, height - 1)) == 0.0f);
+		REQUIRE(bounds.getUpperBound(glm::ivec2(0, height - 1), glm::ivec2(40, height - 1)) == std::numeric_limits<float>::infinity());
+		REQUIRE_THROWS_AS(SlopeBounds(heights, 1, 1, 30.0f, 11.0f), std::invalid_argument);
+	}
+}
+
+
+TEST_CASE("Test slope bounds on long lines", "[slope_bounds]") {
+	// calcSurfaceDistance comes out short on lines of thousands of pixels, so the bounds must not decide them
+	const int size = 4096;
+	std::vector<unsigned char> flat(static_cast<std::size_t>(size) * size, 40);
+	SlopeBounds bounds(flat, size, size, 30.0f, 11.0f, 64);
+
+	for (int i = 0; i < 300; ++i) {
+		glm::ivec2 begin{ (i * 1237) % size, (i * 2711 + 13) % size };
+		glm::ivec2 end{ (i * 3037 + 500) % size, (i * 769 + 2900) % size };
+		float distance = calcSurfaceDistance(begin, end, flat, size, size, 30.0f, 11.0f);
+		REQUIRE(bounds.getLowerBound(begin, end) <= distance);
+		REQUIRE(bounds.getUpperBound(begin, end) >= distance);
+
+		for (float limit : { distance, std::nextafter(distance, 0.0f), distance * 0.999f, distance * 1.001f }) {
+			REQUIRE(isSurfaceDistanceWithin(begin, end, limit, flat, size, size, 30.0f, 11.0f, &bounds)
+				== isSurfaceDistanceWithin(begin, end, limit, flat, size, size, 30.0f, 11.0f));
+		}
+	}
+
+	// the ring cutoff of findNearest needs a lower bound that grows with the length
+	for (float length = 0.0f; length < 8000.0f; length += 250.0f) {
+		REQUIRE(bounds.getLowerBound(length) <= bounds.getLowerBound(length + 250.0f));
+	}
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "standing_query.h"
+#include "distance.h"
+
+
+TEST_CASE("Test standing queries under height map patches", "[standing_query]") {
+	const int width = 200;
+	const int height = 150;
+	std::vector<unsigned char> heights = makeTestTerrain(width, height, 60, 66, height);
+
+	StandingQueryRegistry registry(heights, width, height, 30.0f, 11.0f, 16);
+	std::vector<glm::ivec2> begins;
+	std::vector<glm::ivec2> ends;
+	for (int i = 0; i < 400; ++i) {
+		begins.emplace_back((i * 53) % width, (i * 29) % height);
+		ends.emplace_back((i * 17 + 31) % width, (i * 61 + 5) % height);
+		REQUIRE(registry.registerQuery(begins.back(), ends.back()) == static_cast<std::size_t>(i));
+	}
+
+	// a line along the last row, which calcSurfaceDistance does not walk
+	begins.emplace_back(10, height - 1);
+	ends.emplace_back(150, height - 1);
+	registry.registerQuery(begins.back(), ends.back());
+	REQUIRE(registry.getQueryCount() == begins.size());
+
+	auto requireCurrent = [&]() {
+		for (std::size_t i = 0; i < begins.size(); ++i) {
+			float expect = calcSurfaceDistance(begins[i], ends[i], registry.getHeightData(), width, height, 30.0f, 11.0f);
+			REQUIRE(registry.getDistance(i) == Approx(expect).epsilon(1e-5).margin(1e-3));
+		}
+	};
+
+	SECTION("Registered lines start with calcSurfaceDistance") {
+		requireCurrent();
+		REQUIRE(registry.getDistance(begins.size() - 1) == 0.0f);
+	}
+
+	SECTION("Patches update exactly the lines whose voxels they touch") {
+		const glm::ivec2 corners[] = { glm::ivec2(90, 40), glm::ivec2(0, 0), glm::ivec2(width - 8, height - 5), glm::ivec2(63, 100) };
+		std::size_t totalVoxels = 0;
+		for (std::size_t i = 0; i < begins.size(); ++i) {
+			totalVoxels += traverseRayAndVoxels(begins[i], ends[i], width - 1, height - 1).size();
+		}
+
+		for (glm::ivec2 corner : corners) {
+			const int patchWidth = 8;
+			const int patchHeight = 5;
+			std::vector<unsigned char> patch(patchWidth * patchHeight);
+			for (std::size_t i = 0; i < patch.size(); ++i) {
+				patch[i] = static_cast<unsigned char>(200 - i * 3);
+			}
+
+			std::vector<float> before;
+			for (std::size_t i = 0; i < begins.size(); ++i) {
+				before.push_back(registry.getDistance(i));
+			}
+
+			std::vector<std::size_t> affected = registry.applyPatch(corner, patchWidth, patchHeight, patch);
+			REQUIRE(std::is_sorted(affected.begin(), affected.end()));
+			REQUIRE(registry.getHeightData()[(corner.y + 2) * width + corner.x + 3] == patch[2 * patchWidth + 3]);
+			REQUIRE(registry.getLastPatchVoxelCount() > 0);
+			REQUIRE(registry.getLastPatchVoxelCount() < totalVoxels / 5);
+
+			requireCurrent();
+			for (std::size_t i = 0; i < begins.size(); ++i) {
+				if (!std::binary_search(affected.begin(), affected.end(), i)) {
+					REQUIRE(registry.getDistance(i) == before[i]);
+				}
+			}
+		}
+	}
+
+	SECTION("Patches must fit into the image") {
+		REQUIRE_THROWS_AS(registry.applyPatch(glm::ivec2(width - 2, 0), 4, 1, std::vector<unsigned char>(4)), std::out_of_range);
+		REQUIRE_THROWS_AS(registry.applyPatch(glm::ivec2(0, 0), 4, 2, std::vector<unsigned char>(7)), std::invalid_argument);
+		REQUIRE_THROWS_AS(registry.registerQuery(glm::ivec2(0, 0), glm::ivec2(0, height)), std::out_of_range);
+		REQUIRE(registry.applyPatch(glm::ivec2(3, 3), 0, 0, std::vector<unsigned char>()).empty());
+	}
+}
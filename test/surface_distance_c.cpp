@@ -0,0 +1,101 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "test_terrain.h"
+#include "surface_distance_c.h"
+#include "distance.h"
+#include "slope_bounds.h"
+
+
+TEST_CASE("Test the C interface", "[surface_distance_c]") {
+	const int width = 120;
+	const int height = 90;
+	std::vector<unsigned char> heights = makeTestTerrain(width, height, 60, 66, height);
+
+	sd_dataset* dataset = nullptr;
+	REQUIRE(sd_dataset_create(heights.data(), width, height, 30.0f, 11.0f, 2, &dataset) == SD_OK);
+	REQUIRE(dataset != nullptr);
+
+	std::vector<int32_t> endpoints;
+	for (int i = 0; i < 200; ++i) {
+		endpoints.insert(endpoints.end(), { (i * 53) % width, (i * 29) % height, (i * 17 + 31) % width, (i * 61 + 5) % height });
+	}
+
+	SECTION("Batches match calcSurfaceDistance") {
+		std::vector<float> distances(200);
+		REQUIRE(sd_surface_distances(dataset, endpoints.data(), 200, distances.data()) == SD_OK);
+		std::vector<unsigned char> within(200);
+		REQUIRE(sd_surface_distances_within(dataset, endpoints.data(), 200, 2000.0f, within.data()) == SD_OK);
+		for (int i = 0; i < 200; ++i) {
+			glm::ivec2 begin(endpoints[4 * i], endpoints[4 * i + 1]);
+			glm::ivec2 end(endpoints[4 * i + 2], endpoints[4 * i + 3]);
+			REQUIRE(distances[i] == calcSurfaceDistance(begin, end, heights, width, height, 30.0f, 11.0f));
+			REQUIRE(within[i] == (isSurfaceDistanceWithin(begin, end, 2000.0f, heights, width, height, 30.0f, 11.0f) ? 1 : 0));
+		}
+
+		float distance = 0.0f;
+		REQUIRE(sd_surface_distance(dataset, endpoints[4], endpoints[5], endpoints[6], endpoints[7], &distance) == SD_OK);
+		REQUIRE(distance == distances[1]);
+		REQUIRE(sd_surface_distances(dataset, nullptr, 0, nullptr) == SD_OK);
+	}
+
+	SECTION("Concurrent batches do not wait for each other") {
+		std::vector<float> expect(200);
+		for (int i = 0; i < 200; ++i) {
+			expect[i] = calcSurfaceDistance(glm::ivec2(endpoints[4 * i], endpoints[4 * i + 1]), glm::ivec2(endpoints[4 * i + 2], endpoints[4 * i + 3]),
+				heights, width, height, 30.0f, 11.0f);
+		}
+
+		std::atomic<int> mismatches{ 0 };
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t) {
+			threads.emplace_back([&]() {
+				std::vector<float> distances(200);
+				for (int call = 0; call < 25; ++call) {
+					if (sd_surface_distances(dataset, endpoints.data(), 200, distances.data()) != SD_OK || distances != expect) {
+						++mismatches;
+					}
+				}
+			});
+		}
+
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		REQUIRE(mismatches.load() == 0);
+	}
+
+	SECTION("Publishing replaces the height map") {
+		std::vector<unsigned char> flat(width * height, 0);
+		uint32_t version = 0;
+		REQUIRE(sd_dataset_publish(dataset, flat.data(), width, height, 30.0f, 11.0f, &version) == SD_OK);
+		REQUIRE(version == 1);
+		REQUIRE(sd_dataset_version(dataset, &version) == SD_OK);
+		REQUIRE(version == 1);
+
+		float distance = 0.0f;
+		REQUIRE(sd_surface_distance(dataset, 0, 0, 100, 0, &distance) == SD_OK);
+		REQUIRE(distance == Approx(3000.0f));
+	}
+
+	SECTION("Errors are reported as codes") {
+		float distance = 0.0f;
+		REQUIRE(sd_surface_distance(dataset, 0, 0, width, 0, &distance) == SD_ERROR_OUT_OF_RANGE);
+		endpoints[6] = -1;
+		std::vector<float> distances(200, -1.0f);
+		REQUIRE(sd_surface_distances(dataset, endpoints.data(), 200, distances.data()) == SD_ERROR_OUT_OF_RANGE);
+		REQUIRE(distances[0] == -1.0f);
+		REQUIRE(sd_surface_distance(nullptr, 0, 0, 1, 1, &distance) == SD_ERROR_INVALID_ARGUMENT);
+		REQUIRE(sd_surface_distances(dataset, nullptr, 3, distances.data()) == SD_ERROR_INVALID_ARGUMENT);
+		REQUIRE(sd_dataset_publish(dataset, nullptr, width, height, 30.0f, 11.0f, nullptr) == SD_ERROR_INVALID_ARGUMENT);
+
+		sd_dataset* invalid = nullptr;
+		REQUIRE(sd_dataset_create(heights.data(), 0, height, 30.0f, 11.0f, 1, &invalid) == SD_ERROR_INVALID_ARGUMENT);
+		REQUIRE(invalid == nullptr);
+		REQUIRE(std::string(sd_status_message(SD_ERROR_BUSY)) == "too many concurrent calls on the dataset");
+	}
+
+	sd_dataset_destroy(dataset);
+}
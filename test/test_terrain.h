@@ -0,0 +1,25 @@
+#ifndef TEST_TERRAIN_H
+#define TEST_TERRAIN_H
+
+#include <vector>
+
+
+/*********
+Rough synthetic terrain for the tests: noise between 0 and 22 height units, and a wall 120 units higher
+over the columns wallBegin < x < wallEnd of the rows y < wallRows, which lines have to climb or go around.
+offset shifts the noise, e.g. to make another version of the same terrain.
+**********/
+inline std::vector<unsigned char> makeTestTerrain(int width, int height, int wallBegin, int wallEnd, int wallRows, int offset = 0) {
+	std::vector<unsigned char> heights(width * height);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			bool wall = x > wallBegin && x < wallEnd && y < wallRows;
+			heights[y * width + x] = static_cast<unsigned char>((x * 37 + y * 91 + x * y * 7 + offset) % 23 + (wall ? 120 : 0));
+		}
+	}
+
+	return heights;
+}
+
+
+#endif // !TEST_TERRAIN_H
@@ -0,0 +1,75 @@
+#include <cmath>
+#include "catch.hpp"
+#include "distance.h"
+#include "tin.h"
+
+
+TEST_CASE("Test triangulated irregular network", "[tin]") {
+	ThreadPool pool(2);
+
+	SECTION("Exact network keeps the surface") {
+		const int size = 41;
+		std::vector<unsigned char> heights(size * size);
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				unsigned char height = static_cast<unsigned char>(30 + x - y);
+				if (x > 20 && y > 12) {
+					height = static_cast<unsigned char>(60 + (x * 7 + y * 13) % 9);
+				}
+
+				heights[y * size + x] = height;
+			}
+		}
+
+		SimplifiedTin tin(heights, size, size, 11.0f, 0.0f, pool);
+		REQUIRE(tin.getTriangleCount() < 2 * (size - 1) * (size - 1));
+
+		TinSquare square = tin.findSquare(glm::ivec2(3, 5));
+		REQUIRE(square.size == 16);
+		REQUIRE(square.corner == glm::ivec2(0, 0));
+
+		for (int i = 0; i < 600; ++i) {
+			glm::ivec2 begin{ (i * 7) % size, (i * 13) % size };
+			glm::ivec2 end{ (i * 29 + 5) % size, (i * 17 + 11) % size };
+			if (i % 4 == 0) {
+				end.x = begin.x;
+			}
+			else if (i % 4 == 1) {
+				int length = glm::min(begin.x, size - 1 - begin.y);
+				end = begin + glm::ivec2(-length, length);
+			}
+
+			if (begin == end) {
+				continue;
+			}
+
+			float expect = calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 11.0f);
+			REQUIRE(calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 11.0f, tin) == Approx(expect).epsilon(1e-5).margin(1e-3));
+		}
+
+		REQUIRE_THROWS_AS(calcSurfaceDistance(glm::ivec2(3, 3), glm::ivec2(3, size), heights, size, size, 30.0f, 11.0f, tin), std::out_of_range);
+		REQUIRE_THROWS_AS(calcSurfaceDistance(glm::ivec2(-1, 3), glm::ivec2(5, 3), heights, size, size, 30.0f, 11.0f, tin), std::out_of_range);
+	}
+
+	SECTION("Tolerance crosses fewer triangles on smooth terrain") {
+		const int size = 257;
+		std::vector<unsigned char> heights(size * size);
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				heights[y * size + x] = static_cast<unsigned char>(std::lround(120.0f + 60.0f * std::sin(x * 0.01f) * std::cos(y * 0.012f)));
+			}
+		}
+
+		SimplifiedTin exact(heights, size, size, 1.0f, 0.0f, pool);
+		SimplifiedTin coarse(heights, size, size, 1.0f, 2.0f, pool);
+		REQUIRE(coarse.getTriangleCount() * 10 < exact.getTriangleCount());
+
+		for (int i = 0; i < 50; ++i) {
+			glm::ivec2 begin{ (i * 37) % size, (i * 11) % 40 };
+			glm::ivec2 end{ (i * 71 + 13) % size, size - 1 - (i * 53) % 40 };
+			float expect = calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 1.0f);
+			REQUIRE(calcSurfaceDistance(begin, end, heights, size, size, 30.0f, 1.0f, coarse) == Approx(expect).epsilon(1e-3));
+			REQUIRE(countCrossedTriangles(begin, end, coarse) * 10 < countCrossedTriangles(begin, end, exact));
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#include "catch.hpp"
+#include "distance.h"
+#include "visibility.h"
+
+
+TEST_CASE("Test line of sight over the surface", "[visibility]") {
+	SECTION("Flat surface is visible") {
+		std::vector<unsigned char> flat(36, 4);
+		VisibilityResult result = calcSurfaceDistanceAndVisibility(glm::ivec2(0, 1), glm::ivec2(5, 4), flat, 6, 6, 2.0f, 1.0f);
+		REQUIRE(result.visible);
+		REQUIRE(result.distance == Approx(glm::length(glm::vec2(5.0f, 3.0f)) * 2.0f));
+		REQUIRE(isVisible(glm::ivec2(0, 1), glm::ivec2(5, 4), flat, 6, 6, 2.0f, 1.0f));
+	}
+
+	SECTION("Ridge blocks the line") {
+		std::vector<unsigned char> ridge(36, 1);
+		for (int y = 0; y < 6; ++y) {
+			ridge[y * 6 + 3] = 9;
+		}
+
+		glm::ivec2 begin{ 0, 2 };
+		glm::ivec2 end{ 5, 2 };
+		VisibilityResult result = calcSurfaceDistanceAndVisibility(begin, end, ridge, 6, 6, 1.0f, 1.0f);
+		REQUIRE(!result.visible);
+		REQUIRE(result.distance == calcSurfaceDistance(begin, end, ridge, 6, 6, 1.0f, 1.0f));
+		// the surface starts to rise towards the ridge right after column 2
+		REQUIRE(result.blockedAt.x >= 2.0f);
+		REQUIRE(result.blockedAt.x < 3.0f);
+		REQUIRE(result.blockedAt.y == Approx(2.0f));
+		REQUIRE(result.blockedPlanarDistance == Approx(result.blockedAt.x));
+
+		// standing on a tower lets the observer see over the ridge
+		REQUIRE(isVisible(begin, end, ridge, 6, 6, 1.0f, 1.0f, 20.0f, 20.0f));
+		REQUIRE(!isVisible(begin, end, ridge, 6, 6, 1.0f, 1.0f, 5.0f, 0.0f));
+	}
+
+	SECTION("Pyramid does not change the answer") {
+		const int size = 33;
+		std::vector<unsigned char> heights(size * size);
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				heights[y * size + x] = static_cast<unsigned char>(20 + ((x * 37 + y * 91 + x * y * 7) % 11) - (x - 16) * (x - 16) / 16);
+			}
+		}
+
+		MaxHeightPyramid pyramid(heights, size, size);
+		REQUIRE(pyramid.getLevelCount() == 6);
+
+		int visibleCount = 0;
+		for (int i = 0; i < 400; ++i) {
+			glm::ivec2 begin{ (i * 7) % size, (i * 13) % size };
+			glm::ivec2 end{ (i * 29 + 5) % size, (i * 3 + 11) % size };
+			float observerHeight = static_cast<float>(i % 4) * 3.0f;
+			bool expectVisible = calcSurfaceDistanceAndVisibility(begin, end, heights, size, size, 1.0f, 1.0f, observerHeight, 1.0f).visible;
+			REQUIRE(isVisible(begin, end, heights, size, size, 1.0f, 1.0f, observerHeight, 1.0f) == expectVisible);
+			REQUIRE(isVisible(begin, end, heights, size, size, 1.0f, 1.0f, observerHeight, 1.0f, &pyramid) == expectVisible);
+			visibleCount += expectVisible ? 1 : 0;
+		}
+
+		REQUIRE(visibleCount > 0);
+		REQUIRE(visibleCount < 400);
+	}
+
+	SECTION("Pyramid jumps over blocks below the sight line") {
+		const int size = 257;
+		std::vector<unsigned char> heights(size * size, 10);
+		heights[150 * size + 40] = 200;
+		MaxHeightPyramid pyramid(heights, size, size);
+
+		const glm::ivec2 lines[][2] = {
+			{ glm::ivec2(0, 3), glm::ivec2(256, 200) },
+			{ glm::ivec2(250, 250), glm::ivec2(5, 20) },
+			{ glm::ivec2(0, 150), glm::ivec2(256, 150) },
+			{ glm::ivec2(200, 256), glm::ivec2(0, 56) }
+		};
+
+		for (const auto& line : lines) {
+			std::size_t allVoxels = 0;
+			std::size_t visitedVoxels = 0;
+			bool expectVisible = isVisible(line[0], line[1], heights, size, size, 1.0f, 1.0f, 2.0f, 2.0f, nullptr, &allVoxels);
+			REQUIRE(isVisible(line[0], line[1], heights, size, size, 1.0f, 1.0f, 2.0f, 2.0f, &pyramid, &visitedVoxels) == expectVisible);
+			REQUIRE(expectVisible == calcSurfaceDistanceAndVisibility(line[0], line[1], heights, size, size, 1.0f, 1.0f, 2.0f, 2.0f).visible);
+			if (expectVisible) {
+				REQUIRE(visitedVoxels * 10 < allVoxels);
+			}
+		}
+
+		// the tower on the third line blocks it
+		REQUIRE_FALSE(isVisible(lines[2][0], lines[2][1], heights, size, size, 1.0f, 1.0f, 2.0f, 2.0f, &pyramid));
+	}
+
+	SECTION("Lines outside of the image") {
+		std::vector<unsigned char> flat(36, 4);
+		REQUIRE_THROWS_AS(isVisible(glm::ivec2(-1, 0), glm::ivec2(5, 4), flat, 6, 6, 2.0f, 1.0f), std::out_of_range);
+		REQUIRE_THROWS_AS(isVisible(glm::ivec2(0, 0), glm::ivec2(6, 4), flat, 6, 6, 2.0f, 1.0f), std::out_of_range);
+		REQUIRE_THROWS_AS(calcSurfaceDistanceAndVisibility(glm::ivec2(0, 6), glm::ivec2(5, 4), flat, 6, 6, 2.0f, 1.0f), std::out_of_range);
+	}
+}